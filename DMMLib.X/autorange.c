@@ -0,0 +1,462 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    autorange.c
+
+  @Description
+        This file groups the functions that implement the AUTORANGE module (automatic scale selection).
+        The auto-ranging is performed among the scales having the same mode (resistance, DC voltage, AC voltage,
+        DC / AC current, DC / AC low current), ordered by range.
+        Each value is checked by AUTORANGE_NextScale, which returns the scale to be selected:
+        - a higher range when the value exceeds the step up percentage of the current range or is overload (+/- INFINITY),
+        - a lower range when the value is below the step down percentage of the next lower range
+          for the configured number of consecutive values.
+        The step up and step down thresholds are separated (hysteresis), so that a value close to a range limit
+        does not make the scales flap.
+        The scale changes minimize the relay transitions, the slowest part of a scale change (see DMM_SetScale):
+        a known value selects directly the lowest range that fits it, instead of stepping one range at a time.
+        On overload the value is unknown: the highest range having the same switches is selected first, and only when 
+        the scale is already the highest range of its switches the highest range of the mode is selected.
+        Like this a ranging sequence performs at most two relay transitions.
+        The number of scale changes, relay transitions and the ranging sequences latency are counted.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, auto-ranging
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "hal.h"
+#include "dmm.h"
+#include "autorange.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int AUTORANGE_GetPos(int idxScale);
+void AUTORANGE_EndRanging();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t DMM_IsNotANumber(double dVal);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int modeAuto = 0;                           // the auto-ranging mode, 0 when auto-ranging is not active
+int rgidxAutoScales[AUTORANGE_MAXSCALES];   // the scales of the mode, from the highest to the lowest range
+int cntAutoScales = 0;
+
+// thresholds, see AUTORANGE_SetThresholds
+uint8_t pctAutoUp = AUTORANGE_PCTUP_DEFAULT;
+uint8_t pctAutoDown = AUTORANGE_PCTDOWN_DEFAULT;
+uint8_t cntAutoDown = AUTORANGE_CNTDOWN_DEFAULT;
+uint8_t cntAutoBelow = 0;                   // consecutive values below the step down threshold
+
+// ranging sequence
+uint8_t fAutoRanging = 0;
+uint32_t tAutoRangingStart = 0;             // HAL_GetTicks value of the first scale change of the sequence
+AUTORANGESTATS autoStats;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	AUTORANGE_Start
+**
+**	Parameters:
+**      int mode        - the auto-ranging mode: DmmResistance, DmmDCVoltage, DmmACVoltage, DmmDCCurrent, DmmACCurrent,
+**                        DmmDCLowCurrent or DmmACLowCurrent
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**          ERRVAL_AUTORANGE_MODE    0xEB    // error, no scale is defined for the mode
+**
+**	Description:
+**		This function starts auto-ranging among the scales of the specified mode.
+**      It builds the list of the mode scales, ordered from the highest to the lowest range,
+**      and selects the highest range, which is safe for any input value.
+**      The ranging sequence state is cleared, the counters are not changed (see AUTORANGE_ResetStats).
+**
+*/
+uint8_t AUTORANGE_Start(int mode)
+{
+    int idxScale, i;
+    uint8_t bErrCode;
+    modeAuto = 0;
+    cntAutoScales = 0;
+    for(idxScale = 0; idxScale < DMM_CNTSCALES && cntAutoScales < AUTORANGE_MAXSCALES; idxScale++)
+    {
+        if(DMM_GetScaleMode(idxScale) != mode)
+        {
+            continue;
+        }
+        // insert, keeping the ranges in descending order
+        for(i = cntAutoScales; i > 0 && DMM_GetScaleRange(rgidxAutoScales[i - 1]) < DMM_GetScaleRange(idxScale); i--)
+        {
+            rgidxAutoScales[i] = rgidxAutoScales[i - 1];
+        }
+        rgidxAutoScales[i] = idxScale;
+        cntAutoScales++;
+    }
+    if(cntAutoScales == 0)
+    {
+        return ERRVAL_AUTORANGE_MODE;
+    }
+    cntAutoBelow = 0;
+    fAutoRanging = 0;
+    bErrCode = DMM_SetScale(rgidxAutoScales[0]);
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        modeAuto = mode;
+    }
+    return bErrCode;
+}
+
+/***	AUTORANGE_Stop
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function stops auto-ranging. The current scale is not changed.
+**      It must be called when a scale is selected by the user.
+**
+*/
+void AUTORANGE_Stop()
+{
+    modeAuto = 0;
+    fAutoRanging = 0;
+}
+
+/***	AUTORANGE_FActive
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint8_t     - 1 if auto-ranging is active, 0 otherwise
+**
+**	Description:
+**		This function checks if auto-ranging was started using AUTORANGE_Start.
+**
+*/
+uint8_t AUTORANGE_FActive()
+{
+    return modeAuto != 0;
+}
+
+/***	AUTORANGE_SetThresholds
+**
+**	Parameters:
+**      uint8_t pctUp       - step up when the value exceeds this percentage of the current range
+**      uint8_t pctDown     - step down when the value is below this percentage of the next lower range
+**      uint8_t cntDown     - the number of consecutive values below the step down threshold needed to step down
+**
+**	Return Value:
+**
+**	Description:
+**		This function sets the auto-ranging thresholds. The defaults are AUTORANGE_PCTUP_DEFAULT,
+**      AUTORANGE_PCTDOWN_DEFAULT and AUTORANGE_CNTDOWN_DEFAULT.
+**      The hysteresis band is between pctDown of the lower range and pctUp of the same range, measured on the lower range.
+**      A value of 0 for cntDown is handled as 1.
+**
+*/
+void AUTORANGE_SetThresholds(uint8_t pctUp, uint8_t pctDown, uint8_t cntDown)
+{
+    pctAutoUp = pctUp;
+    pctAutoDown = pctDown;
+    cntAutoDown = cntDown ? cntDown: 1;
+    cntAutoBelow = 0;
+}
+
+/***	AUTORANGE_NextScale
+**
+**	Parameters:
+**      double dVal     - the measured value
+**      int idxScale    - the scale the value was measured on
+**
+**	Return Value:
+**		int     - the scale index to be selected using AUTORANGE_SetScale
+**              - -1 if the scale must not be changed
+**
+**	Description:
+**		This function checks a measured value against the current range and returns the scale to be selected.
+**      It steps up when the absolute value exceeds the step up percentage of the current range, to the lowest range that fits it.
+**      On overload (+/- INFINITY) the value is unknown, so it steps up to the highest range having the same switches 
+**      when the scale is not already the highest one of its switches, otherwise to the highest range of the mode.
+**      It steps down when the absolute value is below the step down percentage of the next lower range
+**      for the configured number of consecutive values: to the lowest range whose step down threshold exceeds the value.
+**      When no change is needed and no step down is pending, the ranging sequence is completed and its latency is recorded.
+**      Values measured on another scale than the current one (received after a scale change) and not a number values are ignored.
+**      The function returns -1 when auto-ranging is not active.
+**
+*/
+int AUTORANGE_NextScale(double dVal, int idxScale)
+{
+    int pos, i;
+    uint8_t sw;
+    double dAbs;
+    if(!modeAuto || idxScale != DMM_GetCurrentScale())
+    {
+        return -1;
+    }
+    pos = AUTORANGE_GetPos(idxScale);
+    if(pos < 0)
+    {
+        return -1;
+    }
+    if(DMM_IsNotANumber(dVal))
+    {
+        cntAutoBelow = 0;
+        return -1;
+    }
+    autoStats.cntValues++;
+    dAbs = fabs(dVal);
+    if(dAbs > DMM_GetScaleRange(idxScale) * pctAutoUp / 100)
+    {
+        // overload, including +/- INFINITY
+        cntAutoBelow = 0;
+        if(pos == 0)
+        {
+            // the highest range, nothing to do
+            AUTORANGE_EndRanging();
+            return -1;
+        }
+        if(dAbs != INFINITY)
+        {
+            // the value is known, the lowest range that fits it
+            for(i = pos - 1; i > 0 && dAbs > DMM_GetScaleRange(rgidxAutoScales[i]) * pctAutoUp / 100; i--);
+            return rgidxAutoScales[i];
+        }
+        // the highest range having the same switches, otherwise the highest range
+        sw = DMM_GetScaleSwitches(idxScale);
+        for(i = 0; i < pos && DMM_GetScaleSwitches(rgidxAutoScales[i]) != sw; i++);
+        return rgidxAutoScales[(i < pos) ? i: 0];
+    }
+    if(pos < cntAutoScales - 1 && dAbs < DMM_GetScaleRange(rgidxAutoScales[pos + 1]) * pctAutoDown / 100)
+    {
+        if(++cntAutoBelow < cntAutoDown)
+        {
+            // wait for confirmation
+            return -1;
+        }
+        cntAutoBelow = 0;
+        // the lowest range that fits the value
+        for(i = cntAutoScales - 1; i > pos + 1 && dAbs >= DMM_GetScaleRange(rgidxAutoScales[i]) * pctAutoDown / 100; i--);
+        return rgidxAutoScales[i];
+    }
+    cntAutoBelow = 0;
+    AUTORANGE_EndRanging();
+    return -1;
+}
+
+/***	AUTORANGE_SetScale
+**
+**	Parameters:
+**      int idxScale    - the scale index returned by AUTORANGE_NextScale
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong scale index
+**          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**
+**	Description:
+**		This function selects the scale returned by AUTORANGE_NextScale, using DMM_SetScale.
+**      The first scale change starts a ranging sequence. The scale changes and the relay transitions are counted.
+**      The values measured before the change must be dropped by the caller.
+**
+*/
+uint8_t AUTORANGE_SetScale(int idxScale)
+{
+    int idxPrev = DMM_GetCurrentScale();
+    if(!fAutoRanging)
+    {
+        fAutoRanging = 1;
+        tAutoRangingStart = HAL_GetTicks();
+    }
+    cntAutoBelow = 0;
+    autoStats.cntRangeChanges++;
+    if(idxPrev < 0 || DMM_GetScaleSwitches(idxPrev) != DMM_GetScaleSwitches(idxScale))
+    {
+        autoStats.cntRelayChanges++;
+    }
+    return DMM_SetScale(idxScale);
+}
+
+/***	AUTORANGE_DGetValue
+**
+**	Parameters:
+**      uint8_t *pbErr      - Pointer to the error parameter, the error code is set here
+**
+**	Return Value:
+**		double      - the measured value, on the range selected by auto-ranging
+**                  - +/- INFINITY if the value exceeds the highest range
+**
+**	Description:
+**		This function retrieves values using DMM_DGetValue and changes the scale as returned by AUTORANGE_NextScale,
+**      until a value needs no scale change (at most AUTORANGE_MAXSTEPS scale changes). It returns this value.
+**      When auto-ranging is not active it returns the DMM_DGetValue value.
+**      The error codes are the DMM_DGetValue and DMM_SetScale ones.
+**
+*/
+double AUTORANGE_DGetValue(uint8_t *pbErr)
+{
+    int cntSteps = 0, idxNext;
+    double dVal;
+    uint8_t bErrCode;
+    while(1)
+    {
+        dVal = DMM_DGetValue(&bErrCode);
+        if(bErrCode != ERRVAL_SUCCESS)
+        {
+            break;
+        }
+        idxNext = AUTORANGE_NextScale(dVal, DMM_GetCurrentScale());
+        if(idxNext < 0)
+        {
+            if(cntAutoBelow == 0)
+            {
+                break;
+            }
+            continue;   // step down pending confirmation
+        }
+        if(cntSteps++ >= AUTORANGE_MAXSTEPS)
+        {
+            break;
+        }
+        bErrCode = AUTORANGE_SetScale(idxNext);
+        if(bErrCode != ERRVAL_SUCCESS)
+        {
+            dVal = NAN;
+            break;
+        }
+    }
+    if(pbErr)
+    {
+        *pbErr = bErrCode;
+    }
+    return dVal;
+}
+
+/***	AUTORANGE_GetStats
+**
+**	Parameters:
+**      AUTORANGESTATS *pStats  - the structure receiving the counters
+**
+**	Return Value:
+**
+**	Description:
+**		This function provides the auto-ranging counters: checked values, scale changes, relay transitions,
+**      completed ranging sequences and their last / maximum latency.
+**      The latency of a ranging sequence is the time from its first scale change until a value needing no scale change
+**      was checked.
+**
+*/
+void AUTORANGE_GetStats(AUTORANGESTATS *pStats)
+{
+    *pStats = autoStats;
+}
+
+/***	AUTORANGE_ResetStats
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function clears the auto-ranging counters.
+**
+*/
+void AUTORANGE_ResetStats()
+{
+    memset(&autoStats, 0, sizeof(autoStats));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	AUTORANGE_GetPos
+**
+**	Parameters:
+**      int idxScale    - the scale index
+**
+**	Return Value:
+**		int     - the position of the scale in the auto-ranging scales list, 0 being the highest range
+**              - -1 if the scale does not belong to the auto-ranging mode
+**
+**	Description:
+**		This function searches the scale in the auto-ranging scales list.
+**
+*/
+int AUTORANGE_GetPos(int idxScale)
+{
+    int pos;
+    for(pos = 0; pos < cntAutoScales; pos++)
+    {
+        if(rgidxAutoScales[pos] == idxScale)
+        {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+/***	AUTORANGE_EndRanging
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function completes the current ranging sequence, if any, and records its latency.
+**
+*/
+void AUTORANGE_EndRanging()
+{
+    uint32_t tusLatency;
+    if(!fAutoRanging)
+    {
+        return;
+    }
+    fAutoRanging = 0;
+    tusLatency = (HAL_GetTicks() - tAutoRangingStart) / (HAL_TICKS_FRQ / 1000000);
+    autoStats.cntRangings++;
+    autoStats.tusLastLatency = tusLatency;
+    if(tusLatency > autoStats.tusMaxLatency)
+    {
+        autoStats.tusMaxLatency = tusLatency;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
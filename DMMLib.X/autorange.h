@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    autorange.h
+
+  @Description
+        This file contains the declaration for the functions of the AUTORANGE module (automatic scale selection).
+        The AUTORANGE functions are defined in autorange.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, auto-ranging
+
+ */
+/* ************************************************************************** */
+
+#ifndef _AUTORANGE_H    /* Guard against multiple inclusion */
+#define _AUTORANGE_H
+
+#include "stdint.h"
+#include "dmm.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define AUTORANGE_MAXSCALES         8       // maximum number of scales of a mode
+#define AUTORANGE_MAXSTEPS          8       // maximum number of scale changes performed by AUTORANGE_DGetValue
+
+// default thresholds, see AUTORANGE_SetThresholds
+#define AUTORANGE_PCTUP_DEFAULT     110     // step up above this percentage of the current range (or on overload)
+#define AUTORANGE_PCTDOWN_DEFAULT   90      // step down below this percentage of the lower range
+#define AUTORANGE_CNTDOWN_DEFAULT   2       // number of consecutive values below the step down threshold
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// auto-ranging counters, see AUTORANGE_GetStats
+typedef struct _AUTORANGESTATS{
+    uint32_t cntValues;         // values checked by AUTORANGE_NextScale
+    uint32_t cntRangeChanges;   // scale changes
+    uint32_t cntRelayChanges;   // scale changes that switched the relays
+    uint32_t cntRangings;       // completed ranging sequences (one or more scale changes until an in range value)
+    uint32_t tusLastLatency;    // duration of the last ranging sequence, us
+    uint32_t tusMaxLatency;     // maximum duration of a ranging sequence, us
+} AUTORANGESTATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t AUTORANGE_Start(int mode);
+void AUTORANGE_Stop();
+uint8_t AUTORANGE_FActive();
+void AUTORANGE_SetThresholds(uint8_t pctUp, uint8_t pctDown, uint8_t cntDown);
+int AUTORANGE_NextScale(double dVal, int idxScale);
+uint8_t AUTORANGE_SetScale(int idxScale);
+double AUTORANGE_DGetValue(uint8_t *pbErr);
+void AUTORANGE_GetStats(AUTORANGESTATS *pStats);
+void AUTORANGE_ResetStats();
+
+#endif /* _AUTORANGE_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -36,8 +36,8 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
+#include <stdio.h>
+#include <string.h>
 #include "dmm.h"
 #include "eprom.h"
 #include "uart.h"
@@ -77,6 +77,8 @@ uint8_t DMM_FDiodeScale(int idxScale);
 uint8_t DMM_FContinuityScale(int idxScale);
 // errors 
 uint8_t DMM_ERR_CheckIdxCalib(int idxScale);
+// conversion coefficients cache
+void DMM_InvalidateConvCache();
 // utils
 uint8_t DMM_IsNotANumber(double dVal);
 
@@ -185,7 +187,9 @@ uint8_t CALIB_WriteAllCalibsToEPROM_User()
 */
 uint8_t CALIB_ReadAllCalibsFromEPROM_User()
 {
-    return CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_CALIB);
+    uint8_t bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_CALIB);
+    DMM_InvalidateConvCache();
+    return bResult;
 }
 
 
@@ -210,7 +214,9 @@ uint8_t CALIB_ReadAllCalibsFromEPROM_User()
 */
 uint8_t CALIB_ReadAllCalibsFromEPROM_Factory()
 {
-    return CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_FACTCALIB);
+    uint8_t bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_FACTCALIB);
+    DMM_InvalidateConvCache();
+    return bResult;
 }
 
 /***	CALIB_RestoreAllCalibsFromEPROM_Factory
@@ -808,6 +814,7 @@ uint8_t CALIB_ImportCalibCoefficients(int idxScale, float fMult, float fAdd)
     {
         calib.Dmm[idxScale].Mult = fMult;
         calib.Dmm[idxScale].Add = fAdd;
+        DMM_InvalidateConvCache();
         partCalib.DmmPartCalib[idxScale].fCalibDirty = 1;   // needs to be written to EPROM  
     }
     return bResult;
@@ -1137,6 +1144,7 @@ uint8_t CALIB_CheckCompleteCalib()
         {
             calib.Dmm[idxScale].Mult = CALIB_ComputeMult(idxScale);            
             calib.Dmm[idxScale].Add = CALIB_ComputeAdd(idxScale);
+            DMM_InvalidateConvCache();
             partCalib.DmmPartCalib[idxScale].fCalibDirty = 1;   // needs to be written to EPROM
             // fill information text
             sprintf(ERRORS_GetszLastError(), "Coeff: %.6f, %.6f", calib.Dmm[idxScale].Mult, calib.Dmm[idxScale].Add);            
@@ -35,8 +35,9 @@
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 #include "stdint.h"
 #include "math.h"
 #include "dmm.h"
@@ -44,6 +45,7 @@
 #include "spi.h"
 #include "errors.h"
 #include "utils.h"
+#include "hal.h"
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Local Functions Prototypes                                        */
@@ -52,12 +54,32 @@
 // DMM Switches function
 void DMM_ConfigSwitches(uint8_t sw);
 
+// configuration write, see DMM_SetScale
+uint8_t DMM_WriteCfgFull(int idxScale, const DMMSETTLE *pSettle);
+uint8_t DMM_WriteCfgDiff(int idxScale, const DMMSETTLE *pSettle);
+const DMMSETTLE *DMM_GetSettle(uint8_t swFrom, uint8_t swTo, int mode);
+void DMM_FlushConversion(uint8_t fAC);
+void DMM_WaitSettled(int idxScale, uint32_t dlyMax);
+
 // DMM SPI functions
 void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData);
 void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData);
 
 // retrieve value from DMM
 double DMM_DGetStatus(uint8_t *pbErr);
+double DMM_DGetStatusPolled(uint8_t *pbErr);
+uint8_t DMM_FGetCode(uint8_t fAC, int64_t *pCode);
+
+// conversion coefficients cache
+DMMCONV *DMM_GetConv(uint8_t *pbErr);
+void DMM_BuildConvCache();
+void DMM_InvalidateConvCache();
+
+// fixed point conversion
+uint8_t DMM_FixCompute(DMMFIX *pFix, uint8_t fCalib);
+uint8_t DMM_FixQ31(double dVal, int32_t *pMant);
+uint32_t DMM_RmsSqrtQ11(int64_t code, int64_t rmsOffset);
+void DMM_ReadStatusDone();
 
 // value format
 uint8_t DMM_GetScaleUnit(int idxScale, double *pdScaleFact, char *szUnitPrefix, char *szUnit);
@@ -115,9 +137,55 @@ const static DMMCFG dmmcfg[] = {
 {DmmACLowCurrent, 5e-4,  4, {0x00, 0x52, 0xDD, 0x07, 0x03, 0x00, 0x13, 0x80, 0x25, 0x11, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x90, 0x80, 0xC7, 0x3D, 0x28, 0x00, 0x00, 0x00}, 1e-8/1.08             , CALIB_ACCEPTANCE_DEFAULT, CALIB_ACCEPTANCE_DEFAULT}, //26 "500 uA AC" 
 {0}};
 
+// settling delays applied by DMM_SetScale, the first matching entry is used, see DMM_GetSettle
+const static DMMSETTLE rgSettle[] = {
+//  swFrom,             swTo,               mode,               dlyDrop,                dlyRelay,           dlyAnalog
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmResistance,      0,                      0,                  DMM_SETTLE_ANALOG_RES},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmContinuity,      0,                      0,                  DMM_SETTLE_ANALOG_RES},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmDiode,           0,                      0,                  DMM_SETTLE_ANALOG_RES},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmACVoltage,       0,                      0,                  DMM_SETTLE_ANALOG_AC},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmACCurrent,       0,                      0,                  DMM_SETTLE_ANALOG_AC},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DmmACLowCurrent,    0,                      0,                  DMM_SETTLE_ANALOG_AC},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_SAMESW,  DMM_SETTLE_ANYMODE, 0,                      0,                  DMM_SETTLE_ANALOG_DC},
+    {DMM_SETTLE_ANYSW,  DMM_SETTLE_ANYSW,   DMM_SETTLE_ANYMODE, DMM_SETTLE_RELAYDROP,   DMM_SETTLE_RELAY,   DMM_SETTLE_ANALOG},
+};
+
+// DMM_ISqrt64 seeds: 1 / sqrt((k + 0.5) / 32) for k = 8 ... 31, Q30
+const static uint32_t rgISqrtSeed[] = {
+    0x7C2DA123, 0x7575FAA4, 0x6FBA415C, 0x6AC266BA, 0x66666666, 0x6288D173, 0x5F137599, 0x5BF539E5, 
+    0x5920B4DF, 0x568B3632, 0x542C1AA4, 0x51FC5140, 0x4FF601E0, 0x4E144AE9, 0x4C530F65, 0x4AAED0F0, 
+    0x49249249, 0x47B1C049, 0x46541FB4, 0x4509BEB0, 0x43D0E917, 0x42A81EF6, 0x418E0CC8, 0x40818512};
+
 int idxCurrentScale = -1;   // stores the current selected scale
 char fUseCalib = 1;         // controls if calibration coefficients should be applied in DMM_DGetStatus
 
+// conversion coefficients cache of the current scale, see DMM_GetConv
+DMMCONV rgConvCache[2];             // index 0: without calibration coefficients, 1: with calibration coefficients
+uint8_t fConvCacheValid = 0;
+double dConvScaleFact;              // the current scale unit data, see DMM_GetScaleUnit
+char szConvUnitPrefix[2], szConvUnit[5];
+
+// configuration shadow, the last configuration applied by DMM_SetScale
+uint8_t rgCfgShadow[DMM_CFG_CNTREGS];
+uint8_t swShadow;
+uint8_t fCfgShadowValid = 0;
+uint32_t cbCfgXfer = 0;     // SPI bytes transferred by DMM_SetScale, see DMM_GetCfgBytes
+uint32_t cbDmmSpi = 0;      // SPI bytes transferred by DMM_SendCmdSPI and DMM_GetCmdSPI
+
+// settle detection, see DMM_SetSettleDetect
+uint8_t fSettleDetect = 1;
+uint32_t rgSettleBand[DMM_CNTSCALES];   // noise band of each scale, 0 for the default DMM_SETTLE_BAND
+uint32_t tusSettle = 0;                 // settle time of the last DMM_SetScale call
+uint8_t fSettleDetected = 0;            // the last settle was detected, otherwise the maximum wait elapsed
+
+// ready polling, see DMM_SetPollMode
+uint8_t bPollMode = DMM_POLL_INTF;
+uint32_t cbPollSaved = 0;   // SPI bytes saved by DMM_POLL_INTF mode, compared to DMM_POLL_FULLSTATUS mode
+
+// status burst read, see DMM_StartReadStatus
+volatile uint8_t fReadStatusBusy = 0;
+void (*pfnReadStatusDone)() = NULL;
+
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -143,6 +211,7 @@ char fUseCalib = 1;         // controls if calibration coefficients should be ap
 void DMM_Init()
 {
     SPI_Init();
+    DMM_InvalidateCfgShadow();
 }
 
 /***	DMM_SetScale
@@ -160,8 +229,17 @@ void DMM_Init()
 **      According to this scale, it uses data defined in dmmcfg structure to configure the switches and 
 **      to set the value of the registers (24 registers starting at 0x1F address).
 **      It also verifies the configuration setting success status by reading the values of these registers.
+**      The last applied configuration is kept in a shadow copy. When the shadow is valid and the new scale uses the same switches, 
+**      only the registers that differ (according to dmmcfgmask) are written and verified, without reset and switches drop 
+**      (see DMM_WriteCfgDiff). Otherwise the DMM is reset and the whole configuration is written (see DMM_WriteCfgFull). 
+**      The delays (switches drop, relays settling and analog settling) are taken from the settling table, according to the switches 
+**      transition and the mode of the new scale (see DMM_GetSettle): changing only the converter configuration waits much less 
+**      than changing the relays.
+**      By default the settling is detected on the converter codes and the table delays are only the maximum wait 
+**      (see DMM_SetSettleDetect and DMM_WaitSettled). The settle time is provided by DMM_GetSettleTime.
+**      The full sequence can be forced for the next call using DMM_InvalidateCfgShadow.
 **      It returns ERRVAL_SUCCESS if the operation is successful.
-**      It returns ERRVAL_DMM_CFGVERIFY if verifying fails.
+**      It returns ERRVAL_DMM_CFGVERIFY if verifying fails. In this case the shadow is invalidated, so that the next call performs the full sequence.
 **      It returns ERRVAL_DMM_IDXCONFIG if the scale index is not valid.
 **            
 */
@@ -173,62 +251,161 @@ uint8_t DMM_SetScale(int idxScale)
     {
         return bResult;
     }
-    const int cbCfg = 24;
-    uint8_t rgIn[24];
-    
-    // 2. Reset the DMM by writing 0x60 on 0x37 register
-    uint8_t valReset = 0x60;
-    // Build command:
-    //  MSB: 7 bits address: 0x37
-    //  LSB: 0 for write
-    uint8_t bCmd = 0x37 << 1;
-    
-    // Write 1 bytes, starting with 0x37 address
-    DMM_SendCmdSPI(bCmd, 1, &valReset);    
-    
-    // 3. Set the switches
-    
-    // clear switches
-    DMM_ConfigSwitches(0); 
-    DelayAprox10Us(100);    
-    DMM_ConfigSwitches(dmmcfg[idxScale].sw); 
-    
-    // 4. Set the value for the 24 registers starting with 0x1f
-    // Build command:
-    //  MSB: 7 bits address: 0x1F
-    //  LSB: 0 for write
-    bCmd = 0x1F << 1;
-    
-    // Write 24 bytes, starting with 0x1F address, values taken from dmmcfg[idxScale].cfg array
-    DMM_SendCmdSPI(bCmd, cbCfg, (uint8_t *)dmmcfg[idxScale].cfg);
 
-    // 5. Verify the values of the 24 registers starting with 0x1f
-    
-    // Build command:
-    //  MSB: 7 bits address: 0x1F
-    //  LSB: 1 for read
-    bCmd =(0x1F<<1) | 1;    
-    DelayAprox10Us(500);     
+    // 2. Write the configuration, using the settling delays of the transition
+    uint32_t cbStart = cbDmmSpi;
+    tusSettle = 0;
+    fSettleDetected = 0;
+    const DMMSETTLE *pSettle = DMM_GetSettle(fCfgShadowValid ? swShadow: DMM_SETTLE_ANYSW, dmmcfg[idxScale].sw, dmmcfg[idxScale].mode);
+    if(fCfgShadowValid && (swShadow == dmmcfg[idxScale].sw))
+    {
+        bResult = DMM_WriteCfgDiff(idxScale, pSettle);
+    }
+    else
+    {
+        bResult = DMM_WriteCfgFull(idxScale, pSettle);
+    }
+    cbCfgXfer += cbDmmSpi - cbStart;
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        fCfgShadowValid = 0;
+        return bResult;
+    }
 
-    // 5.1. Read 24 bytes, starting with 0x1F address, values placed in rgIn array
-    DMM_GetCmdSPI(bCmd, cbCfg, rgIn);
-    DelayAprox10Us(1000);     
+    // 3. Update the shadow
+    memcpy(rgCfgShadow, dmmcfg[idxScale].cfg, DMM_CFG_CNTREGS);
+    swShadow = dmmcfg[idxScale].sw;
+    fCfgShadowValid = 1;
 
-    // 5.2. Compare values from rgIn and dmmcfg[idxScale].cfg arrays
-     int i;
-     for(i = 0; i < cbCfg; i++){
-         if((rgIn[i]&dmmcfgmask[i])!=(dmmcfgmask[i]&dmmcfg[idxScale].cfg[i]))
-         {
-            // DMM scale configuration verify failed;
-             return ERRVAL_DMM_CFGVERIFY;
-         }
-     }
-     
-     // 6. Set idxScale as current scale 
+    // 4. Set idxScale as current scale 
     idxCurrentScale = idxScale;
+    DMM_InvalidateConvCache();
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMM_InvalidateCfgShadow
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function invalidates the shadow copy of the configuration, so that the next DMM_SetScale call 
+**      resets the DMM, drops the switches and writes the whole configuration, even for the current scale.
+**      It must be called when the DMM configuration registers may have been changed outside DMM_SetScale 
+**      (for example after a DMM power cycle).
+**            
+*/
+void DMM_InvalidateCfgShadow()
+{
+    fCfgShadowValid = 0;
+}
+
+/***	DMM_GetCfgBytes
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint32_t    - the number of SPI bytes transferred by DMM_SetScale
+**
+**	Description:
+**		This function returns the number of SPI bytes (command and data bytes) that DMM_SetScale transferred 
+**      since the last call of DMM_ResetCfgBytes: the reset, configuration and verify bytes, 
+**      and the codes read by the settle detection and by the conversion flush (see DMM_WaitSettled). 
+**      The saving of the incremental scale switching is the difference between the counts of the same scale sequence 
+**      performed with the full sequence (see DMM_InvalidateCfgShadow) and with the incremental one.
+**            
+*/
+uint32_t DMM_GetCfgBytes()
+{
+    return cbCfgXfer;
+}
+
+/***	DMM_ResetCfgBytes
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function clears the counter returned by DMM_GetCfgBytes.
+**            
+*/
+void DMM_ResetCfgBytes()
+{
+    cbCfgXfer = 0;
+}
+
+/***	DMM_SetSettleDetect
+**
+**	Parameters:
+**      uint8_t f       - 1 to detect the settling on the converter codes (default), 0 to wait the fixed settling table delays
+**
+**	Return Value:
+**
+**	Description:
+**		This function selects how DMM_SetScale waits for the new scale to settle. 
+**      When the detection is enabled, after the configuration is written and verified the AD1 codes are watched 
+**      until they stay within the noise band of the scale (see DMM_SetSettleBand and DMM_WaitSettled), the settling table delays 
+**      being only the maximum wait. Otherwise, and for the AC scales, the settling table delays are always waited.
+**            
+*/
+void DMM_SetSettleDetect(uint8_t f)
+{
+    fSettleDetect = f;
+}
+
+/***	DMM_SetSettleBand
+**
+**	Parameters:
+**      int idxScale        - the scale index
+**      uint32_t band       - the noise band, in AD1 codes, 0 for the default
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong scale index
+**
+**	Description:
+**		This function sets the noise band used by the settle detection on the specified scale: the scale is settled when 
+**      the codes stay within the band around a reference code during the drift window (see DMM_WaitSettled). 
+**      The band must exceed the code noise of the scale, otherwise the detection times out and the maximum wait is used.
+**      The default band is DMM_SETTLE_BAND. The AC scales do not use the settle detection.
+**            
+*/
+uint8_t DMM_SetSettleBand(int idxScale, uint32_t band)
+{
+    if(idxScale < 0 || idxScale >= DMM_CNTSCALES)
+    {
+        return ERRVAL_DMM_IDXCONFIG;
+    }
+    rgSettleBand[idxScale] = band;
     return ERRVAL_SUCCESS;
 }
 
+/***	DMM_GetSettleTime
+**
+**	Parameters:
+**      uint8_t *pfDetected     - if not NULL, receives 1 if the settling was detected, 0 if the maximum wait elapsed 
+**                                or the settle detection is disabled
+**
+**	Return Value:
+**		uint32_t    - the settle time of the last DMM_SetScale call, us
+**
+**	Description:
+**		This function returns the time waited by the last DMM_SetScale call for the scale to settle, 
+**      from the configuration verify until the samples were released. It is 0 when no register was changed.
+**            
+*/
+uint32_t DMM_GetSettleTime(uint8_t *pfDetected)
+{
+    if(pfDetected)
+    {
+        *pfDetected = fSettleDetected;
+    }
+    return tusSettle;
+}
+
 /***	DMM_ERR_CheckIdxCalib
 **
 **	Parameters:
@@ -266,11 +443,12 @@ uint8_t DMM_ERR_CheckIdxCalib(int idxScale)
 **          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
 **	Description:
 **		This function repeatedly retrieves the value from the convertor / RMS registers 
-**      by calling private private function DMM_DGetStatus, until a valid value is detected.
+**      by calling private private function DMM_DGetStatus (or DMM_DGetStatusPolled, according to DMM_SetPollMode), 
+**      until a valid value is detected.
 **      It returns INFINITY when measured values are outside the expected convertor range.
 **      If there is no valid current scale selected, the function sets the error value to ERRVAL_DMM_IDXCONFIG and NAN value is returned. 
 **      If there is no valid value retrieved within a specific timeout period, the error is set to ERRVAL_DMM_VALIDDATATIMEOUT.
-**		This function compensates the not linear behavior of VoltageDC50 scale.
+**		The not linear behavior of VoltageDC50 scale is compensated by DMM_DStatusToValue.
 **      When no error is detected, the error is set to ERRVAL_SUCCESS.
 **      The error is copied in the byte pointed by pbErr, if pbErr is not null.
 **            
@@ -283,17 +461,12 @@ double DMM_DGetValue(uint8_t *pbErr)
     
     double dVal;
     // wait until a valid value is retrieved or the timeout counter exceeds threshold
-    while(DMM_IsNotANumber(dVal = DMM_DGetStatus(&bErr)) && (cntTimeout++ < DMM_VALIDDATA_CNTTIMEOUT) && (bErr == ERRVAL_SUCCESS));
+    while(DMM_IsNotANumber(dVal = ((bPollMode == DMM_POLL_INTF) ? DMM_DGetStatusPolled(&bErr): DMM_DGetStatus(&bErr))) && (cntTimeout++ < DMM_VALIDDATA_CNTTIMEOUT) && (bErr == ERRVAL_SUCCESS));
     // detect timeout 
     if((bErr == ERRVAL_SUCCESS) && (cntTimeout >=  DMM_VALIDDATA_CNTTIMEOUT))
     {
         bErr = ERRVAL_DMM_VALIDDATATIMEOUT;
     }
-    if(bErr == ERRVAL_SUCCESS && DMM_GetCurrentScale() == DMMVoltageDC50Scale)
-    {
-        // compensate the not linear scale behavior
-        dVal = DMM_CompensateVoltage50DCLinear(dVal);
-    }
     
     // set error
     if(pbErr)
@@ -321,6 +494,7 @@ double DMM_DGetValue(uint8_t *pbErr)
 **      returned by DMM_DGetValue, for the specified number of samples. 
 **      The function uses Arithmetic mean average value method for all but AC scales, 
 **      and RMS (Quadratic mean) Average value method for for AC scales.
+**      The values are accumulated by DMM_AcquireStats, the average stops at the first value outside the convertor range (DMMSTATS_POLICY_STOP).
 **      If there is no valid current scale selected, the error is set to ERRVAL_DMM_IDXCONFIG. 
 **      If there is no valid value retrieved within a specific timeout period, the error is set to ERRVAL_DMM_VALIDDATATIMEOUT.
 **      It returns INFINITY when measured values are outside the expected convertor range.
@@ -331,52 +505,24 @@ double DMM_DGetValue(uint8_t *pbErr)
 */
 double DMM_DGetAvgValue(int cbSamples, uint8_t *pbErr)
 {
-    uint8_t fValid = 1;
-    double dValAvg = 0.0, dVal;
-    int i;
-    int idxScale = DMM_GetCurrentScale();
-	uint8_t bErr  = DMM_ERR_CheckIdxCalib(idxScale);    
-    uint8_t fAC;
+    double dValAvg = 0.0;
+    DMMSTATS stats;
+    uint8_t bErr;
+    DMMSTATS_Init(&stats, DMMSTATS_POLICY_STOP);
+    bErr = DMM_AcquireStats(cbSamples, &stats);
     if(bErr == ERRVAL_SUCCESS)
     {
-        fAC = DMM_FACScale(idxScale);
-        if(fAC)
+        if(stats.fStopped)
         {
-            // use RMS (Quadratic mean) Average value for AC
-            for(i = 0; (i < cbSamples) && fValid; i++)
-            {
-                dVal = DMM_DGetValue(&bErr);
-                fValid = (bErr == ERRVAL_SUCCESS) && (dVal != INFINITY) && (dVal != -INFINITY )&& !DMM_IsNotANumber(dVal);
-                if(fValid)
-                {
-                    dValAvg += pow(dVal, 2);
-                }
-            }
-            if(fValid && cbSamples)
-            {
-                dValAvg /= cbSamples;                
-                dValAvg = sqrt(dValAvg);
-            }            
+            dValAvg = stats.dExcluded;  // value outside convertor range
         }
-        else
+        else if(stats.cntValues)
         {
-            // use normal (Arithmetic mean) Average value for other that AC.
-            for(i = 0; (i < cbSamples) && fValid; i++)
-            {
-                dVal = DMM_DGetValue(&bErr);
-                fValid = (bErr == ERRVAL_SUCCESS) && (dVal != INFINITY) && (dVal != -INFINITY )&& !DMM_IsNotANumber(dVal);
-                if(fValid)
-                {
-                    dValAvg += dVal;
-                }
-            }
-            if(fValid && cbSamples)
-            {
-                dValAvg /= cbSamples;                
-            }
+            // RMS (Quadratic mean) Average value for AC, normal (Arithmetic mean) Average value for other that AC
+            dValAvg = DMM_FACScale(idxCurrentScale) ? DMMSTATS_DGetRMS(&stats): DMMSTATS_DGetMean(&stats);
         }
     }
-    if(bErr != ERRVAL_SUCCESS)
+    else
     {
         dValAvg = NAN;
     }
@@ -387,89 +533,820 @@ double DMM_DGetAvgValue(int cbSamples, uint8_t *pbErr)
     return dValAvg;
 }
 
-
-/***	DMM_GetCurrentScale
+/***	DMM_AcquireStats
 **
 **	Parameters:
-**      none
+**      int cntValues           - The number of values to be acquired
+**      DMMSTATS *pStats        - The statistics updated with the values, initialized by the caller using DMMSTATS_Init
 **
 **	Return Value:
-**		int     - current scale index
-**              - -1 if no current scale was selected
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
 **
 **	Description:
-**		This function returns the current scale index. 
-**      This is the last scale index selected using the DMM_SetScale function.
-**      In case no current scale was selected, the function returns -1.
+**		This function acquires cntValues DMM values using DMM_DGetValue and adds them to the statistics, in a single pass and 
+**      without buffering the values: count, mean, variance, minimum, maximum and RMS are available when it returns.
+**      The values outside the convertor range are handled according to the statistics policy: 
+**      with DMMSTATS_POLICY_STOP the acquisition ends at the first of them, with DMMSTATS_POLICY_SKIP they are counted and excluded.
+**      The statistics are not cleared, so that consecutive calls accumulate on the same statistics.
+**      If there is no valid current scale selected, the function returns ERRVAL_DMM_IDXCONFIG. 
+**      If there is no valid value retrieved within a specific timeout period, the function returns ERRVAL_DMM_VALIDDATATIMEOUT.
 **            
 */
-int DMM_GetCurrentScale()
+uint8_t DMM_AcquireStats(int cntValues, DMMSTATS *pStats)
 {
-    return idxCurrentScale;
+    int i;
+    double dVal;
+    uint8_t bErr = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    for(i = 0; (i < cntValues) && (bErr == ERRVAL_SUCCESS); i++)
+    {
+        dVal = DMM_DGetValue(&bErr);
+        if((bErr == ERRVAL_SUCCESS) && !DMMSTATS_Add(pStats, dVal))
+        {
+            break;
+        }
+    }
+    return bErr;
 }
 
-/***	DMM_GetCurrentScale
+/***	DMM_GetSamples
 **
 **	Parameters:
-**      none
+**      int64_t *pCodes     - array receiving the raw codes, at least cntSamples elements
+**      int cntSamples      - the number of codes to be captured
 **
 **	Return Value:
-**		int     - current scale index
-**              - -1 if no current scale was selected
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
 **
 **	Description:
-**		This function returns the current scale index. 
-**      This is the last scale index selected using the DMM_SetScale function.
-**      In case no current scale was selected, the function returns -1.
+**		This function captures cntSamples raw codes of the current scale, each from a new conversion, as fast as the converter delivers them: 
+**      the 40 bits RMS register for AC scales, the AD1 signed code for the other scales.
+**      Only the INTF register is polled until the conversion is done, then only the data registers are read. 
+**      When built with DMM_INTF_READCLEAR, reading INTF clears the conversion done flags, so each flag edge is a new conversion. 
+**      Otherwise the flags stay set and the data registers always hold the last conversion: as in DMM_FlushConversion, 
+**      a new conversion is detected when the code differs from the previous one (the first code is compared to the code 
+**      held when the function is called), so that no conversion is captured twice. A conversion giving the same code 
+**      as the previous one cannot be told from it and is skipped. If the code does not change within DMM_FLUSH_TIMEOUT 
+**      (steady input without noise, or input outside the convertor range), several conversions were performed meanwhile, 
+**      so the unchanged code is captured as a new conversion, as in DMM_FlushConversion.
+**      In both cases the codes are consecutive conversions only if reading a code takes less than the conversion period.
+**      No floating point computation is performed during the capture, the codes are converted afterwards using DMM_CodesToValues.
+**      If there is no valid code retrieved within a specific timeout period, the function returns ERRVAL_DMM_VALIDDATATIMEOUT.
 **            
 */
-double DMM_GetScaleRange(int idxScale)
+uint8_t DMM_GetSamples(int64_t *pCodes, int cntSamples)
 {
-    double range = dmmcfg[idxScale].range;
-    return range;
+    int i;
+    unsigned int cntTimeout;
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    uint8_t fAC = DMM_FACScale(idxCurrentScale);
+#if !DMM_INTF_READCLEAR
+    uint32_t tStart;
+    int64_t codePrev;
+    // the code held now may have been read already, it is the reference of the first code
+    cntTimeout = 0;
+    while(!DMM_FGetCode(fAC, &codePrev))
+    {
+        if(++cntTimeout >= DMM_VALIDDATA_CNTTIMEOUT)
+        {
+            return ERRVAL_DMM_VALIDDATATIMEOUT;
+        }
+    }
+#endif
+    for(i = 0; i < cntSamples; i++)
+    {
+        cntTimeout = 0;
+        while(!DMM_FGetCode(fAC, &pCodes[i]))
+        {
+            if(++cntTimeout >= DMM_VALIDDATA_CNTTIMEOUT)
+            {
+                return ERRVAL_DMM_VALIDDATATIMEOUT;
+            }
+        }
+#if !DMM_INTF_READCLEAR
+        // wait for the code of a new conversion, an unchanged code is taken after DMM_FLUSH_TIMEOUT
+        tStart = HAL_GetTicks();
+        while(pCodes[i] == codePrev && (HAL_GetTicks() - tStart) < DMM_FLUSH_TIMEOUT * (HAL_TICKS_FRQ / 100000))
+        {
+            DMM_FGetCode(fAC, &pCodes[i]);
+        }
+        codePrev = pCodes[i];
+#endif
+    }
+    return ERRVAL_SUCCESS;
 }
-/***	DMM_SetUseCalib
+
+/***	DMM_CodesToValues
 **
 **	Parameters:
-**      uint8_t f  
-**              1 if calibrations coefficients should be applied in future DMM_DGetStatus calls
-**              0 if calibrations coefficients should not be applied in future DMM_DGetStatus calls
+**      int64_t *pCodes     - array of raw codes captured by DMM_GetSamples on the current scale
+**      double *pdValues    - array receiving the values, at least cntSamples elements
+**      int cntSamples      - the number of codes to be converted
 **
 **	Return Value:
-**		none
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
 **
 **	Description:
-**		This function sets the parameter that will determine whether or not the 
-**      calibration coefficients will be applied when value is computed in 
-**      subsequent DMM_DGetStatus calls. 
-**      The default value for this parameter is 1.
+**		This function converts raw codes to values, according to the current selected scale. 
+**      The values are the same as the ones computed by DMM_DStatusToValue (including calibration, according to DMM_SetUseCalib, 
+**      the +/- INFINITY values outside the convertor range and the VoltageDC50 compensation), 
+**      using the cached conversion coefficients of the scale.
 **            
 */
-void DMM_SetUseCalib(uint8_t f)
+uint8_t DMM_CodesToValues(int64_t *pCodes, double *pdValues, int cntSamples)
 {
-    fUseCalib = f;
+    int i;
+    int64_t code;
+    double v;
+    uint8_t bResult;
+    DMMCONV *pConv = DMM_GetConv(&bResult);
+    if(!pConv)
+    {
+        return bResult;
+    }
+    if(DMM_FACScale(idxCurrentScale))
+    {
+        for(i = 0; i < cntSamples; i++)
+        {
+            pdValues[i] = DMM_RmsSqrtQ11(pCodes[i], pConv->rmsOffset)*pConv->dGain;
+        }
+        return ERRVAL_SUCCESS;
+    }
+    for(i = 0; i < cntSamples; i++)
+    {
+        code = pCodes[i];
+        if(code >= 0x7FFFFE)
+        {
+            v = INFINITY;   // value outside convertor range
+        }
+        else if(code <= -0x7FFFFE)
+        {
+            v = -INFINITY;  // value outside convertor range
+        }
+        else
+        {
+            v = pConv->dGain*code + pConv->dOffset;
+        }
+        if(idxCurrentScale == DMMVoltageDC50Scale)
+        {
+            v = DMM_CompensateVoltage50DCLinear(v);
+        }
+        pdValues[i] = v;
+    }
+    return ERRVAL_SUCCESS;
 }
 
-/***	DMM_FACScale
+/***	DMM_FixPrepare
 **
 **	Parameters:
-**      int idxScale  - the scale index
-**              
+**      DMMFIX *pFix        - pointer to the structure receiving the fixed point coefficients
 **
 **	Return Value:
-**		1 if the specified scale is a AC (alternating current) scale.
-**		0 if the specified scale is not a AC (alternating current) scale.
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CALIB_NANDOUBLE      0xFB    // error, the calibration coefficients are not numbers
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
 **
 **	Description:
-**		This function checks if the specified scale is an AC (alternating current) scale.
-**      It returns 1 for the AC Voltage, AC current and AC Low current type scales, and 0 otherwise.
-**      The scale type is checked using the mode field in DMMCFG structure.
+**		This function retrieves the fixed point conversion coefficients of the current scale, used by DMM_FixCodeToValue. 
+**      The scale multiplication factor, the calibration coefficients (according to DMM_SetUseCalib) and the 
+**      VoltageDC50 compensation are combined in integer gains and offsets (see DMM_FixCompute), so that floating point 
+**      is only used once per scale / calibration change, and not for each sample.
+**      The values are expressed in 10^-exp units of the scale unit, exp being chosen so that the scale range 
+**      is represented on about DMM_FIX_DIGITS decimal digits.
+**      The coefficients must be retrieved again when the scale, the calibration or the DMM_SetUseCalib setting change.
 **            
 */
-uint8_t DMM_FACScale(int idxScale)
+uint8_t DMM_FixPrepare(DMMFIX *pFix)
 {
-    int mode = dmmcfg[idxScale].mode;
-    return (mode == DmmACVoltage) || (mode == DmmACCurrent) || (mode == DmmACLowCurrent);
+    uint8_t bResult;
+    DMMCONV *pConv = DMM_GetConv(&bResult);
+    if(!pConv)
+    {
+        return bResult;
+    }
+    if(pConv->bFixErr == ERRVAL_SUCCESS)
+    {
+        *pFix = pConv->fix;
+    }
+    return pConv->bFixErr;
+}
+
+/***	DMM_FixCodeToValue
+**
+**	Parameters:
+**      DMMFIX *pFix        - the fixed point coefficients of the scale, computed by DMM_FixPrepare
+**      int64_t code        - the raw code, as captured by DMM_GetSamples
+**
+**	Return Value:
+**		int64_t 
+**          the value, in 10^-pFix->exp units of the scale unit, or
+**          +/- DMM_FIX_INFINITY if the code is outside the convertor range
+**
+**	Description:
+**		This function converts a raw code to a fixed point value using only integer operations: 
+**      one 32 x 32 bits multiplication for DC scales, an integer square root and one multiplication for AC scales. 
+**      The result matches the DMM_CodesToValues value scaled by 10^exp within 0.005 AD1 code LSB for DC scales 
+**      (0.02 LSB for VoltageDC50, because of the cubic compensation). For AC scales the square root is computed 
+**      with 11 fractional bits, the difference is below 2e-5 relative over the whole RMS register range. 
+**      The host benchmark (Demo_HostBenchmarkConversion) checks these tolerances.
+**            
+*/
+int64_t DMM_FixCodeToValue(DMMFIX *pFix, int64_t code)
+{
+    int64_t t, a, x;
+    if(pFix->fAC)
+    {
+        // Q22 RMS code, the square root has 11 fractional bits
+        x = (code << 22) - pFix->rmsOffset;
+        if(x < 0)
+        {
+            x = -x;
+        }
+        return ((int64_t)DMM_ISqrt64((uint64_t)x) * pFix->gain + (1LL << (pFix->shift + 10))) >> (pFix->shift + 11);
+    }
+    if(code >= 0x7FFFFE)
+    {
+        return DMM_FIX_INFINITY;    // value outside convertor range
+    }
+    if(code <= -0x7FFFFE)
+    {
+        return -DMM_FIX_INFINITY;   // value outside convertor range
+    }
+    if(!pFix->fCubic)
+    {
+        return (((int64_t)(int32_t)code * pFix->gain + (1LL << (pFix->shift - 1))) >> pFix->shift) + pFix->offset;
+    }
+    // VoltageDC50: linear part, then the cubic term computed on the value t in 10 uV units
+    t = (((int64_t)(int32_t)code * pFix->gainT + (1LL << (pFix->shiftT - 1))) >> pFix->shiftT) + pFix->offsetT;
+    // a = t * t * cubic, with 16 fractional bits
+    a = (((t * t) >> 16) * pFix->cubic) >> (pFix->shiftC - 32);
+    return (((int64_t)(int32_t)code * pFix->gainLin + (1LL << (pFix->shiftLin - 1))) >> pFix->shiftLin) + pFix->offsetLin 
+        + ((a * t + (1LL << 15)) >> 16);
+}
+
+/***	DMM_FixCodesToValues
+**
+**	Parameters:
+**      int64_t *pCodes     - array of raw codes captured by DMM_GetSamples on the current scale
+**      int64_t *pValues    - array receiving the fixed point values, at least cntSamples elements
+**      int cntSamples      - the number of codes to be converted
+**      int8_t *pExp        - pointer to the variable receiving the decimal exponent: the values are in 10^-(*pExp) units, can be NULL
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**
+**	Description:
+**		This function is the fixed point counterpart of DMM_CodesToValues: it computes the coefficients of the current scale 
+**      using DMM_FixPrepare, then converts the codes using DMM_FixCodeToValue.
+**            
+*/
+uint8_t DMM_FixCodesToValues(int64_t *pCodes, int64_t *pValues, int cntSamples, int8_t *pExp)
+{
+    int i;
+    DMMFIX fix;
+    uint8_t bResult = DMM_FixPrepare(&fix);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    for(i = 0; i < cntSamples; i++)
+    {
+        pValues[i] = DMM_FixCodeToValue(&fix, pCodes[i]);
+    }
+    if(pExp)
+    {
+        *pExp = fix.exp;
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMM_ISqrt64
+**
+**	Parameters:
+**      uint64_t x          - the value
+**
+**	Return Value:
+**		uint32_t    - the integer part of the square root of x
+**
+**	Description:
+**		This function computes the exact integer square root of a 64 bits value, using only integer operations. 
+**      The value is normalized so that its 2 most significant bits are not both 0, the reciprocal square root 
+**      of its upper 32 bits is seeded from a 24 entries table (5 bits) and refined by 3 Newton iterations (30 bits), 
+**      each made of three 32 x 32 bits multiplications. The square root estimate (within a few units) is then 
+**      corrected so that r * r <= x < (r + 1) * (r + 1).
+**      It replaces the double sqrt call for the RMS register conversion, see DMM_RmsSqrtQ11: the PIC32MX has no FPU, 
+**      the double sqrt is a software routine computing the result bit by bit. The host benchmark (Demo_HostBenchmarkISqrt) 
+**      checks the result against the libm square root and compares its time to a software double square root, 
+**      not to the host FPU sqrt, which is faster.
+**            
+*/
+uint32_t DMM_ISqrt64(uint64_t x)
+{
+    int n;
+    uint32_t u, y, r;
+    uint64_t t;
+    if(x == 0)
+    {
+        return 0;
+    }
+    // normalize by an even shift, u / 2^32 is in [0.25, 1)
+    n = __builtin_clzll(x) & ~1;
+    u = (uint32_t)((x << n) >> 32);
+    // y = 1 / sqrt(u / 2^32), Q30
+    y = rgISqrtSeed[(u >> 27) - 8];
+    for(r = 0; r < 3; r++)
+    {
+        t = ((uint64_t)y * y) >> 30;                // y^2, Q30
+        t = ((uint64_t)u * t) >> 32;                // u * y^2, Q30, close to 1
+        y = (uint32_t)(((uint64_t)y * ((3ULL << 30) - t)) >> 31);
+    }
+    // sqrt(x << n) = u * y / 2^30, then undo the normalization
+    t = ((uint64_t)u * y) >> 30;
+    r = (t > 0xFFFFFFFFULL) ? 0xFFFFFFFF: (uint32_t)t;
+    r >>= n / 2;
+    while((uint64_t)r * r > x)
+    {
+        r--;
+    }
+    while(r < 0xFFFFFFFF && (uint64_t)(r + 1) * (r + 1) <= x)
+    {
+        r++;
+    }
+    return r;
+}
+
+/***	DMM_StartReadStatus
+**
+**	Parameters:
+**      DMMSTS *pDmmSts     - the buffer receiving the registers 0x00 - 0x1F. It must remain valid until the read is completed.
+**      void (*pfnDone)()   - function called when the read is completed, can be NULL
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success, the read was started
+**          ERRVAL_SPI_BUSY             0xEE    // a status read is already in progress
+**
+**	Description:
+**		This function starts reading the convertor / RMS registers (0-0x1F) as a burst transfer and returns. 
+**      It activates the DMM Slave Select pin and sends the read command synchronously, 
+**      then the 32 data bytes are transferred by DMA when the SPI hardware transport is used.
+**      When the transfer is completed the DMM Slave Select pin is deactivated and pfnDone is called 
+**      (from the DMA interrupt for the hardware transport).
+**      For the bit bang transport the read is completed before the function returns.
+**      No other DMM / EPROM function must be called until the read is completed, see DMM_FReadStatusBusy.
+**      The retrieved registers are converted to a value using DMM_DStatusToValue. 
+**      This allows the caller to process the previous value while the next status block is transferred.
+**            
+*/
+uint8_t DMM_StartReadStatus(DMMSTS *pDmmSts, void (*pfnDone)())
+{
+    uint8_t bResult;
+    if(fReadStatusBusy)
+    {
+        return ERRVAL_SPI_BUSY;
+    }
+    fReadStatusBusy = 1;
+    pfnReadStatusDone = pfnDone;
+
+    SPI_LockBus();
+    GPIO_SetValue_CS_DMM(0); // Activate CS_DMM
+    DelayAprox10Us(10);
+    // Send command byte: read, starting with 0 address
+    SPI_CoreTransferByte(1);
+    // Generate an extra clock (called SPI Read Period)
+    SPI_CoreTransferBits(0, 1);
+    
+    bResult = SPI_CoreStartBurstRead((uint8_t *)pDmmSts, sizeof(DMMSTS), DMM_ReadStatusDone);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        GPIO_SetValue_CS_DMM(1); // Deactivate CS_DMM
+        SPI_UnlockBus();
+        fReadStatusBusy = 0;
+    }
+    return bResult;
+}
+
+/***	DMM_FReadStatusBusy
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint8_t     - 1 if a status read started by DMM_StartReadStatus is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the status read started by DMM_StartReadStatus.
+**            
+*/
+uint8_t DMM_FReadStatusBusy()
+{
+    // polling the SPI state also lets the host simulation progress
+    return SPI_CoreFBurstBusy() || fReadStatusBusy;
+}
+
+/***	DMM_DStatusToValue
+**
+**	Parameters:
+**      DMMSTS *pDmmSts - the convertor / RMS registers values (0-0x1F)
+**      uint8_t *pbErr - Pointer to the error parameter, the error can be set to:
+**          ERRVAL_SUCCESS           0       // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**
+**	Return Value:
+**		double 
+**          the value computed according to the convertor / RMS registers values, or
+**          NAN (not a number) value if the convertor / RMS registers value is not ready or if ERRVAL_DMM_IDXCONFIG was set, or
+**          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
+**	Description:
+**		This function computes the value corresponding to the convertor / RMS registers, according to the current selected scale. 
+**      Depending on the parameter set by DMM_SetUseCalib (default is 1), calibration parameters will be applied on the computed value.
+**		It also compensates the not linear behavior of VoltageDC50 scale.
+**      The scale and calibration coefficients are taken from the conversion coefficients cache (see DMM_GetConv): 
+**      the DC value is a single multiply-add, which can differ from the separate scale and calibration 
+**      multiplications in the last bit of the double value. 
+**      The AC value uses the integer square root of the RMS register (see DMM_RmsSqrtQ11) instead of the double sqrt, 
+**      the relative difference is below 1e-8 for RMS values above 0x10000 (2e-4 for the smallest values).
+**      It returns NAN (not a number) when data is not available (ready) in the convertor registers.
+**      It returns INFINITY when values are outside the expected convertor range.
+**      If there is no valid current scale selected, the function sets error to ERRVAL_DMM_IDXCONFIG and NAN value is returned. 
+**      When no error is detected, the error is set to ERRVAL_SUCCESS.
+**      The error is copied on the byte pointed by pbErr, if pbErr is not null.
+**            
+*/
+double DMM_DStatusToValue(DMMSTS *pDmmSts, uint8_t *pbErr)
+{
+    int i;
+    double v;
+    v = NAN;
+    // 1. Verify index, get the conversion coefficients
+    uint8_t bResult;
+    DMMCONV *pConv = DMM_GetConv(&bResult);
+    if(!pConv)
+    {
+        if(pbErr)
+        {
+            *pbErr = bResult;
+        }
+        return NAN;
+    }
+
+    // 2. Compute value, according to the specific scale
+    
+    // AD1 signed value
+    int32_t vad1 = (pDmmSts->ad1[2]<<24)|(pDmmSts->ad1[1]<<16)|(pDmmSts->ad1[0]<<8);
+    vad1 /= 256;
+
+    // RMS for AC
+    int64_t vrms = 0;
+    for(i = 0; i < 5; i++)
+    {
+        vrms <<= 8;
+        vrms |= pDmmSts->rms[4-i];
+    }
+
+    if(DMM_FACScale(idxCurrentScale))
+    { // AC uses RMS
+        if(pDmmSts->intf & 0x10)
+        { // conversion done
+            // calibration coefficients are included in the cached coefficients, according to DMM_SetUseCalib
+            v = DMM_RmsSqrtQ11(vrms, pConv->rmsOffset)*pConv->dGain;
+        }   
+        else
+        {
+            v = NAN; // not ready
+        }
+    }
+    else
+    { // AD1 value
+        if(pDmmSts->intf & 0x04)
+        { // conversion done
+            if(vad1 >= 0x7FFFFE)
+            {
+                v = INFINITY;   // value outside convertor range
+            }
+            else
+            {
+                if(vad1 <= -0x7FFFFE)
+                {
+                   v = -INFINITY;   // value outside convertor range
+                }
+               else
+               {
+                    // calibration coefficients are included in the cached coefficients, according to DMM_SetUseCalib
+                    v = pConv->dGain*vad1 + pConv->dOffset;
+                }   
+            }
+        }
+        else
+        {
+            v = NAN; // not ready
+        }
+    }
+    if(idxCurrentScale == DMMVoltageDC50Scale)
+    {
+        // compensate the not linear scale behavior
+        v = DMM_CompensateVoltage50DCLinear(v);
+    }
+    if(pbErr)
+    {
+        *pbErr = ERRVAL_SUCCESS;
+    }    
+    return v;
+}
+
+
+/***	DMM_GetCurrentScale
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		int     - current scale index
+**              - -1 if no current scale was selected
+**
+**	Description:
+**		This function returns the current scale index. 
+**      This is the last scale index selected using the DMM_SetScale function.
+**      In case no current scale was selected, the function returns -1.
+**            
+*/
+int DMM_GetCurrentScale()
+{
+    return idxCurrentScale;
+}
+
+/***	DMM_GetCurrentScale
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		int     - current scale index
+**              - -1 if no current scale was selected
+**
+**	Description:
+**		This function returns the current scale index. 
+**      This is the last scale index selected using the DMM_SetScale function.
+**      In case no current scale was selected, the function returns -1.
+**            
+*/
+double DMM_GetScaleRange(int idxScale)
+{
+    double range = dmmcfg[idxScale].range;
+    return range;
+}
+
+/***	DMM_GetScaleMode
+**
+**	Parameters:
+**      int idxScale  - the scale index
+**
+**	Return Value:
+**		int     - the scale mode (DmmResistance, DmmDCVoltage, ...)
+**
+**	Description:
+**		This function returns the mode field of the specified scale. 
+**      The scales having the same mode measure the same quantity on different ranges.
+**            
+*/
+int DMM_GetScaleMode(int idxScale)
+{
+    return dmmcfg[idxScale].mode;
+}
+
+/***	DMM_GetScaleSwitches
+**
+**	Parameters:
+**      int idxScale  - the scale index
+**
+**	Return Value:
+**		uint8_t     - the switch bits of the scale: 0 RLD, 1 RLU, 2 RLI
+**
+**	Description:
+**		This function returns the switch (relays) bits of the specified scale. 
+**      Changing between two scales having the same switch bits does not operate the relays.
+**            
+*/
+uint8_t DMM_GetScaleSwitches(int idxScale)
+{
+    return dmmcfg[idxScale].sw;
+}
+/***	DMM_FStatusToSample
+**
+**	Parameters:
+**      DMMSTS *pDmmSts     - the convertor / RMS registers values (0-0x1F)
+**      DMMSAMPLE *pSample  - pointer to the structure receiving the raw sample
+**      uint32_t tstamp     - the timestamp of the sample (HAL_GetTicks value), taken by the caller when the conversion was detected
+**
+**	Return Value:
+**		uint8_t     - 1 if the conversion done flag of the current scale is set and the sample was filled, 0 otherwise
+**
+**	Description:
+**		This function extracts the raw sample from a status block, according to the current selected scale: 
+**      the RMS register for AC scales, the AD1 register for the other scales. 
+**      The sample is stamped with the current scale index and tstamp, so that it can be converted later 
+**      using DMM_DSampleToValue. The timestamp is taken by the caller before the SPI transfer 
+**      (at the start of the interrupt handler for DMMACQ), so that it does not include the transfer time. 
+**      It does not use floating point, so it can be called from the function that completes a background status read.
+**            
+*/
+uint8_t DMM_FStatusToSample(DMMSTS *pDmmSts, DMMSAMPLE *pSample, uint32_t tstamp)
+{
+    int i;
+    int64_t code = 0;
+    if(DMM_ERR_CheckIdxCalib(idxCurrentScale) != ERRVAL_SUCCESS)
+    {
+        return 0;
+    }
+    if(DMM_FACScale(idxCurrentScale))
+    {
+        if(!(pDmmSts->intf & DMM_INTF_RMS))
+        {
+            return 0;
+        }
+        for(i = 4; i >= 0; i--)
+        {
+            code = (code << 8) | pDmmSts->rms[i];
+        }
+        pSample->flags = DMMSAMPLE_FLAG_RMS;
+    }
+    else
+    {
+        if(!(pDmmSts->intf & DMM_INTF_AD1))
+        {
+            return 0;
+        }
+        code = (int32_t)(((uint32_t)pDmmSts->ad1[2] << 24) | ((uint32_t)pDmmSts->ad1[1] << 16) | ((uint32_t)pDmmSts->ad1[0] << 8)) / 256;
+        pSample->flags = 0;
+    }
+    pSample->code = code;
+    pSample->idxScale = idxCurrentScale;
+    pSample->tstamp = tstamp;
+    return 1;
+}
+
+/***	DMM_DSampleToValue
+**
+**	Parameters:
+**      DMMSAMPLE *pSample  - the raw sample
+**      uint8_t *pbErr - Pointer to the error parameter, the error can be set to:
+**          ERRVAL_SUCCESS           0       // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**
+**	Return Value:
+**		double 
+**          the value, see DMM_DStatusToValue
+**
+**	Description:
+**		This function converts a raw sample to a value, according to the current scale, by calling DMM_DStatusToValue.
+**      NAN is returned if the sample was acquired on a different scale than the current scale.
+**            
+*/
+double DMM_DSampleToValue(DMMSAMPLE *pSample, uint8_t *pbErr)
+{
+    int i;
+    DMMSTS dmmsts = {{0}};
+    if(pSample->idxScale != idxCurrentScale)
+    {
+        if(pbErr)
+        {
+            *pbErr = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+        }
+        return NAN;
+    }
+    if(pSample->flags & DMMSAMPLE_FLAG_RMS)
+    {
+        for(i = 0; i < sizeof(dmmsts.rms); i++)
+        {
+            dmmsts.rms[i] = (uint8_t)(pSample->code >> (8 * i));
+        }
+        dmmsts.intf = DMM_INTF_RMS;
+    }
+    else
+    {
+        for(i = 0; i < sizeof(dmmsts.ad1); i++)
+        {
+            dmmsts.ad1[i] = (uint8_t)(pSample->code >> (8 * i));
+        }
+        dmmsts.intf = DMM_INTF_AD1;
+    }
+    return DMM_DStatusToValue(&dmmsts, pbErr);
+}
+
+/***	DMM_SetUseCalib
+**
+**	Parameters:
+**      uint8_t f  
+**              1 if calibrations coefficients should be applied in future DMM_DGetStatus calls
+**              0 if calibrations coefficients should not be applied in future DMM_DGetStatus calls
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the parameter that will determine whether or not the 
+**      calibration coefficients will be applied when value is computed in 
+**      subsequent DMM_DGetStatus calls. 
+**      The default value for this parameter is 1.
+**      The conversion coefficients cache holds both the calibrated and not calibrated coefficients, 
+**      so changing this parameter does not rebuild the cache.
+**            
+*/
+void DMM_SetUseCalib(uint8_t f)
+{
+    fUseCalib = f;
+}
+
+/***	DMM_SetPollMode
+**
+**	Parameters:
+**      uint8_t bMode   - the polling mode:
+**          DMM_POLL_FULLSTATUS     0   // read the whole status block on each attempt
+**          DMM_POLL_INTF           1   // read only the INTF register until ready, then the data registers
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function selects how DMM_DGetValue waits for a valid value. 
+**      In DMM_POLL_INTF mode only the INTF register is read until the conversion done bit of the current scale 
+**      (0x04 for AD1, 0x10 for RMS) is set, then only the AD1 (3 bytes) or RMS (5 bytes) registers are read.
+**      In DMM_POLL_FULLSTATUS mode the 32 status registers are read on each attempt.
+**      Both modes test the same INTF bits: unless reading INTF clears them (see DMM_INTF_READCLEAR), 
+**      each attempt returns the last conversion in both modes.
+**      The default mode is DMM_POLL_INTF.
+**            
+*/
+void DMM_SetPollMode(uint8_t bMode)
+{
+    bPollMode = bMode;
+}
+
+/***	DMM_GetPollSavedBytes
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint32_t    - the number of SPI bytes saved
+**
+**	Description:
+**		This function returns the number of SPI bytes (command and data) that DMM_POLL_INTF polling saved, 
+**      compared to reading the whole status block for each attempt, since the last DMM_ResetPollSavedBytes call.
+**            
+*/
+uint32_t DMM_GetPollSavedBytes()
+{
+    return cbPollSaved;
+}
+
+/***	DMM_ResetPollSavedBytes
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function clears the saved SPI bytes counter.
+**            
+*/
+void DMM_ResetPollSavedBytes()
+{
+    cbPollSaved = 0;
+}
+
+/***	DMM_FACScale
+**
+**	Parameters:
+**      int idxScale  - the scale index
+**              
+**
+**	Return Value:
+**		1 if the specified scale is a AC (alternating current) scale.
+**		0 if the specified scale is not a AC (alternating current) scale.
+**
+**	Description:
+**		This function checks if the specified scale is an AC (alternating current) scale.
+**      It returns 1 for the AC Voltage, AC current and AC Low current type scales, and 0 otherwise.
+**      The scale type is checked using the mode field in DMMCFG structure.
+**            
+*/
+uint8_t DMM_FACScale(int idxScale)
+{
+    int mode = dmmcfg[idxScale].mode;
+    return (mode == DmmACVoltage) || (mode == DmmACCurrent) || (mode == DmmACLowCurrent);
 }
 
 /* ************************************************************************** */
@@ -709,7 +1586,7 @@ uint8_t DMM_CheckAcceptedMeasurementDispersion(double dMeasuredVal, double dRefV
 	uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
     char szVal[20];
     char szRefVal[20];
-    double dispersion; 
+    double dispersion = 0; 
     if(bResult == ERRVAL_SUCCESS)
     {
         dispersion = (dMeasuredVal - dRefVal)/dmmcfg[idxScale].range;
@@ -778,10 +1655,9 @@ uint8_t DMM_CheckAcceptedMeasurementDispersion(double dMeasuredVal, double dRefV
 uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit)
 {
     // default 6 decimals
-    double dScaleFact;
-    char szUnitPrefix[2], szUnit[5];
-    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
-    if(bResult == ERRVAL_SUCCESS)
+    uint8_t bResult;
+    // the unit data is cached with the conversion coefficients
+    if(DMM_GetConv(&bResult))
     {
         if (dVal == INFINITY)
         {
@@ -809,18 +1685,13 @@ uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit)
             }
             else
             {
-                bResult = DMM_GetScaleUnit(idxCurrentScale, &dScaleFact, szUnitPrefix, szUnit);
-                if(bResult == ERRVAL_SUCCESS)
+                dVal *= dConvScaleFact;
+                sprintf(pString, "%.6lf", dVal);
+                if(fUnit)
                 {
-                    // valid idxScale
-                    dVal *= dScaleFact;
-                    sprintf(pString, "%.6lf", dVal);
-                    if(fUnit)
-                    {
-                        strcat(pString, " ");
-                        strcat(pString, szUnitPrefix);
-                        strcat(pString, szUnit);
-                    }
+                    strcat(pString, " ");
+                    strcat(pString, szConvUnitPrefix);
+                    strcat(pString, szConvUnit);
                 }
             }
         }
@@ -944,38 +1815,348 @@ uint8_t DMM_InterpretValue(char *pString, double *pdVal)
             }
         }
     }
-    return bResult;
+    return bResult;
+}
+
+/***	DMM_FDCCurrentScale
+**
+**	Parameters:
+**      < none>
+**              
+**
+**	Return Value:
+**		1 if the current scale is a DC Current type scale.
+**		0 if the current scale is not a DC Current type scale.
+**
+**	Description:
+**		This function checks if the specified scale is a DC Current type scale.
+**      It returns 1 for the DC Current type scales, and 0 otherwise.
+**      The scale type is checked using the mode field in DMMCFG structure.
+**            
+*/
+uint8_t DMM_FDCCurrentScale()
+{
+    int idxScale = DMM_GetCurrentScale();
+    int mode = dmmcfg[idxScale].mode;
+    return (mode == DmmDCCurrent || mode == DmmDCCurrent || mode == DmmDCLowCurrent);
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMM_WriteCfgFull
+**
+**	Parameters:
+**      uint8_t idxScale		        - the scale index, must be valid
+**      const DMMSETTLE *pSettle    - the settling delays
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**	Description:
+**		This function resets the DMM, drops and sets the switches, writes the 24 configuration registers starting at 0x1F address 
+**      and verifies them by reading them back. It is called by DMM_SetScale when the switches change or the shadow is not valid.
+**      The switches are kept released for dlyDrop. With the settle detection enabled the configuration is verified immediately 
+**      and DMM_WaitSettled waits at most dlyRelay + dlyAnalog, otherwise the verify is performed dlyRelay after 
+**      the configuration write and the conversion performed during the settling is discarded dlyAnalog after the verify.
+**            
+*/
+uint8_t DMM_WriteCfgFull(int idxScale, const DMMSETTLE *pSettle)
+{
+    const int cbCfg = DMM_CFG_CNTREGS;
+    uint8_t rgIn[DMM_CFG_CNTREGS];
+    
+    // 1. Reset the DMM by writing 0x60 on 0x37 register
+    uint8_t valReset = 0x60;
+    // Build command:
+    //  MSB: 7 bits address: 0x37
+    //  LSB: 0 for write
+    uint8_t bCmd = 0x37 << 1;
+    
+    // Write 1 bytes, starting with 0x37 address
+    DMM_SendCmdSPI(bCmd, 1, &valReset);    
+    
+    // 2. Set the switches
+    
+    // clear switches
+    DMM_ConfigSwitches(0); 
+    DelayAprox10Us(pSettle->dlyDrop);    
+    DMM_ConfigSwitches(dmmcfg[idxScale].sw); 
+    
+    // 3. Set the value for the 24 registers starting with 0x1f
+    // Build command:
+    //  MSB: 7 bits address: 0x1F
+    //  LSB: 0 for write
+    bCmd = DMM_REG_CFG << 1;
+    
+    // Write 24 bytes, starting with 0x1F address, values taken from dmmcfg[idxScale].cfg array
+    DMM_SendCmdSPI(bCmd, cbCfg, (uint8_t *)dmmcfg[idxScale].cfg);
+
+    // 4. Verify the values of the 24 registers starting with 0x1f
+    
+    // Build command:
+    //  MSB: 7 bits address: 0x1F
+    //  LSB: 1 for read
+    bCmd =(DMM_REG_CFG<<1) | 1;    
+    if(!fSettleDetect)
+    {
+        DelayAprox10Us(pSettle->dlyRelay);     
+    }
+
+    // 4.1. Read 24 bytes, starting with 0x1F address, values placed in rgIn array
+    DMM_GetCmdSPI(bCmd, cbCfg, rgIn);
+
+    // 4.2. Compare values from rgIn and dmmcfg[idxScale].cfg arrays
+     int i;
+     for(i = 0; i < cbCfg; i++){
+         if((rgIn[i]&dmmcfgmask[i])!=(dmmcfgmask[i]&dmmcfg[idxScale].cfg[i]))
+         {
+            // DMM scale configuration verify failed;
+             return ERRVAL_DMM_CFGVERIFY;
+         }
+     }
+
+    // 5. Wait for the relays and the analog part to settle
+    DMM_WaitSettled(idxScale, fSettleDetect ? pSettle->dlyRelay + pSettle->dlyAnalog: pSettle->dlyAnalog);
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMM_WriteCfgDiff
+**
+**	Parameters:
+**      uint8_t idxScale		        - the scale index, must be valid and use the same switches as the shadow configuration
+**      const DMMSETTLE *pSettle    - the settling delays
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**	Description:
+**		This function writes only the configuration registers whose value (masked by dmmcfgmask) differs from the shadow configuration, 
+**      without DMM reset and switches drop. Each run of changed registers is written by one burst command, 
+**      the runs separated by at most DMM_CFG_MERGEGAP unchanged registers being merged (rewriting the unchanged registers 
+**      costs less than a new command). Then the registers from the first to the last written one are read back and verified.
+**      Then DMM_WaitSettled waits at most dlyAnalog for the scale to settle. 
+**      If no register differs, nothing is transferred and there is no delay.
+**      It is called by DMM_SetScale.
+**            
+*/
+uint8_t DMM_WriteCfgDiff(int idxScale, const DMMSETTLE *pSettle)
+{
+    const uint8_t *pCfg = dmmcfg[idxScale].cfg;
+    uint8_t rgIn[DMM_CFG_CNTREGS];
+    int i, idxRun, idxRunEnd, idxFirst = -1, idxLast = -1;
+
+    // 1. Write the runs of changed registers
+    i = 0;
+    while(i < DMM_CFG_CNTREGS)
+    {
+        if(!((pCfg[i] ^ rgCfgShadow[i]) & dmmcfgmask[i]))
+        {
+            i++;
+            continue;
+        }
+        idxRun = idxRunEnd = i;
+        for(i++; (i < DMM_CFG_CNTREGS) && (i - idxRunEnd <= DMM_CFG_MERGEGAP); i++)
+        {
+            if((pCfg[i] ^ rgCfgShadow[i]) & dmmcfgmask[i])
+            {
+                idxRunEnd = i;
+            }
+        }
+        DMM_SendCmdSPI((DMM_REG_CFG + idxRun) << 1, idxRunEnd - idxRun + 1, (uint8_t *)pCfg + idxRun);
+        if(idxFirst < 0)
+        {
+            idxFirst = idxRun;
+        }
+        idxLast = idxRunEnd;
+    }
+
+    // 2. Verify the written registers
+    if(idxFirst >= 0)
+    {
+        DMM_GetCmdSPI(((DMM_REG_CFG + idxFirst) << 1) | 1, idxLast - idxFirst + 1, rgIn + idxFirst);
+        for(i = idxFirst; i <= idxLast; i++)
+        {
+            if((rgIn[i] ^ pCfg[i]) & dmmcfgmask[i])
+            {
+                // DMM scale configuration verify failed;
+                return ERRVAL_DMM_CFGVERIFY;
+            }
+        }
+        DMM_WaitSettled(idxScale, pSettle->dlyAnalog);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMM_GetSettle
+**
+**	Parameters:
+**      uint8_t swFrom      - the current switches, DMM_SETTLE_ANYSW if not known
+**      uint8_t swTo        - the switches of the new scale
+**      int mode            - the mode of the new scale
+**
+**	Return Value:
+**		const DMMSETTLE *   - the settling delays of the transition
+**
+**	Description:
+**		This function returns the first rgSettle entry matching the transition. An entry matches when its swFrom is DMM_SETTLE_ANYSW 
+**      or equal to swFrom, its swTo is DMM_SETTLE_ANYSW, equal to swTo, or DMM_SETTLE_SAMESW and the switches do not change, 
+**      and its mode is DMM_SETTLE_ANYMODE or equal to mode. An unknown swFrom never matches DMM_SETTLE_SAMESW.
+**      The last entry matches any transition. The delays are defined by the DMM_SETTLE_... constants, which can be overridden at build time.
+**            
+*/
+const DMMSETTLE *DMM_GetSettle(uint8_t swFrom, uint8_t swTo, int mode)
+{
+    int i;
+    const DMMSETTLE *pSettle;
+    for(i = 0; i < sizeof(rgSettle)/sizeof(rgSettle[0]) - 1; i++)
+    {
+        pSettle = &rgSettle[i];
+        if((pSettle->swFrom != DMM_SETTLE_ANYSW) && (pSettle->swFrom != swFrom))
+        {
+            continue;
+        }
+        if(pSettle->swTo == DMM_SETTLE_SAMESW ? (swFrom == DMM_SETTLE_ANYSW || swFrom != swTo): 
+            (pSettle->swTo != DMM_SETTLE_ANYSW && pSettle->swTo != swTo))
+        {
+            continue;
+        }
+        if((pSettle->mode != DMM_SETTLE_ANYMODE) && (pSettle->mode != mode))
+        {
+            continue;
+        }
+        return pSettle;
+    }
+    return &rgSettle[i];
+}
+
+/***	DMM_FlushConversion
+**
+**	Parameters:
+**      uint8_t fAC         - 1 for AC scales (RMS register), 0 for the other scales (AD1 register)
+**
+**	Return Value:
+**
+**	Description:
+**		This function discards the conversion performed while the scale was settling, so that the first value retrieved 
+**      after DMM_SetScale comes from a new conversion. 
+**      When built with DMM_INTF_READCLEAR, it reads the INTF register, which clears the conversion done flags. 
+**      Otherwise the flags stay set and the data registers always hold the last conversion: a new conversion is detected 
+**      when the code (AD1, or RMS for AC scales) differs from the first code read, within DMM_FLUSH_TIMEOUT. 
+**      A code outside the convertor range is not waited for, as the following conversions give the same overload value.
+**            
+*/
+void DMM_FlushConversion(uint8_t fAC)
+{
+#if DMM_INTF_READCLEAR
+    uint8_t bIntf;
+    DMM_GetCmdSPI((DMM_REG_INTF << 1) | 1, 1, &bIntf);
+#else
+    uint32_t tStart = HAL_GetTicks();
+    int64_t code, codeFirst = 0;
+    int cntCodes = 0;
+    while((HAL_GetTicks() - tStart) < DMM_FLUSH_TIMEOUT * (HAL_TICKS_FRQ / 100000))
+    {
+        if(!DMM_FGetCode(fAC, &code))
+        {
+            continue;
+        }
+        if(!cntCodes++)
+        {
+            codeFirst = code;
+            if(!fAC && (code >= 0x7FFFFE || code <= -0x7FFFFE))
+            {
+                break;
+            }
+        }
+        else if(code != codeFirst)
+        {
+            break;
+        }
+    }
+#endif
 }
 
-/***	DMM_FDCCurrentScale
+/***	DMM_WaitSettled
 **
 **	Parameters:
-**      < none>
-**              
+**      int idxScale        - the scale being selected
+**      uint32_t dlyMax     - the maximum wait, in 10 us units
 **
 **	Return Value:
-**		1 if the current scale is a DC Current type scale.
-**		0 if the current scale is not a DC Current type scale.
 **
 **	Description:
-**		This function checks if the specified scale is a DC Current type scale.
-**      It returns 1 for the DC Current type scales, and 0 otherwise.
-**      The scale type is checked using the mode field in DMMCFG structure.
+**		This function waits for the scale to settle after the configuration was written and verified, 
+**      then discards the pending conversion, so that the samples retrieved afterwards come from settled conversions.
+**      When the settle detection is disabled, dlyMax is below DMM_SETTLE_MINDETECT (too short for the conversions 
+**      needed by a detection) or the scale is an AC scale, it waits dlyMax and calls DMM_FlushConversion: the RMS register 
+**      only holds the mean square of the AC component, a steady RMS code does not show that the input path settled.
+**      Otherwise it discards the conversion in progress (it may have started before the change) and reads the successive AD1 codes 
+**      until they stayed within the noise band of the scale (see DMM_SetSettleBand) around a reference code
+**      during the drift window (dlyMax / DMM_SETTLE_WNDDIV) and for DMM_SETTLE_CNTSTABLE more codes, or until dlyMax elapsed. 
+**      A code outside the band, or outside the convertor range, becomes the new reference and restarts the window.
+**      The successive codes of a slow exponential tail differ by less than the band while the value is still far from the final one, 
+**      so the drift is checked over a window comparable to the settling time constant (about dlyMax / 15 when the maximum wait 
+**      covers the settling to 1 code), not between back to back conversions. As the criterion is the time between the compared codes, 
+**      it does not need the INTF read to clear the conversion done flags: a conversion read twice only adds a code to the window.
+**      The settle time and the detection status are stored for DMM_GetSettleTime.
 **            
 */
-uint8_t DMM_FDCCurrentScale()
+void DMM_WaitSettled(int idxScale, uint32_t dlyMax)
 {
-    int idxScale = DMM_GetCurrentScale();
-    int mode = dmmcfg[idxScale].mode;
-    return (mode == DmmDCCurrent || mode == DmmDCCurrent || mode == DmmDCLowCurrent);
+    uint32_t tStart = HAL_GetTicks();
+    uint32_t tMax = dlyMax * (HAL_TICKS_FRQ / 100000);
+    uint32_t tWnd = tMax / DMM_SETTLE_WNDDIV;
+    uint32_t band = rgSettleBand[idxScale] ? rgSettleBand[idxScale]: DMM_SETTLE_BAND;
+    uint8_t fAC = DMM_FACScale(idxScale);
+    uint32_t tCode, tRef = 0;
+    int64_t code, codeRef = 0;
+    int cntCodes = 0, cntStable = 0;
+    fSettleDetected = 0;
+    if(!fSettleDetect || dlyMax < DMM_SETTLE_MINDETECT || fAC)
+    {
+        DelayAprox10Us(dlyMax);
+        DMM_FlushConversion(fAC);
+        tusSettle = dlyMax * 10;
+        return;
+    }
+    DMM_FlushConversion(0);
+    while((HAL_GetTicks() - tStart) < tMax)
+    {
+        if(!DMM_FGetCode(0, &code))
+        {
+            continue;
+        }
+        tCode = HAL_GetTicks();
+        if(cntCodes++ && (code < 0x7FFFFE) && (code > -0x7FFFFE) && (code - codeRef <= (int64_t)band) && (codeRef - code <= (int64_t)band))
+        {
+            if((tCode - tRef) >= tWnd && ++cntStable >= DMM_SETTLE_CNTSTABLE)
+            {
+                fSettleDetected = 1;
+                break;
+            }
+        }
+        else
+        {
+            // first code, still drifting or outside the convertor range (a saturated code shows no drift): the window restarts from this code
+            codeRef = code;
+            tRef = tCode;
+            cntStable = 0;
+        }
+    }
+    if(!fSettleDetected)
+    {
+        // the maximum wait elapsed, the conversion in progress is discarded
+        DMM_FlushConversion(0);
+    }
+    tusSettle = (HAL_GetTicks() - tStart) / (HAL_TICKS_FRQ / 1000000);
 }
 
-/* ************************************************************************** */
-/* ************************************************************************** */
-// Section: Local Functions                                                   */
-/* ************************************************************************** */
-/* ************************************************************************** */
-
 /***	DMM_ConfigSwitches
 **
 **	Parameters:
@@ -1017,11 +2198,13 @@ void DMM_ConfigSwitches(uint8_t sw)
 **      It activates DMM Slave Select pin, sends the command byte, and the specified 
 **      number of bytes from pbWrData, using the SPI_CoreTransferByte function.
 **      Finally it deactivates the DMM Slave Select pin.
+**      The SPI bus is locked during the transaction, see SPI_LockBus.
 **          
 */
 void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData)
 {
     int i;
+    SPI_LockBus();
     GPIO_SetValue_CS_DMM(0); // Activate CS_DMM
 
     DelayAprox10Us(10);   
@@ -1035,6 +2218,8 @@ void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData)
     }
     DelayAprox10Us(10);    
     GPIO_SetValue_CS_DMM(1); // Deactivate CS_DMM
+    SPI_UnlockBus();
+    cbDmmSpi += 1 + bytesNumber;
 }
 
 
@@ -1053,12 +2238,14 @@ void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData)
 **      It activates DMM Slave Select pin, sends the command byte, 
 **      and then retrieves the specified number of bytes into pbRdData, using the SPI_CoreTransferByte function.      
 **      Finally it deactivates the DMM Slave Select pin.
+**      The SPI bus is locked during the transaction, see SPI_LockBus.
 **          
 */
 void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
 {
     int i;
 
+    SPI_LockBus();
     GPIO_SetValue_CS_DMM(0); // Activate CS_DMM
     DelayAprox10Us(10);
     
@@ -1066,10 +2253,7 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
     SPI_CoreTransferByte(bCmd);
     
     // Generate an extra clock (called SPI Read Period)
-    GPIO_SetValue_CLK(1);                // set the clock line
-    DelayAprox10Us(SPI_CLK_DELAY);  // some delay
-    GPIO_SetValue_CLK(0);                // reset the clock line
-    DelayAprox10Us(SPI_CLK_DELAY);  // some delay
+    SPI_CoreTransferBits(0, 1);
 
     // Receive the requested number of bytes
     for(i = 0; i< bytesNumber; i++)
@@ -1078,6 +2262,8 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
     }
     DelayAprox10Us(10);
     GPIO_SetValue_CS_DMM(1); // Deactivate CS_DMM
+    SPI_UnlockBus();
+    cbDmmSpi += 1 + bytesNumber;
 }
 
 /***	DMM_DGetStatus
@@ -1094,10 +2280,7 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
 **          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
 **	Description:
 **		This function reads the value of the convertor / RMS registers (0-0x1F).
-**      Then, it computes the value corresponding to the convertor / RMS registers, according to the current selected scale. 
-**      Depending on the parameter set by DMM_SetUseCalib (default is 1), calibration parameters will be applied on the computed value.
-**      It returns NAN (not a number) when data is not available (ready) in the convertor registers.
-**      It returns INFINITY when values are outside the expected convertor range.
+**      Then, it computes the value corresponding to the convertor / RMS registers by calling DMM_DStatusToValue. 
 **      If there is no valid current scale selected, the function sets error to ERRVAL_DMM_IDXCONFIG and NAN value is returned. 
 **      When no error is detected, the error is set to ERRVAL_SUCCESS.
 **      The error is copied on the byte pointed by pbErr, if pbErr is not null.
@@ -1106,9 +2289,6 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
 */
 double DMM_DGetStatus(uint8_t *pbErr)
 {
-    int i;
-    double v;
-    v = NAN;
     // 1. Verify index
     uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
     if(bResult != ERRVAL_SUCCESS)
@@ -1132,73 +2312,367 @@ double DMM_DGetStatus(uint8_t *pbErr)
     DMM_GetCmdSPI(bCmd, sizeof(dmmsts), (uint8_t *)&dmmsts);
     
     // 3. Compute value, according to the specific scale
-    
-    // AD1 signed value
-    int32_t vad1 = (dmmsts.ad1[2]<<24)|(dmmsts.ad1[1]<<16)|(dmmsts.ad1[0]<<8);
-    vad1 /= 256;
+    return DMM_DStatusToValue(&dmmsts, pbErr);
+}
 
-    // RMS for AC
-    int64_t vrms = 0;
-    for(i = 0; i < 5; i++)
+/***	DMM_DGetStatusPolled
+**
+**	Parameters:
+**      uint8_t *pbErr - Pointer to the error parameter, the error can be set to:
+**          ERRVAL_SUCCESS           0       // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**
+**	Return Value:
+**		double 
+**          the value computed according to the convertor / RMS registers values, or
+**          NAN (not a number) value if the convertor / RMS registers value is not ready or if ERRVAL_DMM_IDXCONFIG was set, or
+**          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
+**	Description:
+**		This function has the same behavior as DMM_DGetStatus, but it only reads the INTF register. 
+**      If the conversion done bit of the current scale is not set, NAN is returned. 
+**      Otherwise only the needed registers are read: RMS for AC scales, AD1 for the other scales, 
+**      and the value is computed by calling DMM_DStatusToValue.
+**      The SPI bytes saved compared to DMM_DGetStatus are added to the counter returned by DMM_GetPollSavedBytes.
+**            
+*/
+double DMM_DGetStatusPolled(uint8_t *pbErr)
+{
+    // 1. Verify index
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    if(bResult != ERRVAL_SUCCESS)
     {
-        vrms <<= 8;
-        vrms |= dmmsts.rms[4-i];
+        if(pbErr)
+        {
+            *pbErr = bResult;
+        }
+        return NAN;
+    }
+    DMMSTS dmmsts = {{0}}; // registers 0x00 - 0x1F, only the needed ones are read
+    uint8_t fAC = DMM_FACScale(idxCurrentScale);
+    uint8_t bReadyMask = fAC ? DMM_INTF_RMS: DMM_INTF_AD1;
+    
+    // 2. read the INTF register
+    DMM_GetCmdSPI((DMM_REG_INTF << 1) | 1, 1, &dmmsts.intf);
+    if(!(dmmsts.intf & bReadyMask))
+    {
+        // not ready: 2 bytes transferred instead of 33
+        cbPollSaved += 1 + sizeof(dmmsts) - 2;
+        if(pbErr)
+        {
+            *pbErr = ERRVAL_SUCCESS;
+        }
+        return NAN;
+    }
+    
+    // 3. read the data registers
+    if(fAC)
+    {
+        DMM_GetCmdSPI((DMM_REG_RMS << 1) | 1, sizeof(dmmsts.rms), dmmsts.rms);
+        cbPollSaved += 1 + sizeof(dmmsts) - (2 + 1 + sizeof(dmmsts.rms));
+    }
+    else
+    {
+        DMM_GetCmdSPI((DMM_REG_AD1 << 1) | 1, sizeof(dmmsts.ad1), dmmsts.ad1);
+        cbPollSaved += 1 + sizeof(dmmsts) - (2 + 1 + sizeof(dmmsts.ad1));
     }
+    
+    // 4. Compute value, according to the specific scale
+    return DMM_DStatusToValue(&dmmsts, pbErr);
+}
 
-    if(DMM_FACScale(idxCurrentScale))
-    { // AC uses RMS
-        if(dmmsts.intf & 0x10)
-        { // conversion done
-            if(fUseCalib)
-            { 
-                // apply calibration coefficients
-                v = sqrt(fabs(pow(dmmcfg[idxCurrentScale].mul,2)*(double)(vrms) - pow(calib.Dmm[idxCurrentScale].Add,2)))*(1.0+calib.Dmm[idxCurrentScale].Mult);
-            }
-            else
-            {
-                v = dmmcfg[idxCurrentScale].mul*sqrt((double)vrms);             
-            }
-        }   
-        else
+/***	DMM_FGetCode
+**
+**	Parameters:
+**      uint8_t fAC         - 1 for AC scales (RMS register), 0 for the other scales (AD1 register)
+**      int64_t *pCode      - pointer to the variable receiving the raw code
+**
+**	Return Value:
+**		uint8_t     - 1 if the conversion was done and the code was read, 0 if the conversion is not ready
+**
+**	Description:
+**		This function reads the INTF register and, if the conversion done bit is set, the RMS or AD1 registers. 
+**      The AD1 code is sign extended, the RMS code is the unsigned 40 bits register value.
+**      The function is called by DMM_GetSamples and DMM_WaitSettled.
+**            
+*/
+uint8_t DMM_FGetCode(uint8_t fAC, int64_t *pCode)
+{
+    int i;
+    uint8_t bIntf, rgbData[5];
+    int64_t code = 0;
+    DMM_GetCmdSPI((DMM_REG_INTF << 1) | 1, 1, &bIntf);
+    if(!(bIntf & (fAC ? DMM_INTF_RMS: DMM_INTF_AD1)))
+    {
+        return 0;
+    }
+    if(fAC)
+    {
+        DMM_GetCmdSPI((DMM_REG_RMS << 1) | 1, 5, rgbData);
+        for(i = 4; i >= 0; i--)
         {
-            v = NAN; // not ready
+            code = (code << 8) | rgbData[i];
         }
     }
     else
-    { // AD1 value
-        if(dmmsts.intf & 0x04)
-        { // conversion done
-            if(vad1 >= 0x7FFFFE)
-            {
-                v = INFINITY;   // value outside convertor range
-            }
-            else
+    {
+        DMM_GetCmdSPI((DMM_REG_AD1 << 1) | 1, 3, rgbData);
+        code = (int32_t)(((uint32_t)rgbData[2] << 24) | ((uint32_t)rgbData[1] << 16) | ((uint32_t)rgbData[0] << 8)) / 256;
+    }
+    *pCode = code;
+    return 1;
+}
+
+/***	DMM_GetConv
+**
+**	Parameters:
+**      uint8_t *pbErr      - Pointer to the error parameter, the error can be set to:
+**          ERRVAL_SUCCESS           0       // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**
+**	Return Value:
+**		DMMCONV *   - the conversion coefficients of the current scale, according to DMM_SetUseCalib, or
+**                    NULL if there is no valid current scale
+**
+**	Description:
+**		This function returns the cached conversion coefficients of the current scale, building the cache if it was invalidated. 
+**      The cache holds the coefficients both with and without calibration, so that DMM_SetUseCalib only selects one of them.
+**      The error is copied on the byte pointed by pbErr, if pbErr is not null.
+**            
+*/
+DMMCONV *DMM_GetConv(uint8_t *pbErr)
+{
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    if(pbErr)
+    {
+        *pbErr = bResult;
+    }
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return NULL;
+    }
+    if(!fConvCacheValid)
+    {
+        DMM_BuildConvCache();
+    }
+    return &rgConvCache[fUseCalib ? 1: 0];
+}
+
+/***	DMM_BuildConvCache
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function computes the conversion coefficients of the current scale (which must be valid), without and with calibration: 
+**      the combined DC gain and offset, the AC squared terms, the fixed point coefficients and the unit data. 
+**      For AC scales the value is sqrt(|rms * 2^22 - rmsOffset|) * dGain, the square root having 11 fractional bits 
+**      (see DMM_RmsSqrtQ11): with calibration rmsOffset = (Add / mul)^2 * 2^22, dGain = mul * (1 + Mult) / 2^11, 
+**      without calibration rmsOffset = 0, dGain = mul / 2^11. 
+**      This is the same value as sqrt(|mul^2 * rms - Add^2|) * (1 + Mult). 
+**      For the other scales the value is dGain * ad1 + dOffset: with calibration dGain = mul * (1 + Mult), dOffset = Add, 
+**      without calibration dGain = mul, dOffset = 0.
+**            
+*/
+void DMM_BuildConvCache()
+{
+    int f;
+    DMMCONV *pConv;
+    double dMul = dmmcfg[idxCurrentScale].mul;
+    double dMult = calib.Dmm[idxCurrentScale].Mult;
+    double dAdd = calib.Dmm[idxCurrentScale].Add;
+    uint8_t fAC = DMM_FACScale(idxCurrentScale);
+    for(f = 0; f < 2; f++)
+    {
+        pConv = &rgConvCache[f];
+        if(fAC)
+        {
+            pConv->dGain = ldexp(f ? dMul * (1.0 + dMult): dMul, -11);
+            pConv->dOffset = 0.0;
+            pConv->rmsOffset = 0;
+            if(f)
             {
-                if(vad1 <= -0x7FFFFE)
+                if(DMM_IsNotANumber(dMult) || DMM_IsNotANumber(dAdd))
                 {
-                   v = -INFINITY;   // value outside convertor range
+                    pConv->dGain = NAN;     // same result as the double computation
+                }
+                else
+                {
+                    pConv->rmsOffset = llround(ldexp((dAdd / dMul) * (dAdd / dMul), 22));
                 }
-               else
-               {
-                    v = dmmcfg[idxCurrentScale].mul*vad1;
-                    if(fUseCalib)
-                    {
-                       // apply calibration coefficients
-                       v = v*(1.0+calib.Dmm[idxCurrentScale].Mult) + calib.Dmm[idxCurrentScale].Add;
-                    }
-                }   
             }
         }
         else
         {
-            v = NAN; // not ready
+            pConv->dGain = f ? dMul * (1.0 + dMult): dMul;
+            pConv->dOffset = f ? dAdd: 0.0;
+            pConv->rmsOffset = 0;
         }
+        pConv->bFixErr = DMM_FixCompute(&pConv->fix, f);
     }
-    if(pbErr)
+    DMM_GetScaleUnit(idxCurrentScale, &dConvScaleFact, szConvUnitPrefix, szConvUnit);
+    fConvCacheValid = 1;
+}
+
+/***	DMM_InvalidateConvCache
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function invalidates the conversion coefficients cache, so that it is built again on the next conversion. 
+**      It must be called when the current scale or the calibration coefficients (calib) change. 
+**      It is called by DMM_SetScale and by the CALIB functions that change the calibration coefficients.
+**            
+*/
+void DMM_InvalidateConvCache()
+{
+    fConvCacheValid = 0;
+}
+
+/***	DMM_FixCompute
+**
+**	Parameters:
+**      DMMFIX *pFix        - pointer to the structure receiving the fixed point coefficients
+**      uint8_t fCalib      - 1 if the calibration coefficients are applied, 0 otherwise
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CALIB_NANDOUBLE      0xFB    // error, the calibration coefficients are not numbers
+**
+**	Description:
+**		This function computes the fixed point conversion coefficients of the current scale (which must be valid), 
+**      see DMM_FixPrepare. The function is called by DMM_BuildConvCache.
+**            
+*/
+uint8_t DMM_FixCompute(DMMFIX *pFix, uint8_t fCalib)
+{
+    double dMul, dAdd, dUnit, dLin;
+    pFix->idxScale = idxCurrentScale;
+    pFix->fAC = DMM_FACScale(idxCurrentScale);
+    pFix->exp = DMM_FIX_DIGITS - (int8_t)ceil(log10(dmmcfg[idxCurrentScale].range));
+    dUnit = pow(10, pFix->exp);
+    dMul = dmmcfg[idxCurrentScale].mul;
+    dAdd = fCalib ? calib.Dmm[idxCurrentScale].Add: 0;
+    if(fCalib)
     {
-        *pbErr = ERRVAL_SUCCESS;
-    }    
-    return v;
+        dMul *= 1.0 + calib.Dmm[idxCurrentScale].Mult;
+    }
+    if(DMM_IsNotANumber(dMul) || DMM_IsNotANumber(dAdd))
+    {
+        return ERRVAL_CALIB_NANDOUBLE;
+    }
+    pFix->fCubic = 0;
+    pFix->offset = 0;
+    pFix->rmsOffset = 0;
+    if(pFix->fAC)
+    {
+        // v = mul * (1 + Mult) * sqrt(|rms - (Add / mul)^2|), see DMM_DStatusToValue
+        pFix->shift = DMM_FixQ31(dMul * dUnit, &pFix->gain);
+        pFix->rmsOffset = llround(ldexp(pow(dAdd / dmmcfg[idxCurrentScale].mul, 2), 22));
+        return ERRVAL_SUCCESS;
+    }
+    pFix->shift = DMM_FixQ31(dMul * dUnit, &pFix->gain);
+    pFix->offset = llround(dAdd * dUnit);
+    if(idxCurrentScale == DMMVoltageDC50Scale)
+    {
+        // v * v * v * P3 + v * (P1 + P0), see DMM_CompensateVoltage50DCLinear
+        pFix->fCubic = 1;
+        dLin = DMM_Voltage50DCLinearCoeff_P1 + DMM_Voltage50DCLinearCoeff_P0;
+        pFix->shiftLin = DMM_FixQ31(dMul * dUnit * dLin, &pFix->gainLin);
+        pFix->offsetLin = llround(dAdd * dUnit * dLin);
+        pFix->shiftT = DMM_FixQ31(dMul * 1e5, &pFix->gainT);
+        pFix->offsetT = llround(dAdd * 1e5);
+        pFix->shiftC = DMM_FixQ31(DMM_Voltage50DCLinearCoeff_P3 * dUnit * 1e-15, &pFix->cubic);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMM_FixQ31
+**
+**	Parameters:
+**      double dVal         - the value to be represented, not 0
+**      int32_t *pMant      - pointer to the variable receiving the mantissa
+**
+**	Return Value:
+**		uint8_t     - the binary point position (shift)
+**
+**	Description:
+**		This function represents a value as mantissa / 2^shift, the mantissa magnitude being between 2^30 and 2^31, 
+**      so that it keeps 31 significant bits. The function is called by DMM_FixPrepare.
+**            
+*/
+uint8_t DMM_FixQ31(double dVal, int32_t *pMant)
+{
+    int e2;
+    int64_t mant;
+    frexp(dVal, &e2);
+    mant = llround(ldexp(dVal, 31 - e2));
+    if(mant >= 0x80000000LL || mant < -0x7FFFFFFFLL)
+    {
+        // rounded up to 2^31
+        e2++;
+        mant = llround(ldexp(dVal, 31 - e2));
+    }
+    *pMant = (int32_t)mant;
+    return (uint8_t)(31 - e2);
+}
+
+/***	DMM_RmsSqrtQ11
+**
+**	Parameters:
+**      int64_t code        - the RMS register value
+**      int64_t rmsOffset   - the value subtracted from the code, Q22
+**
+**	Return Value:
+**		uint32_t    - sqrt(|code - rmsOffset / 2^22|), Q11, rounded to nearest
+**
+**	Description:
+**		This function computes the square root of the offset RMS code with 11 fractional bits, using DMM_ISqrt64. 
+**      The RMS register has 40 bits, so the Q22 code fits in 62 bits. 
+**      The function is called by DMM_DStatusToValue and DMM_CodesToValues, the result is multiplied by the cached AC gain.
+**            
+*/
+uint32_t DMM_RmsSqrtQ11(int64_t code, int64_t rmsOffset)
+{
+    uint32_t r;
+    int64_t x = (code << 22) - rmsOffset;
+    if(x < 0)
+    {
+        x = -x;
+    }
+    r = DMM_ISqrt64((uint64_t)x);
+    // round: x >= (r + 0.5)^2 = r^2 + r + 0.25
+    if((uint64_t)x - (uint64_t)r * r > r)
+    {
+        r++;
+    }
+    return r;
+}
+
+/***	DMM_ReadStatusDone
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function is called when the status burst read started by DMM_StartReadStatus is completed.
+**      It deactivates the DMM Slave Select pin, clears the busy flag and calls the user completion function.
+**      For the SPI hardware transport it is called from the DMA interrupt.
+**            
+*/
+void DMM_ReadStatusDone()
+{
+    GPIO_SetValue_CS_DMM(1); // Deactivate CS_DMM
+    SPI_UnlockBus();
+    fReadStatusBusy = 0;
+    if(pfnReadStatusDone)
+    {
+        pfnReadStatusDone();
+    }
 }
 
 /***	DMM_CompensateVoltage50DCLinear
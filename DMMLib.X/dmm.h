@@ -31,6 +31,8 @@
 /* ************************************************************************** */
 /* ************************************************************************** */
 #include "stdint.h"
+#include "math.h"
+#include "dmmstats.h"
 
 
 
@@ -46,6 +48,9 @@ extern "C" {
 /* ************************************************************************** */
     
 #define DMM_DIODEOPENTHRESHOLD      3
+// the library uses its own values, regardless of the math.h definitions
+#undef INFINITY
+#undef NAN
 #define INFINITY        1e+308      // value used when the retrieved data exceeds the convertors range
 #define NAN             0.0f/0.0f   // value used when no proper data is available
     
@@ -63,6 +68,80 @@ extern "C" {
 #define DMM_CNTSCALES                 27    // the number of scales
 #define DMM_VALIDDATA_CNTTIMEOUT    0x100   // number of valid data retrieval re-tries
 #define DMMVoltageDC50Scale          7
+
+// DMM_DGetValue ready polling modes, see DMM_SetPollMode
+#define DMM_POLL_FULLSTATUS         0   // read the whole status block (registers 0x00 - 0x1F) on each attempt
+#define DMM_POLL_INTF               1   // read only the INTF register until ready, then only the needed data registers
+
+// Set to 1 once it is confirmed on the hardware that reading the INTF register clears the conversion done flags.
+// The conversion flush and the interrupt driven acquisition (DMMACQ) rely on it. Both polling modes test the same INTF bits: 
+// without it, a conversion may be read more than once by DMM_DGetValue, whatever the polling mode.
+#ifndef DMM_INTF_READCLEAR
+#define DMM_INTF_READCLEAR          0
+#endif
+#ifndef DMM_CONV_TUS
+#define DMM_CONV_TUS                1000    // conversion period (us) of the converter, as configured by DMM_SetScale, see MAINS_DGetAvgValue
+#endif
+#ifndef DMM_FLUSH_TIMEOUT
+#define DMM_FLUSH_TIMEOUT           500     // without DMM_INTF_READCLEAR, maximum wait (10 us units) for a new conversion code, see DMM_FlushConversion and DMM_GetSamples
+#endif
+
+// configuration registers, see DMM_SetScale
+#define DMM_CFG_CNTREGS             24  // the number of configuration registers (0x1F - 0x36)
+#define DMM_CFG_MERGEGAP            4   // changed registers separated by at most this number of unchanged registers are written by the same command
+
+// scale switching settling delays, in 10 us units, see DMM_SetScale. They can be tuned at build time.
+#ifndef DMM_SETTLE_RELAYDROP
+#define DMM_SETTLE_RELAYDROP        100     // the switches are released before a relays change
+#endif
+#ifndef DMM_SETTLE_RELAY
+#define DMM_SETTLE_RELAY            500     // relays operate and bounce, after a relays change
+#endif
+#ifndef DMM_SETTLE_ANALOG
+#define DMM_SETTLE_ANALOG           1000    // analog settling, after a relays change
+#endif
+#ifndef DMM_SETTLE_ANALOG_DC
+#define DMM_SETTLE_ANALOG_DC        100     // analog settling, same relays, DC voltage and current scales
+#endif
+#ifndef DMM_SETTLE_ANALOG_AC
+#define DMM_SETTLE_ANALOG_AC        500     // analog settling, same relays, AC scales
+#endif
+#ifndef DMM_SETTLE_ANALOG_RES
+#define DMM_SETTLE_ANALOG_RES       1000    // analog settling, same relays, resistance, continuity and diode scales
+#endif
+#define DMM_SETTLE_ANYSW            0xFF    // settling table: any switches
+#define DMM_SETTLE_SAMESW           0xFE    // settling table: the switches do not change
+#define DMM_SETTLE_ANYMODE          0       // settling table: any mode
+
+// settle detection (AD1 scales), see DMM_SetSettleDetect. The noise bands can be tuned at build time or for each scale using DMM_SetSettleBand.
+#ifndef DMM_SETTLE_BAND
+#define DMM_SETTLE_BAND             16      // default noise band, AD1 codes
+#endif
+#ifndef DMM_SETTLE_CNTSTABLE
+#define DMM_SETTLE_CNTSTABLE        2       // codes read after the drift window, all within the noise band, needed to release the samples
+#endif
+#ifndef DMM_SETTLE_WNDDIV
+#define DMM_SETTLE_WNDDIV           8       // drift window = maximum wait / DMM_SETTLE_WNDDIV, about 2 time constants of a settling to 1 code in the maximum wait
+#endif
+#ifndef DMM_SETTLE_MINDETECT
+#define DMM_SETTLE_MINDETECT        300     // shorter maximum waits (10 us units) are waited without detection, as they are shorter than the conversions needed
+#endif
+
+// status registers
+#define DMM_REG_AD1                 0x00
+#define DMM_REG_RMS                 0x09
+#define DMM_REG_INTF                0x1E
+#define DMM_REG_INTE                0x1F    // interrupt enable, same bits as INTF
+#define DMM_REG_CFG                 0x1F    // the first configuration register
+#define DMM_INTF_AD1                0x04    // AD1 conversion done
+#define DMM_INTF_RMS                0x10    // RMS conversion done
+
+// raw sample flags, see DMMSAMPLE
+#define DMMSAMPLE_FLAG_RMS          0x01    // the code is the RMS register (AC scales), otherwise the AD1 register
+
+// fixed point values, see DMM_FixCodeToValue
+#define DMM_FIX_INFINITY            INT64_MAX   // value outside the convertor range, negated for negative values
+#define DMM_FIX_DIGITS              12          // the full scale range is expressed on about 12 decimal digits
     
 #define DMM_Voltage50DCLinearCoeff_P3   -1.59128E-06
 #define DMM_Voltage50DCLinearCoeff_P1   1.003918916
@@ -87,6 +166,16 @@ typedef struct _DMMCFG{
     double calibAcceptN;    // the calibration acceptance negative percentage
 } DMMCFG;
 
+// settling delays of a scale transition, in 10 us units, see DMM_SetScale
+typedef struct _DMMSETTLE{
+    uint8_t swFrom;     // the switches before the transition, or DMM_SETTLE_ANYSW
+    uint8_t swTo;       // the switches after the transition, DMM_SETTLE_ANYSW or DMM_SETTLE_SAMESW
+    int mode;           // the mode of the new scale, or DMM_SETTLE_ANYMODE
+    uint16_t dlyDrop;   // the switches are released during this delay
+    uint16_t dlyRelay;  // between the configuration write and the verify
+    uint16_t dlyAnalog; // after the verify
+} DMMSETTLE;
+
 // registers from 0x00 to 0x1F
 typedef struct _DMMSTS{
     uint8_t ad1[3];
@@ -103,6 +192,44 @@ typedef struct _DMMSTS{
     uint8_t inte;
 } DMMSTS;
 
+// raw sample, converted to value by DMM_DSampleToValue
+typedef struct _DMMSAMPLE{
+    int64_t code;       // AD1 signed code or RMS register value
+    uint32_t tstamp;    // HAL_GetTicks value when the sample was acquired
+    int8_t idxScale;    // the scale the sample was acquired on
+    uint8_t flags;      // DMMSAMPLE_FLAG_...
+} DMMSAMPLE;
+
+
+// fixed point conversion coefficients of a scale, computed by DMM_FixPrepare
+typedef struct _DMMFIX{
+    int idxScale;       // the scale the coefficients were computed for
+    int8_t exp;         // the fixed point values are expressed in 10^-exp units of the scale unit
+    uint8_t fAC;        // 1 for AC scales (RMS register), 0 for the other scales (AD1 register)
+    uint8_t fCubic;     // 1 when the VoltageDC50 cubic compensation is applied
+    uint8_t shift;      // binary point of gain
+    int32_t gain;       // output units per AD1 code (DC) or per square root of RMS code (AC), Q(shift)
+    int64_t offset;     // DC: output units added after the gain
+    int64_t rmsOffset;  // AC: RMS code subtracted before the square root, Q22
+    // VoltageDC50 compensation
+    uint8_t shiftLin;   // binary point of gainLin
+    int32_t gainLin;    // linear compensation gain, Q(shiftLin)
+    int64_t offsetLin;  // linear compensation offset, output units
+    uint8_t shiftT;     // binary point of gainT
+    int32_t gainT;      // 10 uV units per AD1 code, Q(shiftT)
+    int64_t offsetT;    // 10 uV units offset
+    uint8_t shiftC;     // binary point of cubic
+    int32_t cubic;      // cubic coefficient, output units per (10 uV)^3, Q(shiftC)
+} DMMFIX;
+
+// conversion coefficients of the current scale, cached by the DMM module
+typedef struct _DMMCONV{
+    double dGain;       // DC: value per AD1 code. AC: value per Q11 square root unit, see DMM_RmsSqrtQ11
+    double dOffset;     // DC: added after the gain
+    int64_t rmsOffset;  // AC: subtracted from the RMS code before the square root, Q22
+    DMMFIX fix;         // fixed point coefficients, see DMM_FixPrepare
+    uint8_t bFixErr;    // error raised when the fixed point coefficients were computed
+} DMMCONV;
 
 // calibration values
 
@@ -146,14 +273,37 @@ void DMM_Init();
 
 // configuration functions
 uint8_t DMM_SetScale(int idxScale);
+void DMM_InvalidateCfgShadow();
+uint32_t DMM_GetCfgBytes();
+void DMM_ResetCfgBytes();
+void DMM_SetSettleDetect(uint8_t f);
+uint8_t DMM_SetSettleBand(int idxScale, uint32_t band);
+uint32_t DMM_GetSettleTime(uint8_t *pfDetected);
 int DMM_GetCurrentScale();
 double DMM_GetScaleRange(int idxScale);
+int DMM_GetScaleMode(int idxScale);
+uint8_t DMM_GetScaleSwitches(int idxScale);
 
 
 // value functions
 double DMM_DGetValue(uint8_t *pbErr);
 double DMM_DGetAvgValue(int cbSamples, uint8_t *pbErr);
+uint8_t DMM_AcquireStats(int cntValues, DMMSTATS *pStats);
+uint8_t DMM_GetSamples(int64_t *pCodes, int cntSamples);
+uint8_t DMM_CodesToValues(int64_t *pCodes, double *pdValues, int cntSamples);
+uint8_t DMM_FixPrepare(DMMFIX *pFix);
+int64_t DMM_FixCodeToValue(DMMFIX *pFix, int64_t code);
+uint32_t DMM_ISqrt64(uint64_t x);
+uint8_t DMM_FixCodesToValues(int64_t *pCodes, int64_t *pValues, int cntSamples, int8_t *pExp);
+uint8_t DMM_StartReadStatus(DMMSTS *pDmmSts, void (*pfnDone)());
+uint8_t DMM_FReadStatusBusy();
+double DMM_DStatusToValue(DMMSTS *pDmmSts, uint8_t *pbErr);
+uint8_t DMM_FStatusToSample(DMMSTS *pDmmSts, DMMSAMPLE *pSample, uint32_t tstamp);
+double DMM_DSampleToValue(DMMSAMPLE *pSample, uint8_t *pbErr);
 void DMM_SetUseCalib(uint8_t f);
+void DMM_SetPollMode(uint8_t bMode);
+uint32_t DMM_GetPollSavedBytes();
+void DMM_ResetPollSavedBytes();
 uint8_t DMM_CheckAcceptedMeasurementDispersion(double dMeasuredVal, double dRefVal, double *pDispersion);
 uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit);
 uint8_t DMM_InterpretValue(char *pString, double *pdVal);
@@ -0,0 +1,340 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmacq.c
+
+  @Description
+        This file groups the functions that implement the DMMACQ module (interrupt driven acquisition).
+        Instead of polling the converter, the conversion done flag of the current scale (AD1 for DC, RMS for AC) 
+        is enabled in the converter INTE register, so that the converter interrupt output triggers the PIC32 
+        external interrupt selected by HAL_DMMINT (see hal.h).
+        The interrupt handler reads the INTF register (which clears the converter flags and deactivates the interrupt output), 
+        then the AD1 or RMS registers, and pushes the raw sample (see DMM_FStatusToSample) in a SMPRING ring.
+        The main loop retrieves the samples using DMMACQ_GetSample and converts them using DMM_DSampleToValue.
+        The ring has a single producer (the interrupt handler) and a single consumer (the main loop), so it needs no lock.
+        The SPI bus is shared with the main loop transactions: while the bus is locked (see SPI_LockBus) 
+        the external interrupt is disabled, and a conversion done edge is serviced when the bus is unlocked.
+        While the acquisition is running, DMM_DGetValue, DMM_DGetAvgValue and DMM_SetScale must not be called, 
+        as they read / reset the converter flags.
+        The interrupt handler transfers about 50 bits, so the bit bang transport (20 us per bit) cannot follow a 1 ms 
+        conversion period and would starve the main loop: the acquisition is only available with the hardware SPI transport 
+        (SPI_TRANSPORT_HW, see spi.h). A new edge is only generated once the INTF read cleared the flags, so the acquisition 
+        also requires DMM_INTF_READCLEAR (see dmm.h). Otherwise DMMACQ_Start returns ERRVAL_DMMACQ_UNAVAILABLE.
+        On host the converter interrupt is driven by the DMMSIM model and the external interrupt is emulated by the host HAL.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, interrupt driven acquisition
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stddef.h>
+#include "stdint.h"
+#include "hal.h"
+#include "spi.h"
+#include "dmm.h"
+#include "dmmacq.h"
+#include "smpring.h"
+#include "errors.h"
+#include "utils.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void DMMACQ_IntHandler();
+void DMMACQ_BusLockHook(uint8_t fLocked);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData);
+void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData);
+uint8_t DMM_FACScale(int idxScale);
+uint8_t DMM_ERR_CheckIdxCalib(int idxScale);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+DMMSAMPLE rgAcqSamples[DMMACQ_QUEUESIZE];
+SMPRING ringAcq;    // produced by the interrupt handler, consumed by the main loop
+volatile uint8_t fAcqRunning = 0;
+uint8_t fAcqAC = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMACQ_Start
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**          ERRVAL_DMMACQ_UNAVAILABLE 0xE5   // error, not built with the hardware SPI transport and DMM_INTF_READCLEAR
+**
+**	Description:
+**		This function starts the interrupt driven acquisition for the current scale (selected by DMM_SetScale). 
+**      It empties the samples ring, configures the external interrupt, enables the conversion done interrupt of the converter 
+**      (RMS for AC scales, AD1 for the other scales), clears the pending converter flags and enables the external interrupt.
+**      If the acquisition is already running, it is restarted.
+**      The interrupt handler reads the converter on the SPI bus, which only fits in a conversion period 
+**      with the hardware SPI transport, and relies on the INTF read clearing the converter flags: 
+**      ERRVAL_DMMACQ_UNAVAILABLE is returned unless the hardware SPI transport and DMM_INTF_READCLEAR are built in.
+**            
+*/
+uint8_t DMMACQ_Start()
+{
+#if (SPI_TRANSPORT == SPI_TRANSPORT_HW) && DMM_INTF_READCLEAR
+    uint8_t bInte, bIntf;
+    int idxScale = DMM_GetCurrentScale();
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    DMMACQ_Stop();
+    fAcqAC = DMM_FACScale(idxScale);
+    SMPRING_Init(&ringAcq, rgAcqSamples, DMMACQ_QUEUESIZE);
+    HAL_ExtIntInit(DMMACQ_IntHandler);
+    SPI_SetBusLockHook(DMMACQ_BusLockHook);
+
+    // enable the converter interrupt output
+    bInte = fAcqAC ? DMM_INTF_RMS: DMM_INTF_AD1;
+    DMM_SendCmdSPI(DMM_REG_INTE << 1, 1, &bInte);
+    // clear the pending flags, so that the next conversion generates an edge
+    DMM_GetCmdSPI((DMM_REG_INTF << 1) | 1, 1, &bIntf);
+
+    fAcqRunning = 1;
+    HAL_ExtIntEnable(1);
+    return ERRVAL_SUCCESS;
+#else
+    return ERRVAL_DMMACQ_UNAVAILABLE;
+#endif
+}
+
+/***	DMMACQ_Stop
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function stops the interrupt driven acquisition: it disables the external interrupt and the converter interrupt output.
+**      The samples already in the ring can still be retrieved.
+**            
+*/
+void DMMACQ_Stop()
+{
+    uint8_t bInte = 0;
+    if(!fAcqRunning)
+    {
+        return;
+    }
+    fAcqRunning = 0;
+    HAL_ExtIntEnable(0);
+    SPI_SetBusLockHook(NULL);
+    DMM_SendCmdSPI(DMM_REG_INTE << 1, 1, &bInte);
+}
+
+/***	DMMACQ_FRunning
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint8_t     - 1 if the acquisition is running, 0 otherwise
+**
+**	Description:
+**		This function returns the acquisition state.
+**            
+*/
+uint8_t DMMACQ_FRunning()
+{
+    return fAcqRunning;
+}
+
+/***	DMMACQ_GetCount
+**
+**	Parameters:
+**
+**	Return Value:
+**		int     - the number of samples in the ring
+**
+**	Description:
+**		This function returns the number of samples that can be retrieved using DMMACQ_GetSample.
+**            
+*/
+int DMMACQ_GetCount()
+{
+    return (int)SMPRING_GetCount(&ringAcq);
+}
+
+/***	DMMACQ_GetSample
+**
+**	Parameters:
+**      DMMSAMPLE *pSample  - pointer to the structure receiving the sample
+**
+**	Return Value:
+**		uint8_t     - 1 if a sample was retrieved, 0 if the ring is empty
+**
+**	Description:
+**		This function removes the oldest sample from the ring, without waiting.
+**            
+*/
+uint8_t DMMACQ_GetSample(DMMSAMPLE *pSample)
+{
+    return SMPRING_Pop(&ringAcq, pSample);
+}
+
+/***	DMMACQ_WaitSample
+**
+**	Parameters:
+**      DMMSAMPLE *pSample      - pointer to the structure receiving the sample
+**      uint32_t tusTimeout     - the maximum waiting time, in microseconds
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // no sample was acquired within the timeout
+**
+**	Description:
+**		This function removes the oldest sample from the ring, waiting for it if the ring is empty. 
+**      The timeout is measured using the timestamp counter.
+**            
+*/
+uint8_t DMMACQ_WaitSample(DMMSAMPLE *pSample, uint32_t tusTimeout)
+{
+    uint32_t tStart = HAL_GetTicks();
+    while(!DMMACQ_GetSample(pSample))
+    {
+        if(HAL_GetTicks() - tStart >= tusTimeout * (HAL_TICKS_FRQ / 1000000))
+        {
+            return ERRVAL_DMM_VALIDDATATIMEOUT;
+        }
+        DelayAprox10Us(1);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMMACQ_GetOverflows
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint32_t    - the number of lost samples
+**
+**	Description:
+**		This function returns the number of conversions that were dropped because the ring was full, since DMMACQ_Start.
+**            
+*/
+uint32_t DMMACQ_GetOverflows()
+{
+    return SMPRING_GetOverflows(&ringAcq);
+}
+
+/***	DMMACQ_GetHighWater
+**
+**	Parameters:
+**
+**	Return Value:
+**		uint32_t    - the high water mark
+**
+**	Description:
+**		This function returns the maximum number of samples held by the ring, since DMMACQ_Start.
+**      If it approaches DMMACQ_QUEUESIZE, the main loop does not retrieve the samples fast enough.
+**            
+*/
+uint32_t DMMACQ_GetHighWater()
+{
+    return SMPRING_GetHighWater(&ringAcq);
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMACQ_IntHandler
+**
+**	Parameters:
+**
+**	Return Value:
+**
+**	Description:
+**		This function is called from the external interrupt, on the converter interrupt output activation. 
+**      It reads the INTF register and, if the conversion done flag is set, the AD1 or RMS registers, 
+**      and pushes the sample in the ring. When the ring is full the sample is dropped and counted.
+**      The sample is stamped with the timestamp taken on entry, before the SPI transfers.
+**            
+*/
+void DMMACQ_IntHandler()
+{
+    uint32_t tstamp = HAL_GetTicks();
+    DMMSAMPLE sample;
+    DMMSTS dmmsts;
+    
+    DMM_GetCmdSPI((DMM_REG_INTF << 1) | 1, 1, &dmmsts.intf);
+    if(!(dmmsts.intf & (fAcqAC ? DMM_INTF_RMS: DMM_INTF_AD1)))
+    {
+        return;
+    }
+    if(SMPRING_GetCount(&ringAcq) > ringAcq.cntMask)
+    {
+        // the ring is full: the push only counts the overflow, the data registers are not read
+        SMPRING_Push(&ringAcq, &sample);
+        return;
+    }
+    if(fAcqAC)
+    {
+        DMM_GetCmdSPI((DMM_REG_RMS << 1) | 1, sizeof(dmmsts.rms), dmmsts.rms);
+    }
+    else
+    {
+        DMM_GetCmdSPI((DMM_REG_AD1 << 1) | 1, sizeof(dmmsts.ad1), dmmsts.ad1);
+    }
+    DMM_FStatusToSample(&dmmsts, &sample, tstamp);
+    SMPRING_Push(&ringAcq, &sample);
+}
+
+/***	DMMACQ_BusLockHook
+**
+**	Parameters:
+**      uint8_t fLocked     - 1 when the SPI bus is locked, 0 when it is unlocked
+**
+**	Return Value:
+**
+**	Description:
+**		This function is called by the SPI module when the bus lock state changes. 
+**      While the acquisition is running, it disables the external interrupt while the bus is locked.
+**            
+*/
+void DMMACQ_BusLockHook(uint8_t fLocked)
+{
+    if(fAcqRunning)
+    {
+        HAL_ExtIntEnable(!fLocked);
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,51 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmacq.h
+
+  @Description
+        This file contains the declaration for the functions of the DMMACQ module (interrupt driven acquisition).
+        The DMMACQ functions are defined in dmmacq.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, interrupt driven acquisition
+
+ */
+/* ************************************************************************** */
+
+#ifndef _DMMACQ_H    /* Guard against multiple inclusion */
+#define _DMMACQ_H
+
+#include "stdint.h"
+#include "dmm.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define DMMACQ_QUEUESIZE        64      // samples ring size, must be a power of 2
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t DMMACQ_Start();
+void DMMACQ_Stop();
+uint8_t DMMACQ_FRunning();
+int DMMACQ_GetCount();
+uint8_t DMMACQ_GetSample(DMMSAMPLE *pSample);
+uint8_t DMMACQ_WaitSample(DMMSAMPLE *pSample, uint32_t tusTimeout);
+uint32_t DMMACQ_GetOverflows();
+uint32_t DMMACQ_GetHighWater();
+
+#endif /* _DMMACQ_H */
+
+/* *****************************************************************************
+ End of File
+ */
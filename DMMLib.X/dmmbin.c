@@ -0,0 +1,319 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmbin.c
+
+  @Description
+        This file groups the functions that implement the DMMBIN module (binary framed stream of the samples).
+        Each sample is sent as a small binary packet instead of a formatted text line, so that the repeated sessions
+        need a few bytes per sample and no floating point formatting (see DMMCMD_CmdStream).
+        The packet is:
+        - header: the packet type (DMMBIN_PKT_...) in bits 7..5 and the scale index in bits 4..0 (DMMBIN_NOSCALE when not related to a scale),
+        - sequence number, incremented for each packet, so that the receiver detects the packets dropped by the UART transmit ring,
+        - payload, according to the type: for values the decimal exponent (signed byte) followed by the value, for codes the code,
+          for errors the ERRVAL_ code. The codes and values are zigzag varints: the sign is moved to bit 0, then 7 bits
+          are sent per byte, least significant first, bit 7 set when more bytes follow. A 24 bits AD1 code needs at most 4 bytes,
+        - CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF, big endian) of the previous bytes.
+        The packet is framed using COBS (Consistent Overhead Byte Stuffing): the zero bytes are removed at the cost of one byte
+        and a zero byte ends the frame, so that the receiver synchronizes on the next zero byte after an error or a dropped byte.
+        The text replies to the commands are sent between the frames, they contain no zero byte:
+        a receiver can tell them apart by their failing CRC, or wait for the end of line.
+        The binary stream can contain the XON and XOFF characters, so it cannot be used together with the XON/XOFF flow control.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, binary framed stream
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include "stdint.h"
+#include "dmmbin.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int DMMBIN_PutVarint(uint8_t *pBuf, int64_t val);
+int DMMBIN_GetVarint(uint8_t const *pBuf, int len, int64_t *pVal);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Data, local to this module                                 */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t bBinSeq = 0;    // sequence number of the next packet
+
+// CRC-16/CCITT of the 16 values of a nibble, see DMMBIN_Crc16
+const uint16_t rgBinCrcNibble[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+                                     0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMBIN_Reset
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function restarts the sequence numbers from 0, at the beginning of a repeated session.
+**
+*/
+void DMMBIN_Reset()
+{
+    bBinSeq = 0;
+}
+
+/***	DMMBIN_EncodePacket
+**
+**	Parameters:
+**      uint8_t *pFrame     - the buffer receiving the frame, at least DMMBIN_MAXFRAME bytes
+**      uint8_t bType       - the packet type, DMMBIN_PKT_...
+**      int idxScale        - the scale index, DMMBIN_NOSCALE (or a negative value) when not related to a scale
+**      int8_t exp          - DMMBIN_PKT_VALUE and DMMBIN_PKT_AVG: the value is in 10^-exp units of the scale unit
+**      int64_t val         - the code (DMMBIN_PKT_CODE), the value (DMMBIN_PKT_VALUE, DMMBIN_PKT_AVG)
+**                            or the error code (DMMBIN_PKT_ERROR), ignored for the other types
+**
+**	Return Value:
+**		int         - the frame length, including the zero delimiter
+**
+**	Description:
+**		This function builds a packet with the next sequence number (see the module description),
+**      appends its CRC and encodes it using COBS, followed by the zero delimiter. Only integer operations are used.
+**      The sequence number is incremented even if the frame is not sent afterwards, so that the receiver detects the missing frame.
+**
+*/
+int DMMBIN_EncodePacket(uint8_t *pFrame, uint8_t bType, int idxScale, int8_t exp, int64_t val)
+{
+    uint8_t rgPkt[DMMBIN_MAXFRAME - 2];
+    uint16_t crc;
+    int cbPkt = 0, i, idxCode = 0, cbFrame = 1;
+    rgPkt[cbPkt++] = (bType << 5) | ((idxScale < 0) ? DMMBIN_NOSCALE: (idxScale & DMMBIN_NOSCALE));
+    rgPkt[cbPkt++] = bBinSeq++;
+    switch(bType)
+    {
+        case DMMBIN_PKT_VALUE:
+        case DMMBIN_PKT_AVG:
+            rgPkt[cbPkt++] = (uint8_t)exp;
+            cbPkt += DMMBIN_PutVarint(rgPkt + cbPkt, val);
+            break;
+        case DMMBIN_PKT_CODE:
+            cbPkt += DMMBIN_PutVarint(rgPkt + cbPkt, val);
+            break;
+        case DMMBIN_PKT_ERROR:
+            rgPkt[cbPkt++] = (uint8_t)val;
+            break;
+    }
+    crc = DMMBIN_Crc16(rgPkt, cbPkt, DMMBIN_CRC_INIT);
+    rgPkt[cbPkt++] = crc >> 8;
+    rgPkt[cbPkt++] = crc & 0xFF;
+    // COBS: each zero byte is replaced by the distance to the next one, the first distance is sent first
+    for(i = 0; i < cbPkt; i++)
+    {
+        if(rgPkt[i])
+        {
+            pFrame[cbFrame++] = rgPkt[i];
+        }
+        else
+        {
+            pFrame[idxCode] = cbFrame - idxCode;
+            idxCode = cbFrame++;
+        }
+    }
+    pFrame[idxCode] = cbFrame - idxCode;
+    pFrame[cbFrame++] = 0;
+    return cbFrame;
+}
+
+/***	DMMBIN_DecodeFrame
+**
+**	Parameters:
+**      uint8_t const *pFrame   - the received frame, with or without the zero delimiter
+**      int cbFrame             - the frame length
+**      DMMBINPKT *pPkt         - the decoded packet
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMMBIN_FRAME         0xE6    // wrong COBS encoding, CRC or packet length
+**
+**	Description:
+**		This function decodes a frame built by DMMBIN_EncodePacket. It is provided for the receiving side
+**      (it is used by the host benchmark), it is not needed to send the stream.
+**
+*/
+uint8_t DMMBIN_DecodeFrame(uint8_t const *pFrame, int cbFrame, DMMBINPKT *pPkt)
+{
+    uint8_t rgPkt[DMMBIN_MAXFRAME];
+    int cbPkt = 0, i = 0, cbBlock, cbVal = 0;
+    if(cbFrame > 0 && pFrame[cbFrame - 1] == 0)
+    {
+        cbFrame--;
+    }
+    if(cbFrame > DMMBIN_MAXFRAME)
+    {
+        return ERRVAL_DMMBIN_FRAME;
+    }
+    while(i < cbFrame)
+    {
+        cbBlock = pFrame[i++];
+        if(cbBlock == 0 || i + cbBlock - 1 > cbFrame)
+        {
+            return ERRVAL_DMMBIN_FRAME;
+        }
+        for(; --cbBlock; i++)
+        {
+            if(!pFrame[i])
+            {
+                return ERRVAL_DMMBIN_FRAME;
+            }
+            rgPkt[cbPkt++] = pFrame[i];
+        }
+        if(i < cbFrame)
+        {
+            rgPkt[cbPkt++] = 0;
+        }
+    }
+    // the CRC of the packet including its CRC is 0
+    if(cbPkt < 4 || DMMBIN_Crc16(rgPkt, cbPkt, DMMBIN_CRC_INIT))
+    {
+        return ERRVAL_DMMBIN_FRAME;
+    }
+    cbPkt -= 2;
+    pPkt->bType = rgPkt[0] >> 5;
+    pPkt->idxScale = ((rgPkt[0] & DMMBIN_NOSCALE) == DMMBIN_NOSCALE) ? -1: (rgPkt[0] & DMMBIN_NOSCALE);
+    pPkt->bSeq = rgPkt[1];
+    pPkt->exp = 0;
+    pPkt->val = 0;
+    switch(pPkt->bType)
+    {
+        case DMMBIN_PKT_VALUE:
+        case DMMBIN_PKT_AVG:
+            pPkt->exp = (cbPkt > 2) ? (int8_t)rgPkt[2]: 0;
+            cbVal = (cbPkt > 3) ? DMMBIN_GetVarint(rgPkt + 3, cbPkt - 3, &pPkt->val): 0;
+            cbVal = cbVal ? cbVal + 1: 0;
+            break;
+        case DMMBIN_PKT_CODE:
+            cbVal = DMMBIN_GetVarint(rgPkt + 2, cbPkt - 2, &pPkt->val);
+            break;
+        case DMMBIN_PKT_ERROR:
+            cbVal = (cbPkt == 3);
+            pPkt->val = rgPkt[2];
+            break;
+        case DMMBIN_PKT_OVERLOADP:
+        case DMMBIN_PKT_OVERLOADN:
+            return (cbPkt == 2) ? ERRVAL_SUCCESS: ERRVAL_DMMBIN_FRAME;
+    }
+    return (cbVal && cbVal == cbPkt - 2) ? ERRVAL_SUCCESS: ERRVAL_DMMBIN_FRAME;
+}
+
+/***	DMMBIN_Crc16
+**
+**	Parameters:
+**      uint8_t const *pBuf     - the buffer
+**      int len                 - the number of bytes
+**      uint16_t crc            - the initial value: DMMBIN_CRC_INIT, or the CRC of the previous bytes
+**
+**	Return Value:
+**		uint16_t    - the CRC-16/CCITT of the bytes
+**
+**	Description:
+**		This function computes the CRC-16/CCITT (polynomial 0x1021, most significant bit first) of a buffer.
+**      It uses a 16 entries table, processing a nibble per step: the table fits in 32 bytes of flash
+**      and the cost is two lookups per byte. The CRC of "123456789" is 0x29B1.
+**
+*/
+uint16_t DMMBIN_Crc16(uint8_t const *pBuf, int len, uint16_t crc)
+{
+    int i;
+    for(i = 0; i < len; i++)
+    {
+        crc = (crc << 4) ^ rgBinCrcNibble[(crc >> 12) ^ (pBuf[i] >> 4)];
+        crc = (crc << 4) ^ rgBinCrcNibble[(crc >> 12) ^ (pBuf[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMBIN_PutVarint
+**
+**	Parameters:
+**      uint8_t *pBuf       - the buffer receiving the varint, at least 10 bytes
+**      int64_t val         - the value
+**
+**	Return Value:
+**		int         - the number of bytes written
+**
+**	Description:
+**		This function writes a zigzag varint: the sign is moved to bit 0, so that the small negative values are short,
+**      then 7 bits are written per byte, least significant first, bit 7 being set when more bytes follow.
+**
+*/
+int DMMBIN_PutVarint(uint8_t *pBuf, int64_t val)
+{
+    uint64_t u = ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+    int cb = 0;
+    while(u >= 0x80)
+    {
+        pBuf[cb++] = (u & 0x7F) | 0x80;
+        u >>= 7;
+    }
+    pBuf[cb++] = (uint8_t)u;
+    return cb;
+}
+
+/***	DMMBIN_GetVarint
+**
+**	Parameters:
+**      uint8_t const *pBuf - the buffer holding the varint
+**      int len             - the number of bytes available
+**      int64_t *pVal       - the decoded value
+**
+**	Return Value:
+**		int         - the number of bytes read, 0 if the varint is not complete or too long
+**
+**	Description:
+**		This function reads a zigzag varint written by DMMBIN_PutVarint.
+**
+*/
+int DMMBIN_GetVarint(uint8_t const *pBuf, int len, int64_t *pVal)
+{
+    uint64_t u = 0;
+    int cb;
+    for(cb = 0; cb < len && cb < 10; cb++)
+    {
+        u |= (uint64_t)(pBuf[cb] & 0x7F) << (7 * cb);
+        if(!(pBuf[cb] & 0x80))
+        {
+            *pVal = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+            return cb + 1;
+        }
+    }
+    return 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
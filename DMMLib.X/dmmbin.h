@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmbin.h
+
+  @Description
+        This file contains the declaration for the functions of the DMMBIN module (binary framed stream of the samples).
+        The DMMBIN functions are defined in dmmbin.c source file.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, binary framed stream
+
+ */
+/* ************************************************************************** */
+
+#ifndef _DMMBIN_H    /* Guard against multiple inclusion */
+#define _DMMBIN_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// packet types, see DMMBIN_EncodePacket
+#define DMMBIN_PKT_CODE         0       // raw code (AD1 signed code or RMS register value)
+#define DMMBIN_PKT_VALUE        1       // value, in 10^-exp units of the scale unit
+#define DMMBIN_PKT_AVG          2       // moving average value, in 10^-exp units of the scale unit
+#define DMMBIN_PKT_OVERLOADP    3       // positive value outside the convertor range, no payload
+#define DMMBIN_PKT_OVERLOADN    4       // negative value outside the convertor range, no payload
+#define DMMBIN_PKT_ERROR        5       // error, the payload is the ERRVAL_ code
+
+#define DMMBIN_NOSCALE          0x1F    // scale index field of the packets not related to a scale
+#define DMMBIN_MAXFRAME         20      // maximum frame length, including the COBS overhead and the delimiter
+#define DMMBIN_CRC_INIT         0xFFFF  // CRC-16/CCITT initial value, see DMMBIN_Crc16
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// decoded packet, see DMMBIN_DecodeFrame
+typedef struct _DMMBINPKT{
+    uint8_t bType;      // DMMBIN_PKT_...
+    uint8_t bSeq;       // sequence number, incremented for each packet
+    int8_t idxScale;    // the scale the sample was acquired on, -1 for DMMBIN_NOSCALE
+    int8_t exp;         // DMMBIN_PKT_VALUE and DMMBIN_PKT_AVG: the value is in 10^-exp units
+    int64_t val;        // the code, the value or the error code, according to bType
+} DMMBINPKT;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void DMMBIN_Reset();
+int DMMBIN_EncodePacket(uint8_t *pFrame, uint8_t bType, int idxScale, int8_t exp, int64_t val);
+uint8_t DMMBIN_DecodeFrame(uint8_t const *pFrame, int cbFrame, DMMBINPKT *pPkt);
+uint16_t DMMBIN_Crc16(uint8_t const *pBuf, int len, uint16_t crc);
+
+#endif /* _DMMBIN_H */
+
+/* *****************************************************************************
+ End of File
+ */
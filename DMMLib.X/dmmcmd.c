@@ -31,8 +31,6 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
 #include "dmmcmd.h"
 #include "dmm.h"
 #include "serialno.h"
@@ -40,8 +38,14 @@
 #include "calib.h"
 #include <stdio.h>
 #include <ctype.h>
+#include <string.h>
 #include "errors.h"
-#include "fact.h"
+#include "smpring.h"
+#include "autorange.h"
+#include "dmmfilt.h"
+#include "mains.h"
+#include "dmmbin.h"
+#include "hal.h"
 
 
 /* ************************************************************************** */
@@ -53,9 +57,12 @@ char* DMMCMD_CmdGetNextArg();
 cmd_key_t DMMCMD_CmdDecode(char  *szCmd);
 void DMMCMD_ProcessCmd(cmd_key_t keyCmd);
 uint8_t DMMCMD_ProcessRepeatedCmd();
+void DMMCMD_WaitRepeatedRead();
+void DMMCMD_RepReadDone();
+void DMMCMD_SendRepeatedError(uint8_t bErrCode);
 // individual commands functions
 uint8_t DMMCMD_CmdConfig(char const *arg0);
-uint8_t DMMCMD_CmdMeasureRep();
+uint8_t DMMCMD_CmdMeasureRep(char const *arg0);
 uint8_t DMMCMD_CmdMeasureStop();
 uint8_t DMMCMD_CmdMeasureRaw();
 uint8_t DMMCMD_CmdMeasureAvg();
@@ -72,8 +79,18 @@ uint8_t DMMCMD_CmdFinalizeCalibP(char const *arg0);
 uint8_t DMMCMD_CmdFinalizeCalibN(char const *arg0);
 uint8_t DMMCMD_CmdRestoreFactCalib();
 uint8_t DMMCMD_CmdReadSerialNo();
+uint8_t DMMCMD_CmdAutorangeStats();
+uint8_t DMMCMD_CmdMeasureStats(char const *arg0);
+uint8_t DMMCMD_CmdFilter(char const *arg0);
+uint8_t DMMCMD_CmdMains(char const *arg0);
+uint8_t DMMCMD_CmdBaud(char const *arg0);
+uint8_t DMMCMD_CmdUartStats();
+uint8_t DMMCMD_CmdFlow(char const *arg0);
+uint8_t DMMCMD_CmdStream(char const *arg0);
 void EnableCaches();
 void DisableCaches();
+uint8_t DMM_IsNotANumber(double dVal);
+uint8_t DMM_FACScale(int idxScale);
 /* ************************************************************************** */
 /* ************************************************************************** */
 /* Section: Global Data, local to this module                                 */
@@ -83,6 +100,29 @@ void DisableCaches();
 // flags for repeated value and repeated raw value
 uint8_t fRepGetVal = 0;
 uint8_t fRepGetRaw = 0;
+// status block read in the background during repeated sessions
+#define DMMCMD_REPRINGSIZE  16  // repeated session samples ring size, must be a power of 2
+DMMSTS dmmstsRep;
+uint32_t tRepReadStart;     // HAL_GetTicks value when the background status read was started, the samples timestamp
+uint8_t fRepReadStarted = 0;
+volatile unsigned int cntRepNotReady = 0;  // consecutive not ready status reads, written by DMMCMD_RepReadDone
+DMMSAMPLE rgRepSamples[DMMCMD_REPRINGSIZE];
+SMPRING ringRep;    // produced by DMMCMD_RepReadDone, consumed by DMMCMD_ProcessRepeatedCmd
+// repeated sessions output format, see DMMCMD_CmdStream
+#define DMMCMD_STREAM_TEXT  0   // formatted text lines
+#define DMMCMD_STREAM_CODE  1   // DMMBIN frames of the raw codes
+#define DMMCMD_STREAM_VALUE 2   // DMMBIN frames of the fixed point values
+uint8_t bRepStream = DMMCMD_STREAM_TEXT;
+DMMFIX fixRep;              // fixed point coefficients of the DMMCMD_STREAM_VALUE frames, idxScale is -1 when they must be retrieved
+double dRepFixScale;        // 10^fixRep.exp, converts the moving average to fixed point
+uint8_t rgRepFrame[DMMBIN_MAXFRAME];
+// moving average of the repeated values, see DMMCMD_CmdMeasureRep
+#define DMMCMD_REPWNDMAX    128 // maximum moving average window size
+double rgdRepWnd[DMMCMD_REPWNDMAX];
+DMMSTATS_WND wndRep;
+#ifndef DMMCMD_BAUD
+#define DMMCMD_BAUD         UART_BAUD_DEFAULT   // initial baud rate, can be defined at build time
+#endif
 // variables used in multiple functions// allocate them only once.
 char szMsg[200];
 char szVal[20];
@@ -109,7 +149,15 @@ const cmd_map_t uartCommands[] = {
 	{"DMMFinalizeCalibP",	CMD_FinalizeCalibP},
 	{"DMMFinalizeCalibN",   CMD_FinalizeCalibN},
 	{"DMMRestoreFactCalibs",CMD_RestoreFactCalibs},
-	{"DMMReadSerialNo",   	CMD_ReadSerialNo}
+	{"DMMReadSerialNo",   	CMD_ReadSerialNo},
+	{"DMMAutorangeStats",   CMD_AutorangeStats},
+	{"DMMMeasureStats",   	CMD_MeasureStats},
+	{"DMMFilter",   		CMD_Filter},
+	{"DMMMains",   			CMD_Mains},
+	{"DMMBaud",   			CMD_Baud},
+	{"DMMUartStats",   		CMD_UartStats},
+	{"DMMFlow",   			CMD_Flow},
+	{"DMMStream",   		CMD_Stream}
 };
 
 const char rgScales[][20] = {"Resistance50M", "Resistance5M", "Resistance500k", "Resistance50k", "Resistance5k", "Resistance500", "Resistance50",
@@ -119,6 +167,12 @@ const char rgScales[][20] = {"Resistance50M", "Resistance5M", "Resistance500k",
                          "Continuity", "Diode",
                          "CurrentDC500m", "CurrentDC50m", "CurrentDC5m", "CurrentDC500u",
                          "CurrentAC500m", "CurrentAC50m", "CurrentAC5m", "CurrentAC500u"};
+
+// auto-ranging configurations, see DMMCMD_CmdConfig
+const char rgAutoScales[][20] = {"AutoResistance", "AutoVoltageDC", "AutoVoltageAC", 
+                         "AutoCurrentDC5", "AutoCurrentAC5", "AutoCurrentDC", "AutoCurrentAC"};
+const int rgAutoModes[] = {DmmResistance, DmmDCVoltage, DmmACVoltage, 
+                         DmmDCCurrent, DmmACCurrent, DmmDCLowCurrent, DmmACLowCurrent};
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Interface Functions                                               */
@@ -149,10 +203,12 @@ uint8_t DMMCMD_Init()
     // initializes the modules used by UART Command interpreter
     uint8_t bErrCode;
     DMM_Init();
-    UART_Init(9600);
+    UART_Init(DMMCMD_BAUD);
     bErrCode = CALIB_Init();
     // no need to process error code as this can be the first run of DMMShield (Calibration not present)
     SERIALNO_Init();
+    SMPRING_Init(&ringRep, rgRepSamples, DMMCMD_REPRINGSIZE);
+    DMMSTATS_WndInit(&wndRep, rgdRepWnd, 1);
     pszLastErr = ERRORS_GetszLastError();    
     return bErrCode;
 }
@@ -170,18 +226,28 @@ uint8_t DMMCMD_Init()
 **	Description:
 **		This function checks on UART if a command was received. 
 **      It compares the received command with the commands defined in the commands array. If recognized, the command is processed accordingly.
+**      The command is parsed in place, in the UART receive ring (see UART_GetLine), then released.
 **      It also performs the repeated commands.
+**      When a baud rate set by DMMBaud was not confirmed by a command, the initial baud rate is restored (see UART_CheckBaudTimeout).
 **
 */
 void DMMCMD_CheckForCommand()
 {
-    char uartCmd[cchRxMax];    
-    int cchi = UART_GetString(uartCmd, cchRxMax);
-    if(cchi > 0)
+    char *uartCmd;
+    if(UART_CheckBaudTimeout())
+    {
+        sprintf(szMsg, "Baud: no command received, back to %u\r\n", (unsigned)UART_GetBaud());
+        UART_PutString(szMsg);
+    }
+    uartCmd = UART_GetLine();
+    if(uartCmd)
     {
 	    sprintf(szMsg, "Received command: %s\r\n", uartCmd);
 	    UART_PutString(szMsg);        
+        // the command may use SPI or change the scale, so the background status read must be completed and dropped
+        DMMCMD_WaitRepeatedRead();
         DMMCMD_ProcessCmd(DMMCMD_CmdDecode(uartCmd));
+        UART_ReleaseLine();
     }
     DMMCMD_ProcessRepeatedCmd();
 }
@@ -294,7 +360,7 @@ void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
         	DMMCMD_CmdCalibZ();
             break;
         case CMD_MeasureRep:
-        	DMMCMD_CmdMeasureRep();
+        	DMMCMD_CmdMeasureRep(DMMCMD_CmdGetNextArg());
             break;
         case CMD_MeasureStop:
         	DMMCMD_CmdMeasureStop();
@@ -335,6 +401,30 @@ void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
         case CMD_ReadSerialNo:
         	DMMCMD_CmdReadSerialNo();
             break;
+        case CMD_AutorangeStats:
+        	DMMCMD_CmdAutorangeStats();
+            break;
+        case CMD_MeasureStats:
+        	DMMCMD_CmdMeasureStats(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_Filter:
+        	DMMCMD_CmdFilter(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_Mains:
+        	DMMCMD_CmdMains(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_Baud:
+        	DMMCMD_CmdBaud(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_UartStats:
+        	DMMCMD_CmdUartStats();
+            break;
+        case CMD_Flow:
+        	DMMCMD_CmdFlow(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_Stream:
+        	DMMCMD_CmdStream(DMMCMD_CmdGetNextArg());
+            break;
 //        case CMD_NONE:
         default:
         	// do nothing
@@ -354,12 +444,15 @@ void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
 **          ERRVAL_SUCCESS            0      // success
 **          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong scale index
 **          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**          ERRVAL_AUTORANGE_MODE    0xEB    // error, no scale is defined for the autorange mode
 **
 **	Description:
 **		This function implements the DMMConfig text command of DMMCMD module.
 **      It searches the argument among the defined scales in order to detect the scale index, 
-**      then it calls DMM_SetScale providing the scale index as parameter.
-**      The function sends over UART the success message or the error message.
+**      then it stops auto-ranging and calls DMM_SetScale providing the scale index as parameter.
+**      If the argument is one of the auto-ranging configurations (AutoResistance, AutoVoltageDC, ...), 
+**      it calls AUTORANGE_Start for the corresponding mode.
+**      The function sends over UART the success message, including the measured settle time (see DMM_GetSettleTime), or the error message.
 **      The function returns the error code, which is the error code returned by the DMM_SetScale function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **      
@@ -372,10 +465,28 @@ uint8_t DMMCMD_CmdConfig(char const *arg0)
     {
         if(!strcmp(arg0, rgScales[idxScale]))
         {
+            AUTORANGE_Stop();
             bErrCode = DMM_SetScale(idxScale);// send the selected configuration to the DMM
             if(bErrCode == ERRVAL_SUCCESS)
             {
-                sprintf(szMsg, "PASS, Selected scale index is: %d\r\n", idxScale);
+                sprintf(szMsg, "PASS, Selected scale index is: %d, settle time: %u us\r\n", idxScale, (unsigned)DMM_GetSettleTime(NULL));
+            }
+            else
+            {
+                bErrCode = ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+            }
+            UART_PutString(szMsg);
+            return bErrCode;
+        }
+    }
+    for(idxScale = 0; idxScale < sizeof(rgAutoScales)/sizeof(rgAutoScales[0]); idxScale++)
+    {
+        if(!strcmp(arg0, rgAutoScales[idxScale]))
+        {
+            bErrCode = AUTORANGE_Start(rgAutoModes[idxScale]);
+            if(bErrCode == ERRVAL_SUCCESS)
+            {
+                sprintf(szMsg, "PASS, Autorange selected scale index is: %d, settle time: %u us\r\n", DMM_GetCurrentScale(), (unsigned)DMM_GetSettleTime(NULL));
             }
             else
             {
@@ -393,23 +504,43 @@ uint8_t DMMCMD_CmdConfig(char const *arg0)
 /***	DMMCMD_CmdMeasureRep
 **
 **	Parameters:
-**     none
+**     char const *arg0   - the moving average window size, optional (1 when missing: the values are not averaged)
 **
 **	Return Value:
 **		uint8_t     - the error code
 **          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_CMD_WRONGPARAMS    0xF9   // the window size is not an integer between 1 and DMMCMD_REPWNDMAX
 **
 **	Description:
 **		This function initiates the DMMMeasureRep repeated command session of DMMCMD module. 
-**      The function always returns success: ERRVAL_SUCCESS.
+**      When a window size N greater than 1 is provided, each value is replaced by the moving average of the last N values 
+**      (see DMMCMD_ProcessRepeatedCmd), so that the averaged values are sent at the conversion rate.
+**      The values are sent in the format selected by DMMStream (see DMMCMD_CmdStream), the sequence numbers restart from 0.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
-uint8_t DMMCMD_CmdMeasureRep()
+uint8_t DMMCMD_CmdMeasureRep(char const *arg0)
 {
+    int cntWnd = 1;
+    if(arg0 && (sscanf(arg0, "%d", &cntWnd) != 1 || cntWnd < 1 || cntWnd > DMMCMD_REPWNDMAX))
+    {
+        ERRORS_GetPrefixedMessageString(ERRVAL_CMD_WRONGPARAMS, "", szMsg);
+        UART_PutString(szMsg);
+        return ERRVAL_CMD_WRONGPARAMS;
+    }
+    DMMSTATS_WndInit(&wndRep, rgdRepWnd, cntWnd);
+    DMMBIN_Reset();
+    fixRep.idxScale = -1;
 	fRepGetVal = 1;
 	fRepGetRaw = 0;
-    strcpy(szMsg, "Measure repeated");
+    if(cntWnd > 1)
+    {
+        sprintf(szMsg, "Measure repeated, moving average of %d values", cntWnd);
+    }
+    else
+    {
+        strcpy(szMsg, "Measure repeated");
+    }
     ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
     UART_PutString(szMsg);
     return ERRVAL_SUCCESS;
@@ -451,12 +582,15 @@ uint8_t DMMCMD_CmdMeasureStop()
 **
 **	Description:
 **		This function initiates the DMMMeasureRaw repeated command session of DMMCMD module. 
+**      The values are sent in the format selected by DMMStream (see DMMCMD_CmdStream), the sequence numbers restart from 0.
 **      The function always returns success: ERRVAL_SUCCESS.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 uint8_t DMMCMD_CmdMeasureRaw()
 {
+    DMMBIN_Reset();
+    fixRep.idxScale = -1;
 	fRepGetVal = 0;
 	fRepGetRaw = 1;
     strcpy(szMsg, "Measure raw");
@@ -478,20 +612,26 @@ uint8_t DMMCMD_CmdMeasureRaw()
 **
 **	Description:
 **		This function implements the DMMMeasureAVG text command of DMMCMD module.
-**		The function calls the DMM_DGetAvgValue.
+**		When auto-ranging is active, the function first selects the range using AUTORANGE_DGetValue.
+**		The function calls the DMM_DGetAvgValue, or MAINS_DGetAvgValue when the mains synchronous integration was activated by DMMMains.
 **		In case of success, the returned value is formatted and sent over UART.
 **		In case of error, the error specific message is sent over UART.
-**      The function returns the error code, which is the error code raised by the DMM_DGetAvgValue function.
+**      The function returns the error code, which is the error code raised by the DMM_DGetAvgValue or MAINS_DGetAvgValue function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 uint8_t DMMCMD_CmdMeasureAvg()
 {
 	uint8_t bErrCode = ERRVAL_SUCCESS;
-	char szVal[200];
-//	char szVal[20];
 	double dMeasuredVal;
-    dMeasuredVal = DMM_DGetAvgValue(MEASURE_CNT_AVG, &bErrCode);
+    if(AUTORANGE_FActive())
+    {
+        AUTORANGE_DGetValue(&bErrCode);
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        dMeasuredVal = MAINS_FActive() ? MAINS_DGetAvgValue(&bErrCode): DMM_DGetAvgValue(MEASURE_CNT_AVG, &bErrCode);
+    }
     fRepGetVal = 0;
     fRepGetRaw = 0;
     if(bErrCode == ERRVAL_SUCCESS)
@@ -508,6 +648,77 @@ uint8_t DMMCMD_CmdMeasureAvg()
     return bErrCode;
 }
 
+/***	DMMCMD_CmdMeasureStats
+**
+**	Parameters:
+**     char const *arg0   - the number of values, optional (MEASURE_CNT_AVG when missing)
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CMD_WRONGPARAMS      0xF9    // the number of values is not a positive integer
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**
+**	Description:
+**		This function implements the DMMMeasureStats text command of DMMCMD module.
+**		When auto-ranging is active, the function first selects the range using AUTORANGE_DGetValue.
+**		The function calls DMM_AcquireStats, which computes all the statistics in a single acquisition pass.
+**      The values outside the convertor range are counted and excluded (DMMSTATS_POLICY_SKIP).
+**		In case of success, the number of values, mean, standard deviation, minimum, maximum, RMS and the number of overloads 
+**      are formatted and sent over UART. The standard deviation is sent in exponential format, without unit.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdMeasureStats(char const *arg0)
+{
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    int cntValues = MEASURE_CNT_AVG;
+    DMMSTATS stats;
+    char szMean[20], szStdDev[20], szMin[20], szMax[20], szRMS[20];
+    if(arg0 && (sscanf(arg0, "%d", &cntValues) != 1 || cntValues <= 0))
+    {
+    	bErrCode = ERRVAL_CMD_WRONGPARAMS;
+    }
+    if(bErrCode == ERRVAL_SUCCESS && AUTORANGE_FActive())
+    {
+        AUTORANGE_DGetValue(&bErrCode);
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        DMMSTATS_Init(&stats, DMMSTATS_POLICY_SKIP);
+        bErrCode = DMM_AcquireStats(cntValues, &stats);
+    }
+    fRepGetVal = 0;
+    fRepGetRaw = 0;
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        if(stats.cntValues)
+        {
+            DMM_FormatValue(DMMSTATS_DGetMean(&stats), szMean, 1);
+            sprintf(szStdDev, "%.3e", DMMSTATS_DGetStdDev(&stats));  // below the resolution of DMM_FormatValue for low noise
+            DMM_FormatValue(stats.dMin, szMin, 1);
+            DMM_FormatValue(stats.dMax, szMax, 1);
+            DMM_FormatValue(DMMSTATS_DGetRMS(&stats), szRMS, 1);
+            sprintf(szMsg, "Count: %u, Mean: %s, StdDev: %s, Min: %s, Max: %s, RMS: %s, Overloads: %u\r\n", 
+                    (unsigned)stats.cntValues, szMean, szStdDev, szMin, szMax, szRMS, (unsigned)stats.cntOverloads);
+        }
+        else
+        {
+            DMM_FormatValue(stats.dExcluded, szMean, 1);
+            sprintf(szMsg, "Count: 0, Value: %s, Overloads: %u\r\n", szMean, (unsigned)stats.cntOverloads);
+        }
+    }
+    else
+    {
+        // like this, prefixing is skipped for ERRVAL_SUCCESS
+        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    }
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
 /***	DMMCMD_CmdCalibP
 **
 **	Parameters:
@@ -1089,6 +1300,338 @@ uint8_t DMMCMD_CmdReadSerialNo()
     return bErrCode;
 }
 
+/***	DMMCMD_CmdAutorangeStats
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS            0      // success
+**
+**	Description:
+**		This function implements the DMMAutorangeStats text command of DMMCMD module.
+**		It sends over UART the auto-ranging counters: the number of scale changes, relay transitions and ranging sequences,
+**      the last and maximum ranging latency, then clears the counters.
+**      The function always returns success: ERRVAL_SUCCESS.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdAutorangeStats()
+{
+    AUTORANGESTATS stats;
+    AUTORANGE_GetStats(&stats);
+    AUTORANGE_ResetStats();
+    sprintf(szMsg, "Range changes: %u, Relay changes: %u, Rangings: %u, Last latency: %u us, Max latency: %u us\r\n", 
+            (unsigned)stats.cntRangeChanges, (unsigned)stats.cntRelayChanges, (unsigned)stats.cntRangings, 
+            (unsigned)stats.tusLastLatency, (unsigned)stats.tusMaxLatency);
+    UART_PutString(szMsg);
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdFilter
+**
+**	Parameters:
+**     char const *arg0   - the first filter stage, for example "Median5", or "None". 
+**                          The next stages are retrieved using DMMCMD_CmdGetNextArg.
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMMFILT_STAGE      0xEA   // wrong filter stage or parameter, or too many stages
+**
+**	Description:
+**		This function implements the DMMFilter text command of DMMCMD module.
+**		It replaces the filter chain applied to the DMMMeasureRep and DMMMeasureRaw values with the stages provided as comma separated arguments, 
+**      in the order they are applied, for example "DMMFilter Spike3,Median5,Ema2" (see DMMFILT_ParseStage).
+**      "DMMFilter None" removes the filter, "DMMFilter" without arguments only reports the current chain.
+**		In case of success, the filter chain is sent over UART. 
+**		In case of error, the chain is removed and the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdFilter(char const *arg0)
+{
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    char szChain[10 * DMMFILT_MAXSTAGES];
+    if(arg0)
+    {
+        DMMFILT_ClearChain();
+        for(; arg0 && (bErrCode == ERRVAL_SUCCESS); arg0 = DMMCMD_CmdGetNextArg())
+        {
+            bErrCode = DMMFILT_ParseStage(arg0);
+        }
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        DMMFILT_FormatChain(szChain);
+        sprintf(szMsg, "Filter: %s", szChain);
+    }
+    else
+    {
+        DMMFILT_ClearChain();
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdMains
+**
+**	Parameters:
+**     char const *arg0   - the mains frequency: "50", "60", "Auto" or "Off". When missing, only the state is reported.
+**                          The optional second argument, the number of mains cycles to integrate (1 when missing), 
+**                          is read using DMMCMD_CmdGetNextArg.
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CMD_WRONGPARAMS      0xF9    // wrong parameters
+**          ERRVAL_MAINS_PARAM          0xE9    // wrong mains frequency or number of cycles
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout, during the detection
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index, during the detection
+**
+**	Description:
+**		This function implements the DMMMains text command of DMMCMD module, for example "DMMMains Auto,2".
+**		It activates the mains synchronous integration used by DMMMeasureAvg (see MAINS_Start): the average is integrated 
+**      over an integer number of power line cycles, which rejects the line frequency ripple of the DC readings.
+**      With "Auto", the frequency is detected on the current scale, which should be the DC scale to be measured. 
+**      "Off" returns to the fixed number of samples average.
+**		In case of success, the frequency (and whether it was detected), the number of cycles and the integration time are sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdMains(char const *arg0)
+{
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    char const *arg1 = arg0 ? DMMCMD_CmdGetNextArg(): NULL;
+    unsigned int frq = MAINS_FRQ_AUTO, cntCycles = 1;
+    MAINSSTATE state;
+    if(arg0 && !strcmp(arg0, "Off"))
+    {
+        MAINS_Stop();
+    }
+    else if(arg0)
+    {
+        if((strcmp(arg0, "Auto") && sscanf(arg0, "%u", &frq) != 1) || (arg1 && sscanf(arg1, "%u", &cntCycles) != 1) || cntCycles > 255)
+        {
+            bErrCode = ERRVAL_CMD_WRONGPARAMS;
+        }
+        if(bErrCode == ERRVAL_SUCCESS)
+        {
+            bErrCode = MAINS_Start(strcmp(arg0, "Auto") ? frq: MAINS_FRQ_AUTO, cntCycles);
+        }
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        MAINS_GetState(&state);
+        if(state.fActive)
+        {
+            sprintf(szMsg, "Mains: %u Hz (%s, ratio %.1f), %u cycles, integration time: %u us", state.frq, 
+                    state.fDetected ? "detected": "not detected", state.dRatio, state.cntCycles, (unsigned)state.tusWindow);
+        }
+        else
+        {
+            strcpy(szMsg, "Mains: Off");
+        }
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdBaud
+**
+**	Parameters:
+**     char const *arg0   - the new baud rate, optional. When missing, only the current baud rate is reported.
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CMD_WRONGPARAMS      0xF9    // wrong parameters
+**          ERRVAL_UART_BAUD            0xE8    // baud rate out of range or not achievable
+**
+**	Description:
+**		This function implements the DMMBaud text command of DMMCMD module, for example "DMMBaud 115200".
+**		It computes the baud rate generator settings using UART_GetBaudDivisor, up to PB_FRQ / 4 in the high speed mode (BRGH).
+**		In case of success, the requested and actual baud rates, the baud rate error and the settings are sent over UART, 
+**      then the baud rate is changed by UART_SetBaud, once the answer was sent at the previous baud rate.
+**      A command must then be received at the new baud rate within UART_BAUD_TIMEOUT_MS, 
+**      otherwise the initial baud rate is restored (see DMMCMD_CheckForCommand).
+**		In case of error, the error specific message is sent over UART and the baud rate is not changed.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdBaud(char const *arg0)
+{
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    unsigned int baud = UART_GetBaud();
+    uint32_t baudActual = 0;
+    uint8_t fBrgh;
+    uint16_t brg;
+    if(arg0 && sscanf(arg0, "%u", &baud) != 1)
+    {
+        bErrCode = ERRVAL_CMD_WRONGPARAMS;
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        baudActual = UART_GetBaudDivisor(baud, &fBrgh, &brg);
+        if(!baudActual)
+        {
+            bErrCode = ERRVAL_UART_BAUD;
+        }
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        sprintf(szMsg, "Baud: %u, actual %u, error %+.2f %%, BRGH %u, U1BRG %u", baud, (unsigned)baudActual, 
+                ((double)baudActual - baud) * 100 / baud, fBrgh, brg);
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    if(bErrCode == ERRVAL_SUCCESS && baud != UART_GetBaud())
+    {
+        UART_SetBaud(baud);
+    }
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdUartStats
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS            0      // success
+**
+**	Description:
+**		This function implements the DMMUartStats text command of DMMCMD module.
+**		It sends over UART the UART counters: the received lines, the lines dropped because the receive ring was full (overruns) 
+**      or because they were too long, the maximum receive ring occupancy, the receive errors (UART receive buffer overruns, 
+**      framing and parity errors), the number of times the flow control stopped the sender and the characters dropped by the transmit ring.
+**      The function always returns success: ERRVAL_SUCCESS.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdUartStats()
+{
+    UART_RXSTATS stats;
+    UART_GetRxStats(&stats);
+    sprintf(szMsg, "RX lines: %u, RX overruns: %u, RX long lines: %u, RX max used: %u / %u, UART overruns: %u, Framing errors: %u, Parity errors: %u, Flow stops: %u, TX dropped: %u\r\n", 
+            (unsigned)stats.cntLines, (unsigned)stats.cntOverruns, (unsigned)stats.cntLongLines, 
+            (unsigned)stats.cchMaxUsed, UART_RXBUFSIZE, (unsigned)stats.cntFifoOverruns, (unsigned)stats.cntFramingErrors, 
+            (unsigned)stats.cntParityErrors, (unsigned)stats.cntFlowStops, (unsigned)UART_GetTxDropped());
+    UART_PutString(szMsg);
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdFlow
+**
+**	Parameters:
+**     char const *arg0   - the flow control: "None", "RtsCts" or "XonXoff". When missing, only the current one is reported.
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CMD_WRONGPARAMS      0xF9    // wrong parameters
+**          ERRVAL_DMMBIN_FLOW          0xE7    // XonXoff was requested while a binary stream is selected
+**
+**	Description:
+**		This function implements the DMMFlow text command of DMMCMD module, for example "DMMFlow XonXoff".
+**		It selects the UART flow control using UART_SetFlowControl, once the answer was sent: 
+**      the sender is stopped when the UART receive ring is nearly full, so that the commands sent in a batch are not lost.
+**      RtsCts requires the U1RTS and U1CTS pins to be wired to the other side.
+**      XonXoff cannot be selected while a binary stream is selected by DMMStream, as the frames can contain the XON and XOFF characters.
+**		In case of success, the selected flow control is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdFlow(char const *arg0)
+{
+    const char rgszFlows[][8] = {"None", "RtsCts", "XonXoff"};  // indexed by UART_FLOW_...
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    uint8_t bFlow = UART_GetFlowControl();
+    if(arg0)
+    {
+        for(bFlow = 0; bFlow < sizeof(rgszFlows)/sizeof(rgszFlows[0]) && strcmp(arg0, rgszFlows[bFlow]); bFlow++);
+        if(bFlow >= sizeof(rgszFlows)/sizeof(rgszFlows[0]))
+        {
+            bErrCode = ERRVAL_CMD_WRONGPARAMS;
+        }
+        else if(bFlow == UART_FLOW_XONXOFF && bRepStream != DMMCMD_STREAM_TEXT)
+        {
+            bErrCode = ERRVAL_DMMBIN_FLOW;
+        }
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        sprintf(szMsg, "Flow control: %s", rgszFlows[bFlow]);
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    if(bErrCode == ERRVAL_SUCCESS && bFlow != UART_GetFlowControl())
+    {
+        UART_SetFlowControl(bFlow);
+    }
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdStream
+**
+**	Parameters:
+**     char const *arg0   - the format: "Text", "Code" or "Value". When missing, only the current one is reported.
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_CMD_WRONGPARAMS      0xF9    // wrong parameters
+**          ERRVAL_DMMBIN_FLOW          0xE7    // a binary stream was requested while the XON/XOFF flow control is selected
+**
+**	Description:
+**		This function implements the DMMStream text command of DMMCMD module, for example "DMMStream Value".
+**		It selects the format of the values sent by the DMMMeasureRep and DMMMeasureRaw repeated sessions:
+**      - Text: formatted text lines, like "Value: 1.234567 V",
+**      - Code: DMMBIN frames of the raw codes (AD1 code or RMS register),
+**      - Value: DMMBIN frames of the values, in 10^-exp units of the scale unit (see DMM_FixCodeToValue).
+**      The frames (see the DMMBIN module) hold the scale index, a sequence number and a CRC. They need 7 to 13 bytes per value 
+**      instead of about 20 characters, and no floating point formatting. The replies to the commands remain text lines.
+**      A binary stream cannot be selected while XON/XOFF flow control is used (see DMMCMD_CmdFlow), as the frames can contain the XON and XOFF characters.
+**		In case of success, the selected format is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+uint8_t DMMCMD_CmdStream(char const *arg0)
+{
+    const char rgszStreams[][8] = {"Text", "Code", "Value"};  // indexed by DMMCMD_STREAM_...
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+    uint8_t bStream = bRepStream;
+    if(arg0)
+    {
+        for(bStream = 0; bStream < sizeof(rgszStreams)/sizeof(rgszStreams[0]) && strcmp(arg0, rgszStreams[bStream]); bStream++);
+        if(bStream >= sizeof(rgszStreams)/sizeof(rgszStreams[0]))
+        {
+            bErrCode = ERRVAL_CMD_WRONGPARAMS;
+        }
+        else if(bStream != DMMCMD_STREAM_TEXT && UART_GetFlowControl() == UART_FLOW_XONXOFF)
+        {
+            bErrCode = ERRVAL_DMMBIN_FLOW;
+        }
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        bRepStream = bStream;
+        DMMBIN_Reset();
+        fixRep.idxScale = -1;
+        sprintf(szMsg, "Stream: %s", rgszStreams[bStream]);
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
 /***	DMMCMD_ProcessRepeatedCmd
 **
 **	Parameters:
@@ -1102,43 +1645,227 @@ uint8_t DMMCMD_CmdReadSerialNo()
 **
 **	Description:
 **		This function implements the repeated session functionality for DMMMeasureRep and DMMMeasureRaw text commands of DMMCMD module.
-**		The function calls the DMM_DGetValue, eventually without calibration parameters being applied for DMMMeasureRaw.
-**		In case of success, the returned value is formatted and sent over UART.
-**		In case of error, the error specific message is sent over UART.
-**      The function is called by DMMCMD_ProcessCmd function.
+**		The DMM status block is read in the background using DMM_StartReadStatus: when the read completes, DMMCMD_RepReadDone 
+**      pushes the raw sample in the ringRep samples ring. Whenever the previous read is completed the next one is started, 
+**      then the oldest sample is retrieved from the ring, converted using DMM_DSampleToValue (without calibration parameters 
+**      being applied for DMMMeasureRaw), formatted and sent, so that the SPI transfer overlaps the UART output.
+**      When a filter chain was selected by DMMFilter, the raw code is filtered by DMMFILT_Apply and converted again; 
+**      the auto-ranging uses the unfiltered value, so that it is not delayed by the filter, and an overload is sent unfiltered.
+**      When DMMMeasureRep was given a window size, the value is added to the moving average window and the average is sent instead:
+**      the arithmetic mean of the last values, or their quadratic mean for AC scales (like DMMMeasureAvg).
+**      The window restarts after a scale change or an overload.
+**      When auto-ranging is active, each value is checked using AUTORANGE_NextScale. When the scale must be changed, 
+**      the background read is completed and dropped, the new scale is selected and the value is not sent.
+**		In case of success, the returned value is formatted and sent over UART. The value is queued using the UART_TX_DROP policy: 
+**      when the UART transmit ring has no room for it, the value is dropped, so that the acquisition is never delayed by the UART.
+**      If no value is ready for DMM_VALIDDATA_CNTTIMEOUT consecutive reads, the timeout error is sent.
+**      When a binary stream was selected by DMMStream, a DMMBIN frame is queued instead of the text line, with the same policy: 
+**      the raw code (the moving average is not applied), or the value converted by DMM_FixCodeToValue, without floating point formatting 
+**      (the moving average is converted to the same fixed point units). The overloads are sent as DMMBIN_PKT_OVERLOADP / N frames.
+**		In case of error, the error specific message (DMMBIN_PKT_ERROR frame for a binary stream) is sent over UART, see DMMCMD_SendRepeatedError.
+**      The function is called by DMMCMD_CheckForCommand function.
 */
 uint8_t DMMCMD_ProcessRepeatedCmd()
 {
 	uint8_t bErrCode = ERRVAL_SUCCESS;
+    DMMSAMPLE sample;
+    int idxScale, cbFrame;
     if(fRepGetVal || fRepGetRaw)
     {
+        if(!DMM_FReadStatusBusy())
+        {
+            // the previous read is completed, its sample (if ready) is in the ring
+            if(cntRepNotReady >= DMM_VALIDDATA_CNTTIMEOUT)
+            {
+                cntRepNotReady = 0;
+                bErrCode = ERRVAL_DMM_VALIDDATATIMEOUT;
+                DMMCMD_SendRepeatedError(bErrCode);
+            }
+            // start the next status block transfer
+            tRepReadStart = HAL_GetTicks();
+            fRepReadStarted = (DMM_StartReadStatus(&dmmstsRep, DMMCMD_RepReadDone) == ERRVAL_SUCCESS);
+        }
+        if(!SMPRING_Pop(&ringRep, &sample))
+        {
+            // not ready
+            return bErrCode;
+        }
         if(fRepGetRaw)
         {
-        	DMM_SetUseCalib(0);
+            DMM_SetUseCalib(0);
+        }
+        dMeasuredVal = DMM_DSampleToValue(&sample, &bErrCode);
+        if(bErrCode == ERRVAL_SUCCESS && AUTORANGE_FActive())
+        {
+            idxScale = AUTORANGE_NextScale(dMeasuredVal, sample.idxScale);
+            if(idxScale >= 0)
+            {
+                // the samples acquired on the previous scale are dropped
+                DMM_SetUseCalib(1);
+                DMMCMD_WaitRepeatedRead();
+                bErrCode = AUTORANGE_SetScale(idxScale);
+                if(bErrCode == ERRVAL_SUCCESS)
+                {
+                    return bErrCode;
+                }
+            }
+        }
+        if(bErrCode == ERRVAL_SUCCESS && DMMFILT_GetCount())
+        {
+            if(dMeasuredVal == INFINITY || dMeasuredVal == -INFINITY)
+            {
+                DMMFILT_Reset();    // the overload is sent, it is not filtered
+            }
+            else
+            {
+                DMMFILT_Apply(&sample);
+                dMeasuredVal = DMM_DSampleToValue(&sample, &bErrCode);
+            }
+        }
+        if(bErrCode == ERRVAL_SUCCESS && bRepStream == DMMCMD_STREAM_VALUE && fixRep.idxScale != sample.idxScale)
+        {
+            // retrieved with the DMM_SetUseCalib setting of the session
+            bErrCode = DMM_FixPrepare(&fixRep);
+            dRepFixScale = pow(10, fixRep.exp);
         }
-        dMeasuredVal = DMM_DGetValue(&bErrCode);
         DMM_SetUseCalib(1);
-        if(bErrCode == ERRVAL_SUCCESS)
+        if(bErrCode != ERRVAL_SUCCESS)
         {
-            if(fRepGetVal)
+            DMMCMD_SendRepeatedError(bErrCode);
+        }
+        else if(bRepStream != DMMCMD_STREAM_TEXT)
+        {
+            if(bRepStream == DMMCMD_STREAM_VALUE && fRepGetVal && wndRep.cntSize > 1)
             {
-                DMM_FormatValue(dMeasuredVal, szVal, 1);
-                sprintf(szMsg, "Value: %s\r\n", szVal);
+                dMeasuredVal = DMMSTATS_DWndAdd(&wndRep, dMeasuredVal, sample.idxScale, DMM_FACScale(sample.idxScale));
+            }
+            if(dMeasuredVal == INFINITY || dMeasuredVal == -INFINITY)
+            {
+                cbFrame = DMMBIN_EncodePacket(rgRepFrame, (dMeasuredVal > 0) ? DMMBIN_PKT_OVERLOADP: DMMBIN_PKT_OVERLOADN, sample.idxScale, 0, 0);
+            }
+            else if(bRepStream == DMMCMD_STREAM_CODE)
+            {
+                cbFrame = DMMBIN_EncodePacket(rgRepFrame, DMMBIN_PKT_CODE, sample.idxScale, 0, sample.code);
+            }
+            else if(fRepGetVal && wndRep.cntSize > 1)
+            {
+                cbFrame = DMMBIN_EncodePacket(rgRepFrame, DMMBIN_PKT_AVG, sample.idxScale, fixRep.exp, llround(dMeasuredVal * dRepFixScale));
             }
             else
             {
-                sprintf(szMsg, "Raw Value: %.6lf\r\n", dMeasuredVal);
+                cbFrame = DMMBIN_EncodePacket(rgRepFrame, DMMBIN_PKT_VALUE, sample.idxScale, fixRep.exp, DMM_FixCodeToValue(&fixRep, sample.code));
             }
+            UART_TxQueue((char *)rgRepFrame, cbFrame, UART_TX_DROP);
         }
         else
         {
-            bErrCode = ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+            if(fRepGetVal && wndRep.cntSize > 1)
+            {
+                dMeasuredVal = DMMSTATS_DWndAdd(&wndRep, dMeasuredVal, sample.idxScale, DMM_FACScale(sample.idxScale));
+                DMM_FormatValue(dMeasuredVal, szVal, 1);
+                sprintf(szMsg, "Avg. Value: %s\r\n", szVal);
+            }
+            else if(fRepGetVal)
+            {
+                DMM_FormatValue(dMeasuredVal, szVal, 1);
+                sprintf(szMsg, "Value: %s\r\n", szVal);
+            }
+            else
+            {
+                sprintf(szMsg, "Raw Value: %.6lf\r\n", dMeasuredVal);
+            }
+            UART_TxQueue(szMsg, strlen(szMsg), UART_TX_DROP);
         }
-        UART_PutString(szMsg);
+    }
+    else
+    {
+        DMMCMD_WaitRepeatedRead();
     }
     return bErrCode;    
 }
 
+/***	DMMCMD_WaitRepeatedRead
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**     none
+**
+**	Description:
+**		This function waits until the background status read of the repeated session is completed 
+**      and drops it, together with the samples not yet sent.
+**      It must be called before any other DMM / EPROM access.
+**      The function is called by DMMCMD_CheckForCommand and DMMCMD_ProcessRepeatedCmd functions.
+*/
+void DMMCMD_WaitRepeatedRead()
+{
+    if(fRepReadStarted)
+    {
+        while(DMM_FReadStatusBusy());
+        fRepReadStarted = 0;
+    }
+    SMPRING_Flush(&ringRep);
+    cntRepNotReady = 0;
+}
+
+/***	DMMCMD_RepReadDone
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**     none
+**
+**	Description:
+**		This function is called when the background status read of the repeated session is completed, 
+**      from the SPI DMA interrupt when the hardware SPI transport is used. 
+**      If the conversion is done, it pushes the raw sample in the ringRep samples ring, stamped with the read start time, 
+**      otherwise it counts the consecutive not ready reads.
+*/
+void DMMCMD_RepReadDone()
+{
+    DMMSAMPLE sample;
+    if(DMM_FStatusToSample(&dmmstsRep, &sample, tRepReadStart))
+    {
+        cntRepNotReady = 0;
+        SMPRING_Push(&ringRep, &sample);
+    }
+    else
+    {
+        cntRepNotReady++;
+    }
+}
+
+/***	DMMCMD_SendRepeatedError
+**
+**	Parameters:
+**     uint8_t bErrCode     - the error code
+**
+**	Return Value:
+**     none
+**
+**	Description:
+**		This function sends an error of the repeated session: the error specific message, 
+**      or a DMMBIN_PKT_ERROR frame when a binary stream is selected (see DMMCMD_CmdStream).
+**      The error is queued using the UART_TX_BLOCK policy, so that it is never dropped.
+**      The function is called by DMMCMD_ProcessRepeatedCmd function.
+*/
+void DMMCMD_SendRepeatedError(uint8_t bErrCode)
+{
+    int cbFrame;
+    if(bRepStream != DMMCMD_STREAM_TEXT)
+    {
+        cbFrame = DMMBIN_EncodePacket(rgRepFrame, DMMBIN_PKT_ERROR, DMM_GetCurrentScale(), 0, bErrCode);
+        UART_TxQueue((char *)rgRepFrame, cbFrame, UART_TX_BLOCK);
+    }
+    else
+    {
+        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+        UART_TxQueue(szMsg, strlen(szMsg), UART_TX_BLOCK);
+    }
+}
+
 void EnableCaches()
 {
 #ifdef __MICROBLAZE__
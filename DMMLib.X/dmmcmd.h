@@ -19,6 +19,8 @@
 #ifndef _DMMCMD_H    /* Guard against multiple inclusion */
 #define _DMMCMD_H
 
+#include "stdint.h"
+
 
 //#ifdef __cplusplus
 //extern "C" {
@@ -49,7 +51,15 @@ typedef enum {
 	CMD_FinalizeCalibP,
 	CMD_FinalizeCalibN,
 	CMD_RestoreFactCalibs,
-	CMD_ReadSerialNo
+	CMD_ReadSerialNo,
+	CMD_AutorangeStats,
+	CMD_MeasureStats,
+	CMD_Filter,
+	CMD_Mains,
+	CMD_Baud,
+	CMD_UartStats,
+	CMD_Flow,
+	CMD_Stream
 
 } cmd_key_t;
 
@@ -0,0 +1,479 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmfilt.c
+
+  @Description
+        This file groups the functions that implement the DMMFILT module (digital filter chain of the raw samples).
+        The chain is a sequence of up to DMMFILT_MAXSTAGES stages, applied in order to the raw code of each sample
+        (AD1 code or RMS register) before it is converted to a value:
+        - boxcar: the mean of the last N codes,
+        - EMA: exponential IIR filter y += (x - y) / 2^K,
+        - median: the median of the last N codes, rejecting isolated outliers without averaging them into the result,
+        - spike: drops the codes further than K sigma from the running mean, the last accepted code being used instead.
+          Sigma is estimated as 1.25 times the running mean absolute deviation (the sqrt(pi/2) ratio of gaussian noise), which needs no square root.
+          A step of the input is accepted after DMMFILT_SPIKE_MAXREJECT consecutive rejected codes.
+        All the stages use integer arithmetic only (the EMA and spike states have DMMFILT_FRACBITS fractional bits),
+        so that filtering costs no floating point operation on the PIC32 (no FPU).
+        The state is statically allocated and belongs to the scale of the filtered samples: it restarts when a sample
+        of another scale is filtered, as the held codes of the previous scale do not describe the current input.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, digital filter chain
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <string.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "dmmfilt.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void DMMFILT_ResetStage(DMMFILTSTAGE *pStage);
+int64_t DMMFILT_Boxcar(DMMFILTSTAGE *pStage, int64_t code);
+int64_t DMMFILT_Ema(DMMFILTSTAGE *pStage, int64_t code);
+int64_t DMMFILT_Median(DMMFILTSTAGE *pStage, int64_t code);
+int64_t DMMFILT_Spike(DMMFILTSTAGE *pStage, int64_t code);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Data, local to this module                                 */
+/* ************************************************************************** */
+/* ************************************************************************** */
+DMMFILTSTAGE rgFiltStages[DMMFILT_MAXSTAGES];
+int cntFiltStages = 0;
+int idxFiltScale = -1;      // the scale of the filtered samples, -1 when the state is empty
+
+// stage names, indexed by DMMFILT_... type, see DMMFILT_ParseStage
+const char rgszFiltNames[][8] = {"None", "Boxcar", "Ema", "Median", "Spike"};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMFILT_ClearChain
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function removes all the stages: the samples are no longer filtered.
+**
+*/
+void DMMFILT_ClearChain()
+{
+    cntFiltStages = 0;
+    idxFiltScale = -1;
+}
+
+/***	DMMFILT_AddStage
+**
+**	Parameters:
+**      uint8_t bType       - the stage type: DMMFILT_BOXCAR, DMMFILT_EMA, DMMFILT_MEDIAN or DMMFILT_SPIKE
+**      uint8_t bParam      - the stage parameter, see the DMMFILT_... stage types
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMMFILT_STAGE      0xEA   // wrong stage type or parameter, or the chain is full
+**
+**	Description:
+**		This function appends a stage to the end of the chain and restarts the filter state.
+**
+*/
+uint8_t DMMFILT_AddStage(uint8_t bType, uint8_t bParam)
+{
+    uint8_t fValid;
+    switch(bType)
+    {
+        case DMMFILT_BOXCAR:
+            fValid = (bParam >= 2) && (bParam <= DMMFILT_MAXTAPS);
+            break;
+        case DMMFILT_EMA:
+            fValid = (bParam >= 1) && (bParam <= 8);
+            break;
+        case DMMFILT_MEDIAN:
+            fValid = (bParam >= 3) && (bParam <= 9) && (bParam & 1);
+            break;
+        case DMMFILT_SPIKE:
+            fValid = (bParam >= 1) && (bParam <= 9);
+            break;
+        default:
+            fValid = 0;
+            break;
+    }
+    if(!fValid || cntFiltStages >= DMMFILT_MAXSTAGES)
+    {
+        return ERRVAL_DMMFILT_STAGE;
+    }
+    rgFiltStages[cntFiltStages].bType = bType;
+    rgFiltStages[cntFiltStages].bParam = bParam;
+    cntFiltStages++;
+    DMMFILT_Reset();
+    return ERRVAL_SUCCESS;
+}
+
+/***	DMMFILT_ParseStage
+**
+**	Parameters:
+**      char const *szStage     - the stage name followed by its parameter, for example "Median5"
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMMFILT_STAGE      0xEA   // unknown stage name, wrong parameter, or the chain is full
+**
+**	Description:
+**		This function appends to the chain the stage described by the string: "Boxcar<N>", "Ema<K>", "Median<N>" or "Spike<K>".
+**      "None" clears the chain.
+**
+*/
+uint8_t DMMFILT_ParseStage(char const *szStage)
+{
+    uint8_t bType;
+    unsigned int param;
+    size_t cch;
+    if(!strcmp(szStage, rgszFiltNames[DMMFILT_NONE]))
+    {
+        DMMFILT_ClearChain();
+        return ERRVAL_SUCCESS;
+    }
+    for(bType = DMMFILT_BOXCAR; bType < sizeof(rgszFiltNames)/sizeof(rgszFiltNames[0]); bType++)
+    {
+        cch = strlen(rgszFiltNames[bType]);
+        if(!strncmp(szStage, rgszFiltNames[bType], cch))
+        {
+            if(sscanf(szStage + cch, "%u", &param) != 1 || param > 255)
+            {
+                return ERRVAL_DMMFILT_STAGE;
+            }
+            return DMMFILT_AddStage(bType, (uint8_t)param);
+        }
+    }
+    return ERRVAL_DMMFILT_STAGE;
+}
+
+/***	DMMFILT_GetCount
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		int     - the number of stages of the chain, 0 when the samples are not filtered
+**
+**	Description:
+**		This function returns the number of stages of the chain.
+**
+*/
+int DMMFILT_GetCount()
+{
+    return cntFiltStages;
+}
+
+/***	DMMFILT_FormatChain
+**
+**	Parameters:
+**      char *pString       - the string receiving the chain description, at least 10 * DMMFILT_MAXSTAGES characters
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function describes the chain as the stages in the DMMFILT_ParseStage format, separated by comma, or "None" for an empty chain.
+**
+*/
+void DMMFILT_FormatChain(char *pString)
+{
+    int i;
+    pString[0] = 0;
+    for(i = 0; i < cntFiltStages; i++)
+    {
+        pString += sprintf(pString, i ? ",%s%u": "%s%u", rgszFiltNames[rgFiltStages[i].bType], rgFiltStages[i].bParam);
+    }
+    if(!cntFiltStages)
+    {
+        strcpy(pString, rgszFiltNames[DMMFILT_NONE]);
+    }
+}
+
+/***	DMMFILT_Reset
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function restarts the state of all the stages, for example when the measured signal left the convertor range.
+**
+*/
+void DMMFILT_Reset()
+{
+    int i;
+    for(i = 0; i < cntFiltStages; i++)
+    {
+        DMMFILT_ResetStage(&rgFiltStages[i]);
+    }
+    idxFiltScale = -1;
+}
+
+/***	DMMFILT_Apply
+**
+**	Parameters:
+**      DMMSAMPLE *pSample      - the raw sample, its code is replaced by the filtered code
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function passes the raw code of the sample through the stages of the chain, in order.
+**      The state restarts when the sample scale differs from the scale of the previously filtered samples.
+**      The filtered code is converted to value by DMM_DSampleToValue, like the raw code.
+**
+*/
+void DMMFILT_Apply(DMMSAMPLE *pSample)
+{
+    int i;
+    int64_t code = pSample->code;
+    if(pSample->idxScale != idxFiltScale)
+    {
+        DMMFILT_Reset();
+        idxFiltScale = pSample->idxScale;
+    }
+    for(i = 0; i < cntFiltStages; i++)
+    {
+        switch(rgFiltStages[i].bType)
+        {
+            case DMMFILT_BOXCAR:
+                code = DMMFILT_Boxcar(&rgFiltStages[i], code);
+                break;
+            case DMMFILT_EMA:
+                code = DMMFILT_Ema(&rgFiltStages[i], code);
+                break;
+            case DMMFILT_MEDIAN:
+                code = DMMFILT_Median(&rgFiltStages[i], code);
+                break;
+            case DMMFILT_SPIKE:
+                code = DMMFILT_Spike(&rgFiltStages[i], code);
+                break;
+        }
+    }
+    pSample->code = code;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMFILT_ResetStage
+**
+**	Parameters:
+**      DMMFILTSTAGE *pStage    - the stage
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function empties the state of a stage, keeping its type and parameter.
+**
+*/
+void DMMFILT_ResetStage(DMMFILTSTAGE *pStage)
+{
+    pStage->cntCodes = 0;
+    pStage->idxNext = 0;
+    pStage->cntRejected = 0;
+    pStage->sum = 0;
+    pStage->acc = 0;
+    pStage->dev = 0;
+    pStage->last = 0;
+}
+
+/***	DMMFILT_Boxcar
+**
+**	Parameters:
+**      DMMFILTSTAGE *pStage    - the stage, bParam is the number of codes N
+**      int64_t code            - the input code
+**
+**	Return Value:
+**		int64_t     - the rounded mean of the last N codes (of the codes held, until N codes were received)
+**
+**	Description:
+**		This function implements the boxcar stage, in constant time using the running sum of the held codes.
+**
+*/
+int64_t DMMFILT_Boxcar(DMMFILTSTAGE *pStage, int64_t code)
+{
+    int64_t half;
+    if(pStage->cntCodes < pStage->bParam)
+    {
+        pStage->cntCodes++;
+    }
+    else
+    {
+        pStage->sum -= pStage->rgCodes[pStage->idxNext];    // the oldest code leaves the window
+    }
+    pStage->rgCodes[pStage->idxNext] = code;
+    pStage->sum += code;
+    if(++pStage->idxNext >= pStage->bParam)
+    {
+        pStage->idxNext = 0;
+    }
+    half = pStage->cntCodes >> 1;
+    return ((pStage->sum >= 0) ? pStage->sum + half: pStage->sum - half) / pStage->cntCodes;
+}
+
+/***	DMMFILT_Ema
+**
+**	Parameters:
+**      DMMFILTSTAGE *pStage    - the stage, bParam is the shift K
+**      int64_t code            - the input code
+**
+**	Return Value:
+**		int64_t     - the rounded filtered code
+**
+**	Description:
+**		This function implements the exponential IIR stage y += (x - y) / 2^K, the division being a shift.
+**      The state keeps DMMFILT_FRACBITS fractional bits, so that small input changes are not lost by the shift.
+**      The first code initializes the state.
+**
+*/
+int64_t DMMFILT_Ema(DMMFILTSTAGE *pStage, int64_t code)
+{
+    int64_t x = code * (1 << DMMFILT_FRACBITS);
+    if(!pStage->cntCodes)
+    {
+        pStage->cntCodes = 1;
+        pStage->acc = x;
+    }
+    else
+    {
+        pStage->acc += (x - pStage->acc) >> pStage->bParam;
+    }
+    return (pStage->acc + (1 << (DMMFILT_FRACBITS - 1))) >> DMMFILT_FRACBITS;
+}
+
+/***	DMMFILT_Median
+**
+**	Parameters:
+**      DMMFILTSTAGE *pStage    - the stage, bParam is the number of codes N
+**      int64_t code            - the input code
+**
+**	Return Value:
+**		int64_t     - the median of the last N codes (of the codes held, until N codes were received)
+**
+**	Description:
+**		This function implements the median stage. The held codes are copied and sorted by insertion,
+**      which is the fastest for the small N allowed (at most 9).
+**
+*/
+int64_t DMMFILT_Median(DMMFILTSTAGE *pStage, int64_t code)
+{
+    int64_t rgSorted[DMMFILT_MAXTAPS];
+    int64_t v;
+    int i, j;
+    if(pStage->cntCodes < pStage->bParam)
+    {
+        pStage->cntCodes++;
+    }
+    pStage->rgCodes[pStage->idxNext] = code;
+    if(++pStage->idxNext >= pStage->bParam)
+    {
+        pStage->idxNext = 0;
+    }
+    for(i = 0; i < pStage->cntCodes; i++)
+    {
+        v = pStage->rgCodes[i];
+        for(j = i; j > 0 && rgSorted[j - 1] > v; j--)
+        {
+            rgSorted[j] = rgSorted[j - 1];
+        }
+        rgSorted[j] = v;
+    }
+    return rgSorted[(pStage->cntCodes - 1) >> 1];
+}
+
+/***	DMMFILT_Spike
+**
+**	Parameters:
+**      DMMFILTSTAGE *pStage    - the stage, bParam is the rejection threshold K, in sigma units
+**      int64_t code            - the input code
+**
+**	Return Value:
+**		int64_t     - the input code if accepted, otherwise the last accepted code
+**
+**	Description:
+**		This function implements the spike rejection stage. The running mean and mean absolute deviation are exponential averages
+**      (1/8 weight of the new code) of the accepted codes. Sigma is estimated as 1.25 times the mean absolute deviation,
+**      at least 1 code, so that a noise free input does not reject the changes of 1 code.
+**      A code further than K sigma from the mean is dropped and the last accepted code is returned instead.
+**      The first DMMFILT_SPIKE_WARMUP codes are always accepted, while the estimates build up.
+**      After DMMFILT_SPIKE_MAXREJECT consecutive rejected codes the input is considered to have stepped:
+**      the code is accepted and the mean restarts from it.
+**
+*/
+int64_t DMMFILT_Spike(DMMFILTSTAGE *pStage, int64_t code)
+{
+    int64_t x = code * (1 << DMMFILT_FRACBITS);
+    int64_t diff, thr;
+    if(!pStage->cntCodes)
+    {
+        pStage->acc = x;
+    }
+    diff = x - pStage->acc;
+    if(diff < 0)
+    {
+        diff = -diff;
+    }
+    if(pStage->cntCodes >= DMMFILT_SPIKE_WARMUP)
+    {
+        thr = (pStage->dev > (1 << DMMFILT_FRACBITS)) ? pStage->dev: (1 << DMMFILT_FRACBITS);
+        // |x - mean| > K * 1.25 * deviation
+        if((diff << 2) > thr * 5 * pStage->bParam)
+        {
+            if(++pStage->cntRejected <= DMMFILT_SPIKE_MAXREJECT)
+            {
+                return pStage->last;
+            }
+            // the input stepped, restart the mean from the new code
+            pStage->acc = x;
+            diff = 0;
+        }
+    }
+    else
+    {
+        pStage->cntCodes++;
+    }
+    pStage->cntRejected = 0;
+    pStage->acc += ((x - pStage->acc) >> 3);
+    pStage->dev += ((diff - pStage->dev) >> 3);
+    pStage->last = code;
+    return code;
+}
+
+/* *****************************************************************************
+ End of File
+ */
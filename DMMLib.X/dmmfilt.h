@@ -0,0 +1,81 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmfilt.h
+
+  @Description
+        This file contains the declaration for the functions of the DMMFILT module (digital filter chain of the raw samples).
+        The DMMFILT functions are defined in dmmfilt.c source file.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, digital filter chain
+
+ */
+/* ************************************************************************** */
+
+#ifndef _DMMFILT_H    /* Guard against multiple inclusion */
+#define _DMMFILT_H
+
+#include "stdint.h"
+#include "dmm.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define DMMFILT_MAXSTAGES       4       // maximum number of stages of the chain
+#define DMMFILT_MAXTAPS         16      // maximum number of samples held by a boxcar or median stage
+
+// stage types, see DMMFILT_AddStage
+#define DMMFILT_NONE            0
+#define DMMFILT_BOXCAR          1       // mean of the last N codes, N = 2 .. DMMFILT_MAXTAPS
+#define DMMFILT_EMA             2       // exponential IIR, y += (x - y) / 2^K, K = 1 .. 8
+#define DMMFILT_MEDIAN          3       // median of the last N codes, N odd = 3 .. 9
+#define DMMFILT_SPIKE           4       // drops the codes further than K sigma from the mean, K = 1 .. 9
+
+#define DMMFILT_FRACBITS        8       // fractional bits of the EMA and spike stages state
+#define DMMFILT_SPIKE_WARMUP    8       // codes accepted by the spike stage before rejecting, while the noise estimate builds up
+#define DMMFILT_SPIKE_MAXREJECT 3       // consecutive rejected codes after which the spike stage accepts a step of the input
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// a stage of the filter chain
+typedef struct _DMMFILTSTAGE{
+    uint8_t bType;                      // DMMFILT_...
+    uint8_t bParam;                     // N or K, see the stage types
+    uint8_t cntCodes;                   // codes held (boxcar, median) or received (spike warm up)
+    uint8_t idxNext;                    // storage position of the next code (boxcar, median)
+    uint8_t cntRejected;                // consecutive rejected codes (spike)
+    int64_t sum;                        // sum of the held codes (boxcar)
+    int64_t acc;                        // filtered code (EMA) or mean (spike), DMMFILT_FRACBITS fractional bits
+    int64_t dev;                        // mean absolute deviation (spike), DMMFILT_FRACBITS fractional bits
+    int64_t last;                       // last accepted code (spike)
+    int64_t rgCodes[DMMFILT_MAXTAPS];   // held codes (boxcar, median)
+} DMMFILTSTAGE;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void DMMFILT_ClearChain();
+uint8_t DMMFILT_AddStage(uint8_t bType, uint8_t bParam);
+uint8_t DMMFILT_ParseStage(char const *szStage);
+int DMMFILT_GetCount();
+void DMMFILT_FormatChain(char *pString);
+void DMMFILT_Reset();
+void DMMFILT_Apply(DMMSAMPLE *pSample);
+
+#endif /* _DMMFILT_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,702 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmsim.c
+
+  @Description
+        This file groups the functions that implement the DMMSIM module.
+        The module is only built for host (Linux) builds, when DMM_HOST is defined.
+        It is a register level model of the DMM converter, attached to the SPIMOCK bus on the CS_DMM slave select.
+        The SPI protocol is the one used by the DMM module: a command byte (7 bits address, 1 bit R/W), 
+        followed, for reads, by an extra clock (SPI Read Period) and then by the data bytes, with address auto increment.
+        Writing 0x60 to register 0x37 resets the model. The configuration registers (0x1F - 0x36) are stored and 
+        can be read back, while the status registers (0x00 - 0x1E) are updated by the simulated conversions.
+        A conversion is performed each conversion period of simulated time. It samples the configured signal 
+        (DC level, sine, gaussian noise), fills the AD1, LPF, RMS and peak registers and sets the AD1 / RMS 
+        conversion done flags in the INTF register. Periodic not ready and overload conversions can be configured.
+        The interrupt output (HAL_PIN_DMMINT, active low) is active while a flag enabled in the INTE register is set in INTF.
+        The relays (RLD, RLU, RLI pins) and the configuration writes are tracked to model the settling: after a relay change 
+        or a configuration write (except INTE) or reset, the signal gain rises exponentially from DMMSIM_UNSETTLED_GAIN to 1,
+        during tusRelaySettle or tusCfgSettle (DMMSIM_SETTLE_TAUS time constants). A conversion whose settling error exceeds 
+        tolSettleCode codes is not settled: the commands that read its AD1 or RMS register while the last INTF read returned 
+        conversion done flags (the value is used) are counted, so that the DMM_SetScale settling can be checked.
+        The model does not check the configuration registers content.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, DMM converter simulator
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifdef DMM_HOST
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "spimock.h"
+#include "dmm.h"
+#include "dmmsim.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void DMMSIM_Select(uint8_t fSelected);
+void DMMSIM_Clock(uint8_t bMosi);
+uint8_t DMMSIM_GetMiso();
+void DMMSIM_Time();
+void DMMSIM_UpdateInt();
+uint8_t DMMSIM_ReadReg(int addr);
+void DMMSIM_WriteReg(int addr, uint8_t bVal);
+void DMMSIM_Reset();
+void DMMSIM_UpdateConversions();
+void DMMSIM_Convert(uint64_t tnsConv);
+void DMMSIM_SetRegVal(int addr, int cbVal, int64_t val);
+void DMMSIM_UpdateRelays();
+void DMMSIM_Unsettle(uint64_t tnsFrom, uint32_t tusSettle);
+double DMMSIM_Gauss();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+const SPIMOCK_SLAVE dmmSimSlave = {DMMSIM_Select, DMMSIM_Clock, DMMSIM_GetMiso, DMMSIM_Time};
+
+uint8_t rgbSimRegs[DMMSIM_CNTREGS];
+DMMSIM_CFG simCfg;
+DMMSIM_STATS simStats;
+uint32_t rngSimState = 1;
+
+// conversions
+uint64_t tnsSimLastConv = 0;
+uint32_t idxSimConv = 0;
+
+// settling
+uint8_t bSimRelays = 0;         // the relay pins, RLD bit 0, RLU bit 1, RLI bit 2
+uint64_t tnsSimLastTime = 0;    // the simulated time of the previous DMMSIM_Time call
+uint64_t tnsSimSettled = 0;     // the conversions are settled starting with this time
+uint64_t tnsSimSettleFrom = 0;  // the start of the settling
+double dSimSettleTau = 1;       // the settling time constant, ns
+uint8_t fSimUnsettledConv = 0;  // the registers hold a conversion performed while not settled
+uint8_t fSimIntfReady = 0;      // the last INTF read returned conversion done flags
+uint8_t fSimCmdUnsettled = 0;   // the current command read the AD1 or RMS register of a conversion performed while not settled
+uint8_t fSimCmdSeen = 0;        // the conversion read by the current command was reported as done
+
+// SPI protocol state
+int cntSimBits = 0;
+uint8_t bSimCmd = 0;
+int addrSim = 0;
+uint8_t bSimIn = 0;
+uint8_t bSimOut = 0;
+uint8_t bSimMiso = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMSIM_Init
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function initializes the DMMSIM module with the default configuration (see DMMSIM_GetDefaultCfg), 
+**      resets the registers and attaches the model to the SPIMOCK bus, as DMM slave.
+**          
+*/
+void DMMSIM_Init()
+{
+    DMMSIM_CFG cfg;
+    DMMSIM_GetDefaultCfg(&cfg);
+    DMMSIM_SetCfg(&cfg);
+    DMMSIM_ResetStats();
+    DMMSIM_Reset();
+    SPIMOCK_AttachSlave(SPIMOCK_SLAVE_DMM, &dmmSimSlave);
+}
+
+/***	DMMSIM_GetDefaultCfg
+**
+**	Parameters:
+**		DMMSIM_CFG *pCfg    - the structure receiving the default configuration
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function provides the default configuration: 0 input signal, DMM_CONV_TUS conversion period (1 ms), 
+**      no not ready / overload conversions, INTF flags cleared when read only if the library is built with DMM_INTF_READCLEAR 
+**      (the read-clear behaviour is not confirmed on the hardware, see dmm.h), 12 ms relay settling, 1.2 ms configuration settling, 
+**      32 codes settling tolerance.
+**          
+*/
+void DMMSIM_GetDefaultCfg(DMMSIM_CFG *pCfg)
+{
+    memset(pCfg, 0, sizeof(DMMSIM_CFG));
+    pCfg->acFrq = 50;
+    pCfg->tusConv = DMM_CONV_TUS;
+    pCfg->fIntfReadClear = DMM_INTF_READCLEAR;
+    pCfg->seed = 1;
+    pCfg->tusRelaySettle = 12000;
+    pCfg->tusCfgSettle = 1200;
+    pCfg->tolSettleCode = 32;
+}
+
+/***	DMMSIM_SetCfg
+**
+**	Parameters:
+**		const DMMSIM_CFG *pCfg  - the configuration
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function sets the simulated signal and converter behavior, and restarts the noise generator. 
+**      The new configuration is used starting with the next conversion.
+**          
+*/
+void DMMSIM_SetCfg(const DMMSIM_CFG *pCfg)
+{
+    simCfg = *pCfg;
+    rngSimState = pCfg->seed ? pCfg->seed: 1;
+}
+
+/***	DMMSIM_GetCfg
+**
+**	Parameters:
+**		DMMSIM_CFG *pCfg    - the structure receiving the current configuration
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function provides the current configuration.
+**          
+*/
+void DMMSIM_GetCfg(DMMSIM_CFG *pCfg)
+{
+    *pCfg = simCfg;
+}
+
+/***	DMMSIM_GetReg
+**
+**	Parameters:
+**		int addr    - the register address
+**
+**	Return Value:
+**		uint8_t     - the register value
+**
+**	Description:
+**		This function returns the value of a register without any side effect (the INTF flags are not cleared).
+**          
+*/
+uint8_t DMMSIM_GetReg(int addr)
+{
+    return (addr >= 0 && addr < DMMSIM_CNTREGS) ? rgbSimRegs[addr]: 0;
+}
+
+/***	DMMSIM_GetStats
+**
+**	Parameters:
+**		DMMSIM_STATS *pStats    - the structure receiving the activity counters
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function copies the activity counters.
+**          
+*/
+void DMMSIM_GetStats(DMMSIM_STATS *pStats)
+{
+    *pStats = simStats;
+}
+
+/***	DMMSIM_ResetStats
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function clears the activity counters.
+**          
+*/
+void DMMSIM_ResetStats()
+{
+    memset(&simStats, 0, sizeof(simStats));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMSIM_Select
+**
+**	Parameters:
+**		uint8_t fSelected   - 1 when CS_DMM is activated, 0 when it is deactivated
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		When the model is selected, the conversions corresponding to the elapsed simulated time are performed 
+**      and a new command is expected.
+**      When it is deselected, a command that read the values of a not settled conversion reported as done is counted.
+**          
+*/
+void DMMSIM_Select(uint8_t fSelected)
+{
+    if(fSelected)
+    {
+        DMMSIM_UpdateConversions();
+        cntSimBits = 0;
+        bSimCmd = 0;
+        bSimMiso = 0;
+        fSimCmdUnsettled = 0;
+        fSimCmdSeen = 0;
+    }
+    else if(fSimCmdUnsettled && fSimCmdSeen)
+    {
+        simStats.cntUnsettledReads++;
+    }
+}
+
+/***	DMMSIM_Clock
+**
+**	Parameters:
+**		uint8_t bMosi   - the MOSI level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function implements the SPI protocol, for each clock rising edge. 
+**      The first 8 bits are the command byte. For writes, each following 8 bits are written to the addressed register.
+**      For reads, the 9th clock is the read period, then the addressed registers are shifted out, MSB first.
+**          
+*/
+void DMMSIM_Clock(uint8_t bMosi)
+{
+    int idxBit;
+    cntSimBits++;
+    if(cntSimBits <= 8)
+    {
+        bSimCmd = (bSimCmd << 1) | (bMosi & 1);
+        if(cntSimBits == 8)
+        {
+            addrSim = bSimCmd >> 1;
+            if(bSimCmd & 1)
+            {
+                simStats.cntReadCmds++;
+            }
+            else
+            {
+                simStats.cntWriteCmds++;
+            }
+        }
+        return;
+    }
+    if(bSimCmd & 1)
+    {
+        // read
+        idxBit = cntSimBits - 10;
+        if(idxBit < 0)
+        {
+            return; // read period
+        }
+        if((idxBit % 8) == 0)
+        {
+            bSimOut = DMMSIM_ReadReg(addrSim++);
+        }
+        bSimMiso = (bSimOut >> (7 - (idxBit % 8))) & 1;
+    }
+    else
+    {
+        // write
+        idxBit = cntSimBits - 9;
+        bSimIn = (bSimIn << 1) | (bMosi & 1);
+        if((idxBit % 8) == 7)
+        {
+            DMMSIM_WriteReg(addrSim++, bSimIn);
+        }
+    }
+}
+
+/***	DMMSIM_GetMiso
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - the DO level
+**
+**	Description:
+**		This function returns the data output level.
+**          
+*/
+uint8_t DMMSIM_GetMiso()
+{
+    return bSimMiso;
+}
+
+/***	DMMSIM_Time
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function is called when the simulated time advances. It checks the relay pins, then it performs the elapsed conversions, 
+**      so that the interrupt output is activated at the conversion time.
+**          
+*/
+void DMMSIM_Time()
+{
+    DMMSIM_UpdateRelays();
+    DMMSIM_UpdateConversions();
+    tnsSimLastTime = SPIMOCK_GetTimeNs();
+}
+
+/***	DMMSIM_UpdateInt
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function sets the interrupt output level: low while a flag enabled in the INTE register is set in the INTF register.
+**          
+*/
+void DMMSIM_UpdateInt()
+{
+    uint8_t bActive = rgbSimRegs[DMMSIM_REG_INTF] & rgbSimRegs[DMMSIM_REG_INTE] & (DMMSIM_INTF_AD1 | DMMSIM_INTF_RMS);
+    SPIMOCK_SetInput(HAL_PIN_DMMINT, !bActive);
+}
+
+/***	DMMSIM_ReadReg
+**
+**	Parameters:
+**		int addr    - the register address
+**
+**	Return Value:
+**		uint8_t     - the register value
+**
+**	Description:
+**		This function returns a register value for a read command. 
+**      When the INTF register is read and fIntfReadClear is set, the conversion done flags are cleared.
+**      The reads of the AD1 / RMS registers of a not settled conversion and of the INTF register are tracked, see DMMSIM_Select.
+**          
+*/
+uint8_t DMMSIM_ReadReg(int addr)
+{
+    uint8_t bVal;
+    if(addr < 0 || addr >= DMMSIM_CNTREGS)
+    {
+        return 0;
+    }
+    bVal = rgbSimRegs[addr];
+    if((addr == DMMSIM_REG_AD1 || addr == DMMSIM_REG_RMS) && fSimUnsettledConv)
+    {
+        // the done flags were returned by a previous command (INTF polling)
+        fSimCmdUnsettled = 1;
+        fSimCmdSeen = fSimIntfReady;
+    }
+    if(addr == DMMSIM_REG_INTF)
+    {
+        simStats.cntStatusReads++;
+        fSimIntfReady = (bVal & (DMMSIM_INTF_AD1 | DMMSIM_INTF_RMS)) ? 1: 0;
+        if(fSimCmdUnsettled)
+        {
+            // the values and the done flags are read by the same command (full status)
+            fSimCmdSeen = fSimIntfReady;
+        }
+        if(simCfg.fIntfReadClear)
+        {
+            rgbSimRegs[addr] &= ~(DMMSIM_INTF_AD1 | DMMSIM_INTF_RMS);
+            DMMSIM_UpdateInt();
+        }
+    }
+    return bVal;
+}
+
+/***	DMMSIM_WriteReg
+**
+**	Parameters:
+**		int addr        - the register address
+**      uint8_t bVal    - the value
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function writes a register for a write command. Only the configuration registers are writable.
+**      Writing DMMSIM_RESETVAL to DMMSIM_REG_RESET resets the model.
+**          
+*/
+void DMMSIM_WriteReg(int addr, uint8_t bVal)
+{
+    if(addr == DMMSIM_REG_RESET)
+    {
+        if(bVal == DMMSIM_RESETVAL)
+        {
+            simStats.cntResets++;
+            DMMSIM_Reset();
+        }
+    }
+    else if(addr >= DMMSIM_REG_CFG && addr < DMMSIM_CNTREGS)
+    {
+        rgbSimRegs[addr] = bVal;
+        DMMSIM_UpdateInt();
+        if(addr != DMMSIM_REG_INTE)
+        {
+            DMMSIM_Unsettle(SPIMOCK_GetTimeNs(), simCfg.tusCfgSettle);
+        }
+    }
+}
+
+/***	DMMSIM_Reset
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function clears all the registers and restarts the conversions, the first one being performed 
+**      one conversion period later.
+**          
+*/
+void DMMSIM_Reset()
+{
+    memset(rgbSimRegs, 0, sizeof(rgbSimRegs));
+    tnsSimLastConv = SPIMOCK_GetTimeNs();
+    idxSimConv = 0;
+    fSimUnsettledConv = 0;
+    fSimIntfReady = 0;
+    DMMSIM_UpdateInt();
+    DMMSIM_Unsettle(tnsSimLastConv, simCfg.tusCfgSettle);
+}
+
+/***	DMMSIM_UpdateConversions
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function performs the conversions for the simulated time elapsed since the last one. 
+**      When several conversion periods elapsed, only the last conversion is computed, as the registers only hold the last result.
+**          
+*/
+void DMMSIM_UpdateConversions()
+{
+    uint64_t tnsNow = SPIMOCK_GetTimeNs();
+    uint64_t tnsPeriod = (uint64_t)simCfg.tusConv * 1000;
+    uint64_t cntConv;
+    if(!tnsPeriod)
+    {
+        tnsPeriod = 1;
+    }
+    if(tnsNow - tnsSimLastConv < tnsPeriod)
+    {
+        return;
+    }
+    cntConv = (tnsNow - tnsSimLastConv) / tnsPeriod;
+    tnsSimLastConv += cntConv * tnsPeriod;
+    idxSimConv += (uint32_t)cntConv;
+    simStats.cntConversions += (uint32_t)cntConv;
+    DMMSIM_Convert(tnsSimLastConv);
+}
+
+/***	DMMSIM_Convert
+**
+**	Parameters:
+**		uint64_t tnsConv    - the conversion time, simulated ns
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function computes the conversion results: AD1 and LPF (DC level plus sine and noise, saturated to 24 bits), 
+**      RMS (mean square of the AC component, 40 bits), peak min / max, and sets the conversion done flags.
+**      The signal is scaled by the pfnInputGain range gain, when provided.
+**          
+*/
+void DMMSIM_Convert(uint64_t tnsConv)
+{
+    double dCode, dMeanSq;
+    int fOverload = simCfg.cntOverloadPeriod > 0 && (idxSimConv % simCfg.cntOverloadPeriod) == 0;
+    int fNotReady = simCfg.cntNotReadyPeriod > 0 && (idxSimConv % simCfg.cntNotReadyPeriod) == 0;
+    double dGain = 1;
+    double dInput = simCfg.pfnInputGain ? simCfg.pfnInputGain(): 1;    // codes per signal unit
+    double dcCode = dInput * simCfg.dcCode, acCode = dInput * simCfg.acCode, noiseCode = dInput * simCfg.noiseCode;
+
+    if(tnsConv < tnsSimSettled)
+    {
+        // exponential settling, starting from DMMSIM_UNSETTLED_GAIN
+        dGain = 1 - (1 - DMMSIM_UNSETTLED_GAIN) * exp(-(double)(tnsConv > tnsSimSettleFrom ? tnsConv - tnsSimSettleFrom: 0) / dSimSettleTau);
+    }
+    fSimUnsettledConv = (1 - dGain) * (fabs(dcCode) + fabs(acCode)) > simCfg.tolSettleCode;
+    dCode = dGain * (dcCode + acCode * sin(2 * M_PI * simCfg.acFrq * (tnsConv * 1e-9))) + noiseCode * DMMSIM_Gauss();
+    if(fOverload)
+    {
+        dCode = (dcCode < 0) ? -DMMSIM_AD1_FULLSCALE: DMMSIM_AD1_FULLSCALE;
+    }
+    if(dCode > DMMSIM_AD1_FULLSCALE)
+    {
+        dCode = DMMSIM_AD1_FULLSCALE;
+    }
+    if(dCode < -DMMSIM_AD1_FULLSCALE)
+    {
+        dCode = -DMMSIM_AD1_FULLSCALE;
+    }
+    DMMSIM_SetRegVal(DMMSIM_REG_AD1, 3, lround(dCode));     // AD1
+    DMMSIM_SetRegVal(0x06, 3, lround(dcCode));       // LPF
+    DMMSIM_SetRegVal(0x0E, 3, lround(dcCode - fabs(acCode)));    // peak min
+    DMMSIM_SetRegVal(0x11, 3, lround(dcCode + fabs(acCode)));    // peak max
+    
+    dMeanSq = dGain * dGain * acCode * acCode / 2;
+    dCode = noiseCode * DMMSIM_Gauss();
+    dMeanSq += dCode * dCode;
+    if(dMeanSq > (double)0xFFFFFFFFFFull)
+    {
+        dMeanSq = (double)0xFFFFFFFFFFull;
+    }
+    DMMSIM_SetRegVal(DMMSIM_REG_RMS, 5, llround(dMeanSq));  // RMS
+    
+    if(!fNotReady)
+    {
+        rgbSimRegs[DMMSIM_REG_INTF] |= DMMSIM_INTF_AD1 | DMMSIM_INTF_RMS;
+        DMMSIM_UpdateInt();
+    }
+}
+
+/***	DMMSIM_UpdateRelays
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function reads the relay pins. When they changed since the previous call, the conversions are not settled 
+**      for tusRelaySettle, starting with the previous call time (the earliest time the relays could have changed).
+**          
+*/
+void DMMSIM_UpdateRelays()
+{
+    uint8_t bRelays = SPIMOCK_PeekPin(HAL_PIN_RLD) | (SPIMOCK_PeekPin(HAL_PIN_RLU) << 1) | (SPIMOCK_PeekPin(HAL_PIN_RLI) << 2);
+    if(bRelays != bSimRelays)
+    {
+        bSimRelays = bRelays;
+        DMMSIM_Unsettle(tnsSimLastTime, simCfg.tusRelaySettle);
+    }
+}
+
+/***	DMMSIM_Unsettle
+**
+**	Parameters:
+**		uint64_t tnsFrom        - the time of the event, simulated ns
+**		uint32_t tusSettle      - the settling time, us
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function extends the not settled interval, so that the conversions are settled at least tusSettle after tnsFrom.
+**      When the interval is extended, the settling restarts at tnsFrom with a tusSettle / DMMSIM_SETTLE_TAUS time constant.
+**          
+*/
+void DMMSIM_Unsettle(uint64_t tnsFrom, uint32_t tusSettle)
+{
+    uint64_t tnsSettled = tnsFrom + (uint64_t)tusSettle * 1000;
+    if(tnsSettled > tnsSimSettled)
+    {
+        tnsSimSettled = tnsSettled;
+        tnsSimSettleFrom = tnsFrom;
+        dSimSettleTau = tusSettle * 1000.0 / DMMSIM_SETTLE_TAUS;
+    }
+}
+
+/***	DMMSIM_SetRegVal
+**
+**	Parameters:
+**		int addr        - the address of the first register
+**      int cbVal       - the number of registers
+**      int64_t val     - the value
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function stores a multi byte value, LSB first, as the converter registers are read by the DMM module.
+**          
+*/
+void DMMSIM_SetRegVal(int addr, int cbVal, int64_t val)
+{
+    int i;
+    for(i = 0; i < cbVal; i++)
+    {
+        rgbSimRegs[addr + i] = (uint8_t)(val >> (8 * i));
+    }
+}
+
+/***	DMMSIM_Gauss
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		double  - a pseudo random value
+**
+**	Description:
+**		This function returns an approximately normal distributed value, with 0 mean and 1 standard deviation 
+**      (sum of 12 uniform values), using a xorshift generator, so that the sequence is repeatable for a given seed.
+**          
+*/
+double DMMSIM_Gauss()
+{
+    int i;
+    double dSum = 0;
+    for(i = 0; i < 12; i++)
+    {
+        rngSimState ^= rngSimState << 13;
+        rngSimState ^= rngSimState >> 17;
+        rngSimState ^= rngSimState << 5;
+        dSum += rngSimState / 4294967296.0;
+    }
+    return dSum - 6.0;
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    dmmsim.h
+
+  @Description
+        This file contains the declaration for the functions of DMMSIM module.
+        The DMMSIM module is only built for host (Linux) builds, when DMM_HOST is defined.
+        The DMMSIM functions are defined in dmmsim.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, DMM converter simulator
+
+ */
+/* ************************************************************************** */
+
+#ifndef _DMMSIM_H    /* Guard against multiple inclusion */
+#define _DMMSIM_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define DMMSIM_CNTREGS          0x38    // registers 0x00 - 0x37
+#define DMMSIM_REG_AD1          0x00
+#define DMMSIM_REG_RMS          0x09
+#define DMMSIM_REG_INTF         0x1E
+#define DMMSIM_REG_CFG          0x1F    // first configuration register (INTE)
+#define DMMSIM_REG_INTE         0x1F    // interrupt enable, same bits as INTF
+#define DMMSIM_REG_RESET        0x37
+#define DMMSIM_RESETVAL         0x60
+
+#define DMMSIM_INTF_AD1         0x04    // AD1 conversion done
+#define DMMSIM_INTF_RMS         0x10    // RMS conversion done
+
+#define DMMSIM_AD1_FULLSCALE    0x7FFFFF
+#define DMMSIM_UNSETTLED_GAIN   0.5     // the signal gain at the start of the settling
+#define DMMSIM_SETTLE_TAUS      15.2    // time constants in the settling time: ln(0.5 * 2^23), the full scale error is then below 1 code
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// simulated input signal and converter behavior
+// the signal is expressed in AD1 codes (the library value is the code multiplied by the scale factor), 
+// the RMS register holds the mean square of the AC component (sine and noise), also in AD1 codes
+// when pfnInputGain is provided, the signal is expressed in signal units (V, A, Ohm) and scaled by the selected range gain
+typedef struct _DMMSIM_CFG{
+    double dcCode;              // DC level
+    double acCode;              // sine amplitude (peak)
+    double acFrq;               // sine frequency, Hz
+    double noiseCode;           // gaussian noise standard deviation
+    uint32_t tusConv;           // conversion period, us
+    int cntNotReadyPeriod;      // each cntNotReadyPeriod-th conversion does not set the ready flags, 0 to disable
+    int cntOverloadPeriod;      // each cntOverloadPeriod-th conversion saturates AD1, 0 to disable
+    uint8_t fIntfReadClear;     // reading the INTF register clears the conversion done flags
+    uint32_t seed;              // noise generator seed
+    uint32_t tusRelaySettle;    // settling time after a relay change, us
+    uint32_t tusCfgSettle;      // settling time after a configuration write or reset, us
+    double tolSettleCode;       // a conversion whose settling error exceeds this number of codes is not settled
+    double (*pfnInputGain)();   // if not NULL, returns the AD1 codes per signal unit of the selected range: 
+                                // the signal (dcCode, acCode, noiseCode) is then expressed in signal units
+} DMMSIM_CFG;
+
+// activity counters
+typedef struct _DMMSIM_STATS{
+    uint32_t cntConversions;    // conversions performed
+    uint32_t cntReadCmds;       // read commands
+    uint32_t cntWriteCmds;      // write commands
+    uint32_t cntStatusReads;    // read commands that returned the INTF register
+    uint32_t cntResets;         // reset commands
+    uint32_t cntUnsettledReads; // commands that read the AD1 / RMS values of a conversion performed while not settled
+} DMMSIM_STATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void DMMSIM_Init();
+void DMMSIM_GetDefaultCfg(DMMSIM_CFG *pCfg);
+void DMMSIM_SetCfg(const DMMSIM_CFG *pCfg);
+void DMMSIM_GetCfg(DMMSIM_CFG *pCfg);
+uint8_t DMMSIM_GetReg(int addr);
+void DMMSIM_GetStats(DMMSIM_STATS *pStats);
+void DMMSIM_ResetStats();
+
+#endif /* _DMMSIM_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,315 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmstats.c
+
+  @Description
+        This file groups the functions that implement the DMMSTATS module (streaming statistics and moving average of the DMM values).
+        The statistics (count, mean, variance, standard deviation, minimum, maximum and RMS) are updated in constant time
+        and constant memory for each value, so they are computed in the same pass that acquires the values, without buffering them.
+        The mean and the variance use the Welford algorithm: the running mean and the sum of the squared differences from the mean
+        are updated from the difference between the new value and the current mean. Unlike the sum and the sum of squares,
+        these stay accurate when the values have a large offset compared to their spread (for example a stable 4.99 V value).
+        The RMS is computed from the mean and the variance: mean square = mean^2 + population variance.
+        The overload (+/- INFINITY) and NAN values are never included, the policy selected by DMMSTATS_Init either stops
+        the accumulation at the first of them or skips and counts them.
+        The moving average window (DMMSTATS_WND) keeps the last values in a circular storage together with their running sum,
+        so that each new value produces a new average in constant time, at the rate of the values.
+        The running sum is recomputed from the storage each time the storage position wraps, so that the rounding errors 
+        of the additions and subtractions do not accumulate; this keeps the amortized cost constant.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, streaming statistics
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <math.h>
+#include "stdint.h"
+#include "dmmstats.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t DMM_IsNotANumber(double dVal);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	DMMSTATS_Init
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**      uint8_t bPolicy         - the invalid values policy:
+**          DMMSTATS_POLICY_STOP    0   // the first invalid value stops the accumulation
+**          DMMSTATS_POLICY_SKIP    1   // the invalid values are counted and excluded
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function clears the statistics and sets the policy applied to the overload (+/- INFINITY) and NAN values.
+**
+*/
+void DMMSTATS_Init(DMMSTATS *pStats, uint8_t bPolicy)
+{
+    pStats->cntValues = 0;
+    pStats->cntOverloads = 0;
+    pStats->cntInvalid = 0;
+    pStats->bPolicy = bPolicy;
+    pStats->fStopped = 0;
+    pStats->dExcluded = 0.0;
+    pStats->dMean = 0.0;
+    pStats->dM2 = 0.0;
+    pStats->dMin = INFINITY;
+    pStats->dMax = -INFINITY;
+}
+
+/***	DMMSTATS_Add
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**      double dVal             - the value
+**
+**	Return Value:
+**		uint8_t     - 1 if the accumulation continues, 0 if it was stopped by an invalid value (DMMSTATS_POLICY_STOP)
+**
+**	Description:
+**		This function updates the statistics with a value, in constant time.
+**      An overload (+/- INFINITY) or NAN value is counted and kept in dExcluded, it is not included in the statistics.
+**      With DMMSTATS_POLICY_STOP it stops the accumulation: this and the following values are ignored.
+**
+*/
+uint8_t DMMSTATS_Add(DMMSTATS *pStats, double dVal)
+{
+    double dDelta;
+    if(pStats->fStopped)
+    {
+        return 0;
+    }
+    if(DMM_IsNotANumber(dVal) || dVal == INFINITY || dVal == -INFINITY)
+    {
+        if(DMM_IsNotANumber(dVal))
+        {
+            pStats->cntInvalid++;
+        }
+        else
+        {
+            pStats->cntOverloads++;
+        }
+        pStats->dExcluded = dVal;
+        pStats->fStopped = (pStats->bPolicy == DMMSTATS_POLICY_STOP);
+        return !pStats->fStopped;
+    }
+    // Welford update
+    pStats->cntValues++;
+    dDelta = dVal - pStats->dMean;
+    pStats->dMean += dDelta / pStats->cntValues;
+    pStats->dM2 += dDelta * (dVal - pStats->dMean);
+    if(dVal < pStats->dMin)
+    {
+        pStats->dMin = dVal;
+    }
+    if(dVal > pStats->dMax)
+    {
+        pStats->dMax = dVal;
+    }
+    return 1;
+}
+
+/***	DMMSTATS_DGetMean
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**
+**	Return Value:
+**		double      - the mean of the included values, NAN if no value was included
+**
+**	Description:
+**		This function returns the arithmetic mean of the included values.
+**
+*/
+double DMMSTATS_DGetMean(DMMSTATS *pStats)
+{
+    return pStats->cntValues ? pStats->dMean: NAN;
+}
+
+/***	DMMSTATS_DGetVariance
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**
+**	Return Value:
+**		double      - the sample variance of the included values, NAN if no value was included
+**
+**	Description:
+**		This function returns the sample (unbiased, n - 1 denominator) variance of the included values.
+**      It returns 0 for a single value.
+**
+*/
+double DMMSTATS_DGetVariance(DMMSTATS *pStats)
+{
+    if(pStats->cntValues == 0)
+    {
+        return NAN;
+    }
+    return (pStats->cntValues > 1) ? pStats->dM2 / (pStats->cntValues - 1): 0.0;
+}
+
+/***	DMMSTATS_DGetStdDev
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**
+**	Return Value:
+**		double      - the sample standard deviation of the included values, NAN if no value was included
+**
+**	Description:
+**		This function returns the square root of the sample variance, see DMMSTATS_DGetVariance.
+**
+*/
+double DMMSTATS_DGetStdDev(DMMSTATS *pStats)
+{
+    return sqrt(DMMSTATS_DGetVariance(pStats));
+}
+
+/***	DMMSTATS_DGetRMS
+**
+**	Parameters:
+**      DMMSTATS *pStats        - the statistics
+**
+**	Return Value:
+**		double      - the RMS (quadratic mean) of the included values, NAN if no value was included
+**
+**	Description:
+**		This function returns the quadratic mean of the included values, computed as sqrt(mean^2 + population variance).
+**      This is the average value of the AC scales, whose values are RMS values.
+**
+*/
+double DMMSTATS_DGetRMS(DMMSTATS *pStats)
+{
+    if(pStats->cntValues == 0)
+    {
+        return NAN;
+    }
+    return sqrt(pStats->dMean * pStats->dMean + pStats->dM2 / pStats->cntValues);
+}
+
+/***	DMMSTATS_WndInit
+**
+**	Parameters:
+**      DMMSTATS_WND *pWnd      - the window
+**      double *pdValues        - the values storage, at least cntSize elements
+**      int cntSize             - the window size, the number of values averaged
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function initializes an empty moving average window over the provided storage.
+**
+*/
+void DMMSTATS_WndInit(DMMSTATS_WND *pWnd, double *pdValues, int cntSize)
+{
+    pWnd->pdValues = pdValues;
+    pWnd->cntSize = cntSize;
+    pWnd->fSquare = 0;
+    DMMSTATS_WndReset(pWnd);
+}
+
+/***	DMMSTATS_WndReset
+**
+**	Parameters:
+**      DMMSTATS_WND *pWnd      - the window
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function drops the values held by the window, for example when the measured signal left the convertor range.
+**
+*/
+void DMMSTATS_WndReset(DMMSTATS_WND *pWnd)
+{
+    pWnd->cntValues = 0;
+    pWnd->idxNext = 0;
+    pWnd->idxScale = -1;
+    pWnd->dSum = 0.0;
+}
+
+/***	DMMSTATS_DWndAdd
+**
+**	Parameters:
+**      DMMSTATS_WND *pWnd      - the window
+**      double dVal             - the new value
+**      int idxScale            - the scale the value was acquired on
+**      uint8_t fSquare         - 1 to average the squares of the values (RMS average, used for AC scales), 0 for arithmetic mean
+**
+**	Return Value:
+**		double      - the average of the last cntSize values (of the values held, until the window is full), 
+**                    or the value itself if it is an overload (+/- INFINITY) or NAN
+**
+**	Description:
+**		This function adds a value to the window, replacing the oldest one when the window is full, and returns the new average in constant time.
+**      The window is restarted when the scale or the averaging method changes, as the held values are no longer comparable.
+**      An overload (+/- INFINITY) or NAN value cannot be averaged: it empties the window and is returned as is.
+**
+*/
+double DMMSTATS_DWndAdd(DMMSTATS_WND *pWnd, double dVal, int idxScale, uint8_t fSquare)
+{
+    int i;
+    if(DMM_IsNotANumber(dVal) || dVal == INFINITY || dVal == -INFINITY)
+    {
+        DMMSTATS_WndReset(pWnd);
+        return dVal;
+    }
+    if(idxScale != pWnd->idxScale || fSquare != pWnd->fSquare)
+    {
+        DMMSTATS_WndReset(pWnd);
+        pWnd->idxScale = idxScale;
+        pWnd->fSquare = fSquare;
+    }
+    if(fSquare)
+    {
+        dVal *= dVal;
+    }
+    if(pWnd->cntValues < pWnd->cntSize)
+    {
+        pWnd->cntValues++;
+    }
+    else
+    {
+        pWnd->dSum -= pWnd->pdValues[pWnd->idxNext];    // the oldest value leaves the window
+    }
+    pWnd->pdValues[pWnd->idxNext] = dVal;
+    pWnd->dSum += dVal;
+    if(++pWnd->idxNext >= pWnd->cntSize)
+    {
+        // recompute the running sum once per window, dropping the accumulated rounding errors
+        pWnd->idxNext = 0;
+        pWnd->dSum = 0.0;
+        for(i = 0; i < pWnd->cntValues; i++)
+        {
+            pWnd->dSum += pWnd->pdValues[i];
+        }
+    }
+    return fSquare ? sqrt(pWnd->dSum / pWnd->cntValues): pWnd->dSum / pWnd->cntValues;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,83 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    dmmstats.h
+
+  @Description
+        This file contains the declaration for the functions of the DMMSTATS module (streaming statistics and moving average of the DMM values).
+        The DMMSTATS functions are defined in dmmstats.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, streaming statistics
+
+ */
+/* ************************************************************************** */
+
+#ifndef _DMMSTATS_H    /* Guard against multiple inclusion */
+#define _DMMSTATS_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// invalid values (+/- INFINITY overload, NAN) policies, see DMMSTATS_Init
+#define DMMSTATS_POLICY_STOP    0       // the first invalid value stops the accumulation
+#define DMMSTATS_POLICY_SKIP    1       // the invalid values are counted and excluded from the statistics
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// streaming statistics, updated by DMMSTATS_Add
+typedef struct _DMMSTATS{
+    uint32_t cntValues;         // values included in the statistics
+    uint32_t cntOverloads;      // excluded +/- INFINITY values
+    uint32_t cntInvalid;        // excluded NAN values
+    uint8_t bPolicy;            // DMMSTATS_POLICY_...
+    uint8_t fStopped;           // the accumulation was stopped by an invalid value (DMMSTATS_POLICY_STOP)
+    double dExcluded;           // the last excluded value
+    double dMean;               // running mean
+    double dM2;                 // running sum of the squared differences from the mean
+    double dMin;                // minimum value
+    double dMax;                // maximum value
+} DMMSTATS;
+
+// moving average window over the last values, updated by DMMSTATS_DWndAdd
+typedef struct _DMMSTATS_WND{
+    double *pdValues;           // the storage, provided by the caller
+    int cntSize;                // the window size (number of values averaged)
+    int cntValues;              // the number of values held, up to cntSize
+    int idxNext;                // the storage position of the next value
+    uint8_t fSquare;            // the squares of the values are averaged (RMS average, AC scales)
+    int idxScale;               // the scale of the held values, -1 when empty
+    double dSum;                // running sum of the held values (or squares)
+} DMMSTATS_WND;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void DMMSTATS_Init(DMMSTATS *pStats, uint8_t bPolicy);
+uint8_t DMMSTATS_Add(DMMSTATS *pStats, double dVal);
+double DMMSTATS_DGetMean(DMMSTATS *pStats);
+double DMMSTATS_DGetVariance(DMMSTATS *pStats);
+double DMMSTATS_DGetStdDev(DMMSTATS *pStats);
+double DMMSTATS_DGetRMS(DMMSTATS *pStats);
+void DMMSTATS_WndInit(DMMSTATS_WND *pWnd, double *pdValues, int cntSize);
+void DMMSTATS_WndReset(DMMSTATS_WND *pWnd);
+double DMMSTATS_DWndAdd(DMMSTATS_WND *pWnd, double dVal, int idxScale, uint8_t fSquare);
+
+#endif /* _DMMSTATS_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -38,12 +38,11 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
 #include "gpio.h"
 #include "spi.h"
 #include "eprom.h"
 #include "errors.h"
+#include "utils.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -170,6 +169,7 @@ uint8_t EPROM_WriteWords(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 */
 void EPROM_WriteEnable()
 {
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // some delay
@@ -179,6 +179,7 @@ void EPROM_WriteEnable()
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_EWEN, 0xC0);
 
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
 
 	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
     
@@ -203,12 +204,14 @@ void EPROM_WriteEnable()
 */
 void EPROM_WriteDisable()
 {
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // Send instruction code
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_EWDS, 0x00);
     
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
     
 	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
     
@@ -232,12 +235,14 @@ void EPROM_WriteDisable()
 */
 void EPROM_Erase(uint8_t bAddress)
 {
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // Send instruction code
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_ERASE, bAddress);
 
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
 	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
     
     // some delay
@@ -294,6 +299,7 @@ uint8_t EPROM_WaitUntilReady_Raw()
     // wait for data ready timeout counter 
     unsigned int cntTimeout = 0;
     DelayAprox10Us(SPI_CLK_DELAY);    
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
     DelayAprox10Us(SPI_CLK_DELAY);
     // check the wait for data ready timeout counter against threshold
@@ -307,6 +313,7 @@ uint8_t EPROM_WaitUntilReady_Raw()
     DelayAprox10Us(SPI_CLK_DELAY);
     
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
     return bResult;
 }
 
@@ -328,6 +335,7 @@ uint8_t EPROM_WaitUntilReady_Raw()
 uint16_t EPROM_Read_Raw(uint8_t bAddress)
 {
     uint16_t wVal;
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_READ, bAddress);
@@ -337,6 +345,7 @@ uint16_t EPROM_Read_Raw(uint8_t bAddress)
 
 	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
     return wVal;
 }
 
@@ -362,6 +371,7 @@ uint16_t EPROM_Read_Raw(uint8_t bAddress)
 uint8_t EPROM_Write_Raw(uint8_t bAddress, uint16_t wVal)
 {
     uint8_t bResult;
+    SPI_LockBus();
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
  
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_WRITE, bAddress);
@@ -372,6 +382,7 @@ uint8_t EPROM_Write_Raw(uint8_t bAddress, uint16_t wVal)
     
     DelayAprox10Us(SPI_CLK_DELAY);  
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+    SPI_UnlockBus();
 
     bResult = EPROM_WaitUntilReady_Raw();
     return bResult;
@@ -0,0 +1,528 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    epromsim.c
+
+  @Description
+        This file groups the functions that implement the EPROMSIM module.
+        The module is only built for host (Linux) builds, when DMM_HOST is defined.
+        It is a model of the 93C66 Microwire EPROM (256 x 16 bits), attached to the SPIMOCK bus on the CS_EPROM slave select.
+        An instruction is a start bit (leading 0 bits are ignored), 2 bits opcode and 8 bits address, 
+        followed by 16 data bits for WRITE / WRAL. For READ, a dummy 0 bit is output after the last address bit, 
+        then the addressed word (MSB first), continuing with the next addresses while the clock is running.
+        The WRITE, WRAL, ERASE and ERAL instructions require a previous EWEN and start a self timed cycle 
+        when CS is deactivated. During this cycle the data output shows the ready status (0 busy, 1 ready) 
+        when CS is active, and the instructions are ignored.
+        The memory content can be backed by a file, which is loaded by EPROMSIM_SetCfg and rewritten after each 
+        write / erase cycle, so that it persists between runs.
+        The module counts the bus cycles and the operations, see EPROMSIM_STATS.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, Microwire EPROM simulator
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifdef DMM_HOST
+#include <stdio.h>
+#include <string.h>
+#include "stdint.h"
+#include "eprom.h"
+#include "spimock.h"
+#include "epromsim.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// instruction decoding states
+#define EPROMSIM_ST_IDLE        0   // waiting for the start bit
+#define EPROMSIM_ST_INSTR       1   // receiving opcode and address
+#define EPROMSIM_ST_DATA        2   // receiving data (WRITE / WRAL)
+#define EPROMSIM_ST_READ        3   // sending data
+#define EPROMSIM_ST_DONE        4   // instruction complete, waiting for CS deactivation
+
+// cycles started at CS deactivation
+#define EPROMSIM_CYCLE_NONE     0
+#define EPROMSIM_CYCLE_WRITE    1
+#define EPROMSIM_CYCLE_WRAL     2
+#define EPROMSIM_CYCLE_ERASE    3
+#define EPROMSIM_CYCLE_ERAL     4
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void EPROMSIM_Select(uint8_t fSelected);
+void EPROMSIM_Clock(uint8_t bMosi);
+uint8_t EPROMSIM_GetMiso();
+void EPROMSIM_DecodeInstr();
+uint8_t EPROMSIM_FBusy();
+void EPROMSIM_StartCycle();
+void EPROMSIM_SaveFile();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+const SPIMOCK_SLAVE epromSimSlave = {EPROMSIM_Select, EPROMSIM_Clock, EPROMSIM_GetMiso, NULL};
+
+uint16_t rgwEpromSimMem[EPROMSIM_CNTWORDS];
+EPROMSIM_CFG epromSimCfg;
+EPROMSIM_STATS epromSimStats;
+uint8_t fEpromSimWriteEnabled = 0;
+uint64_t tnsEpromSimReady = 0;      // end of the current write / erase cycle
+
+// instruction state
+uint8_t bEpromSimState = EPROMSIM_ST_IDLE;
+int cntEpromSimBits = 0;
+uint16_t wEpromSimInstr = 0;        // opcode and address
+uint16_t wEpromSimShift = 0;        // data received / sent
+uint8_t bEpromSimAddr = 0;
+uint8_t bEpromSimCycle = EPROMSIM_CYCLE_NONE;
+uint8_t bEpromSimMiso = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	EPROMSIM_Init
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function initializes the EPROMSIM module with the default configuration (erased volatile memory), 
+**      and attaches the model to the SPIMOCK bus, as EPROM slave.
+**          
+*/
+void EPROMSIM_Init()
+{
+    EPROMSIM_CFG cfg;
+    EPROMSIM_GetDefaultCfg(&cfg);
+    EPROMSIM_SetCfg(&cfg);
+    EPROMSIM_ResetStats();
+    SPIMOCK_AttachSlave(SPIMOCK_SLAVE_EPROM, &epromSimSlave);
+}
+
+/***	EPROMSIM_GetDefaultCfg
+**
+**	Parameters:
+**		EPROMSIM_CFG *pCfg  - the structure receiving the default configuration
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function provides the default configuration: 5 ms write cycle (the 93C66 maximum), no backing file.
+**          
+*/
+void EPROMSIM_GetDefaultCfg(EPROMSIM_CFG *pCfg)
+{
+    pCfg->tusWriteCycle = 5000;
+    pCfg->szFile = NULL;
+}
+
+/***	EPROMSIM_SetCfg
+**
+**	Parameters:
+**		const EPROMSIM_CFG *pCfg    - the configuration
+**
+**	Return Value:
+**		uint8_t
+**          1   - the memory content was loaded from the backing file
+**          0   - no backing file, or the file could not be read: the memory is erased
+**
+**	Description:
+**		This function sets the configuration and loads the memory content. 
+**      When the backing file does not exist it will be created by the first write / erase cycle.
+**          
+*/
+uint8_t EPROMSIM_SetCfg(const EPROMSIM_CFG *pCfg)
+{
+    FILE *pFile;
+    uint8_t rgbFile[2 * EPROMSIM_CNTWORDS];
+    uint8_t fLoaded = 0;
+    int i;
+    epromSimCfg = *pCfg;
+    for(i = 0; i < EPROMSIM_CNTWORDS; i++)
+    {
+        rgwEpromSimMem[i] = EPROMSIM_ERASEDVAL;
+    }
+    if(pCfg->szFile && (pFile = fopen(pCfg->szFile, "rb")))
+    {
+        if(fread(rgbFile, 1, sizeof(rgbFile), pFile) == sizeof(rgbFile))
+        {
+            for(i = 0; i < EPROMSIM_CNTWORDS; i++)
+            {
+                rgwEpromSimMem[i] = rgbFile[2*i] | (rgbFile[2*i + 1] << 8);
+            }
+            fLoaded = 1;
+        }
+        fclose(pFile);
+    }
+    return fLoaded;
+}
+
+/***	EPROMSIM_GetWord
+**
+**	Parameters:
+**		uint8_t bAddress    - the word address
+**
+**	Return Value:
+**		uint16_t            - the memory word
+**
+**	Description:
+**		This function returns a memory word, without bus activity.
+**          
+*/
+uint16_t EPROMSIM_GetWord(uint8_t bAddress)
+{
+    return rgwEpromSimMem[bAddress];
+}
+
+/***	EPROMSIM_SetWord
+**
+**	Parameters:
+**		uint8_t bAddress    - the word address
+**      uint16_t wVal       - the value
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function sets a memory word, without bus activity and without updating the backing file. 
+**      It is used to prepare the memory content (for example factory calibration, serial number).
+**          
+*/
+void EPROMSIM_SetWord(uint8_t bAddress, uint16_t wVal)
+{
+    rgwEpromSimMem[bAddress] = wVal;
+}
+
+/***	EPROMSIM_GetStats
+**
+**	Parameters:
+**		EPROMSIM_STATS *pStats  - the structure receiving the activity counters
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function copies the activity counters.
+**          
+*/
+void EPROMSIM_GetStats(EPROMSIM_STATS *pStats)
+{
+    *pStats = epromSimStats;
+}
+
+/***	EPROMSIM_ResetStats
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function clears the activity counters.
+**          
+*/
+void EPROMSIM_ResetStats()
+{
+    memset(&epromSimStats, 0, sizeof(epromSimStats));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	EPROMSIM_Select
+**
+**	Parameters:
+**		uint8_t fSelected   - 1 when CS_EPROM is activated, 0 when it is deactivated
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		The activation restarts the instruction decoding. 
+**      The deactivation starts the write / erase cycle of a completely received instruction.
+**          
+*/
+void EPROMSIM_Select(uint8_t fSelected)
+{
+    if(fSelected)
+    {
+        epromSimStats.cntSelects++;
+    }
+    else if(bEpromSimCycle != EPROMSIM_CYCLE_NONE)
+    {
+        EPROMSIM_StartCycle();
+    }
+    bEpromSimState = EPROMSIM_ST_IDLE;
+    bEpromSimCycle = EPROMSIM_CYCLE_NONE;
+    cntEpromSimBits = 0;
+    wEpromSimInstr = 0;
+    bEpromSimMiso = 0;
+}
+
+/***	EPROMSIM_Clock
+**
+**	Parameters:
+**		uint8_t bMosi   - the DI level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function implements the Microwire instruction decoding, for each clock rising edge.
+**          
+*/
+void EPROMSIM_Clock(uint8_t bMosi)
+{
+    epromSimStats.cntClocks++;
+    switch(bEpromSimState)
+    {
+        case EPROMSIM_ST_IDLE:
+            if(bMosi && !EPROMSIM_FBusy())
+            {
+                bEpromSimState = EPROMSIM_ST_INSTR;
+                cntEpromSimBits = 0;
+                wEpromSimInstr = 0;
+            }
+            break;
+        case EPROMSIM_ST_INSTR:
+            wEpromSimInstr = (wEpromSimInstr << 1) | bMosi;
+            if(++cntEpromSimBits == 10)
+            {
+                EPROMSIM_DecodeInstr();
+            }
+            break;
+        case EPROMSIM_ST_DATA:
+            wEpromSimShift = (wEpromSimShift << 1) | bMosi;
+            if(++cntEpromSimBits == 16)
+            {
+                bEpromSimState = EPROMSIM_ST_DONE;
+            }
+            break;
+        case EPROMSIM_ST_READ:
+            if(cntEpromSimBits == 16)
+            {
+                // sequential read
+                bEpromSimAddr++;
+                wEpromSimShift = rgwEpromSimMem[bEpromSimAddr];
+                epromSimStats.cntReads++;
+                cntEpromSimBits = 0;
+            }
+            bEpromSimMiso = (wEpromSimShift >> (15 - cntEpromSimBits)) & 1;
+            cntEpromSimBits++;
+            break;
+    }
+}
+
+/***	EPROMSIM_GetMiso
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - the DO level
+**
+**	Description:
+**		While reading, the function returns the data bit. Otherwise it returns the ready status: 0 during a write / erase cycle, 1 after.
+**          
+*/
+uint8_t EPROMSIM_GetMiso()
+{
+    if(bEpromSimState == EPROMSIM_ST_READ)
+    {
+        return bEpromSimMiso;
+    }
+    if(EPROMSIM_FBusy())
+    {
+        epromSimStats.cntBusyPolls++;
+        return 0;
+    }
+    return 1;
+}
+
+/***	EPROMSIM_DecodeInstr
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function decodes the opcode and address, after the last address bit.
+**          
+*/
+void EPROMSIM_DecodeInstr()
+{
+    uint8_t bOp = (wEpromSimInstr >> 8) & 3;
+    bEpromSimAddr = wEpromSimInstr & 0xFF;
+    bEpromSimState = EPROMSIM_ST_DONE;
+    cntEpromSimBits = 0;
+    switch(bOp)
+    {
+        case EPROM_OPCODE_READ:
+            bEpromSimState = EPROMSIM_ST_READ;
+            wEpromSimShift = rgwEpromSimMem[bEpromSimAddr];
+            epromSimStats.cntReads++;
+            bEpromSimMiso = 0;  // dummy bit
+            break;
+        case EPROM_OPCODE_WRITE:
+            bEpromSimState = EPROMSIM_ST_DATA;
+            bEpromSimCycle = EPROMSIM_CYCLE_WRITE;
+            break;
+        case EPROM_OPCODE_ERASE:
+            bEpromSimCycle = EPROMSIM_CYCLE_ERASE;
+            break;
+        default:
+            // the 2 address MSBs select the instruction
+            switch(bEpromSimAddr >> 6)
+            {
+                case 3: // EWEN
+                    fEpromSimWriteEnabled = 1;
+                    epromSimStats.cntWriteEnables++;
+                    break;
+                case 0: // EWDS
+                    fEpromSimWriteEnabled = 0;
+                    epromSimStats.cntWriteDisables++;
+                    break;
+                case 2: // ERAL
+                    bEpromSimCycle = EPROMSIM_CYCLE_ERAL;
+                    break;
+                case 1: // WRAL
+                    bEpromSimState = EPROMSIM_ST_DATA;
+                    bEpromSimCycle = EPROMSIM_CYCLE_WRAL;
+                    break;
+            }
+            break;
+    }
+}
+
+/***	EPROMSIM_FBusy
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 during a write / erase cycle, 0 otherwise
+**
+**	Description:
+**		This function checks the end of the write / erase cycle, against the simulated time.
+**          
+*/
+uint8_t EPROMSIM_FBusy()
+{
+    return SPIMOCK_GetTimeNs() < tnsEpromSimReady;
+}
+
+/***	EPROMSIM_StartCycle
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function performs the received write / erase instruction, if writing is enabled and all the data bits were received, 
+**      marks the device busy for the configured write cycle and updates the backing file.
+**          
+*/
+void EPROMSIM_StartCycle()
+{
+    int i;
+    if(!fEpromSimWriteEnabled || bEpromSimState != EPROMSIM_ST_DONE)
+    {
+        epromSimStats.cntRejected++;
+        return;
+    }
+    switch(bEpromSimCycle)
+    {
+        case EPROMSIM_CYCLE_WRITE:
+            rgwEpromSimMem[bEpromSimAddr] = wEpromSimShift;
+            epromSimStats.cntWrites++;
+            break;
+        case EPROMSIM_CYCLE_WRAL:
+            for(i = 0; i < EPROMSIM_CNTWORDS; i++)
+            {
+                rgwEpromSimMem[i] = wEpromSimShift;
+            }
+            epromSimStats.cntWrites++;
+            break;
+        case EPROMSIM_CYCLE_ERASE:
+            rgwEpromSimMem[bEpromSimAddr] = EPROMSIM_ERASEDVAL;
+            epromSimStats.cntErases++;
+            break;
+        case EPROMSIM_CYCLE_ERAL:
+            for(i = 0; i < EPROMSIM_CNTWORDS; i++)
+            {
+                rgwEpromSimMem[i] = EPROMSIM_ERASEDVAL;
+            }
+            epromSimStats.cntErases++;
+            break;
+    }
+    tnsEpromSimReady = SPIMOCK_GetTimeNs() + (uint64_t)epromSimCfg.tusWriteCycle * 1000;
+    epromSimStats.tnsBusy += (uint64_t)epromSimCfg.tusWriteCycle * 1000;
+    EPROMSIM_SaveFile();
+}
+
+/***	EPROMSIM_SaveFile
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function writes the memory content to the backing file, if configured.
+**          
+*/
+void EPROMSIM_SaveFile()
+{
+    FILE *pFile;
+    uint8_t rgbFile[2 * EPROMSIM_CNTWORDS];
+    int i;
+    if(!epromSimCfg.szFile || !(pFile = fopen(epromSimCfg.szFile, "wb")))
+    {
+        return;
+    }
+    for(i = 0; i < EPROMSIM_CNTWORDS; i++)
+    {
+        rgbFile[2*i] = rgwEpromSimMem[i] & 0xFF;
+        rgbFile[2*i + 1] = rgwEpromSimMem[i] >> 8;
+    }
+    fwrite(rgbFile, 1, sizeof(rgbFile), pFile);
+    fclose(pFile);
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
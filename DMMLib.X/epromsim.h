@@ -0,0 +1,76 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    epromsim.h
+
+  @Description
+        This file contains the declaration for the functions of EPROMSIM module.
+        The EPROMSIM module is only built for host (Linux) builds, when DMM_HOST is defined.
+        The EPROMSIM functions are defined in epromsim.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, Microwire EPROM simulator
+
+ */
+/* ************************************************************************** */
+
+#ifndef _EPROMSIM_H    /* Guard against multiple inclusion */
+#define _EPROMSIM_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define EPROMSIM_CNTWORDS       256     // 93C66, 16 bits organization, 8 address bits
+#define EPROMSIM_ERASEDVAL      0xFFFF
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef struct _EPROMSIM_CFG{
+    uint32_t tusWriteCycle;     // self timed write / erase cycle duration, us
+    const char *szFile;         // backing file (EPROMSIM_CNTWORDS words, little endian), NULL for a volatile erased memory
+} EPROMSIM_CFG;
+
+// activity counters
+typedef struct _EPROMSIM_STATS{
+    uint32_t cntSelects;        // CS activations
+    uint32_t cntClocks;         // clock edges while selected
+    uint32_t cntReads;          // words read (including sequential reads)
+    uint32_t cntWrites;         // WRITE and WRAL cycles
+    uint32_t cntErases;         // ERASE and ERAL cycles
+    uint32_t cntWriteEnables;   // EWEN instructions
+    uint32_t cntWriteDisables;  // EWDS instructions
+    uint32_t cntRejected;       // write / erase instructions ignored (write disabled or device busy)
+    uint32_t cntBusyPolls;      // status reads returning busy
+    uint64_t tnsBusy;           // total write / erase cycles duration, simulated ns
+} EPROMSIM_STATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void EPROMSIM_Init();
+void EPROMSIM_GetDefaultCfg(EPROMSIM_CFG *pCfg);
+uint8_t EPROMSIM_SetCfg(const EPROMSIM_CFG *pCfg);
+uint16_t EPROMSIM_GetWord(uint8_t bAddress);
+void EPROMSIM_SetWord(uint8_t bAddress, uint16_t wVal);
+void EPROMSIM_GetStats(EPROMSIM_STATS *pStats);
+void EPROMSIM_ResetStats();
+
+#endif /* _EPROMSIM_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -26,9 +26,9 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 #include "stdint.h"
 #include "errors.h"
 
@@ -161,6 +161,46 @@ uint8_t ERRORS_GetPrefixedMessageString(uint8_t bErrCode, char *szContent, char
             strcpy(szLastError, "A measurement must be performed before calling the finalize calibration.");  
             prefix = PREFIX_ERROR;
             break;       
+        case ERRVAL_SPI_BUSY:
+            strcpy(szLastError, "SPI burst transfer already in progress.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_SPI_BURSTSIZE:
+            strcpy(szLastError, "SPI burst transfer size exceeds the supported size.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_SMPRING_SIZE:
+            strcpy(szLastError, "Samples ring size is not a power of 2.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_AUTORANGE_MODE:
+            strcpy(szLastError, "No scale is defined for the autorange mode.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_DMMFILT_STAGE:
+            strcpy(szLastError, "Wrong filter stage or parameter, or too many stages.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_MAINS_PARAM:
+            strcpy(szLastError, "Wrong mains frequency or number of cycles.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_UART_BAUD:
+            strcpy(szLastError, "Baud rate out of range or not achievable.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_DMMBIN_FLOW:
+            strcpy(szLastError, "Binary stream cannot be used with XON/XOFF flow control.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_DMMBIN_FRAME:
+            strcpy(szLastError, "Wrong binary frame.");  
+            prefix = PREFIX_ERROR;
+            break;       
+        case ERRVAL_DMMACQ_UNAVAILABLE:
+            strcpy(szLastError, "Interrupt driven acquisition not available in this build.");  
+            prefix = PREFIX_ERROR;
+            break;       
         case ERRVAL_DMM_GENERICERROR:
 //          the message is in pSzErr string
             strcpy(szLastError, pSzErr);
@@ -170,7 +210,10 @@ uint8_t ERRORS_GetPrefixedMessageString(uint8_t bErrCode, char *szContent, char
             bResult = ERRVAL_CMD_MISSINGCODE;
             break;        
     }
-    ERRORS_PrefixMessage(prefix, pSzErr, szLastError);
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        ERRORS_PrefixMessage(prefix, pSzErr, szLastError);
+    }
 
     return bResult;
     
@@ -60,6 +60,16 @@ typedef enum {
 #define ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
 #define ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration.
 #define ERRVAL_DMM_GENERICERROR         0xEF    // Generic error
+#define ERRVAL_SPI_BUSY                 0xEE    // A SPI burst transfer is already in progress
+#define ERRVAL_SPI_BURSTSIZE            0xED    // The SPI burst transfer size exceeds the supported size
+#define ERRVAL_SMPRING_SIZE             0xEC    // The samples ring size is not a power of 2
+#define ERRVAL_AUTORANGE_MODE           0xEB    // No scale is defined for the autorange mode
+#define ERRVAL_DMMFILT_STAGE            0xEA    // Wrong filter stage type or parameter, or too many stages
+#define ERRVAL_MAINS_PARAM              0xE9    // Wrong mains frequency or number of cycles
+#define ERRVAL_UART_BAUD                0xE8    // Baud rate out of range or not achievable within UART_BAUD_MAXERR
+#define ERRVAL_DMMBIN_FLOW              0xE7    // The binary stream cannot be used with the XON/XOFF flow control
+#define ERRVAL_DMMBIN_FRAME             0xE6    // Wrong binary frame: COBS encoding, CRC or packet length
+#define ERRVAL_DMMACQ_UNAVAILABLE       0xE5    // The interrupt driven acquisition requires the hardware SPI transport and DMM_INTF_READCLEAR
 
 // *****************************************************************************
 // *****************************************************************************
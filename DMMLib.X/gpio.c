@@ -26,10 +26,9 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
 #include "stdint.h"
 #include "gpio.h"
+#include "hal.h"
 /* ************************************************************************** */
 
 /***	GPIO_Init
@@ -41,7 +40,7 @@
 **		
 **
 **	Description:
-**		This function initializes the digital pins used by DMMShield: 
+**		This function initializes, through the HAL, the digital pins used by DMMShield: 
 **      The following digital pins are configured as digital outputs: SPI_CLK, SPI_MOSI, CS_EPROM, CS_DMM.
 **      The following digital pins are configured as digital inputs: SPI_MISO.
 **      The CS_EPROM and CS_DMM pins are deactivated.
@@ -55,34 +54,14 @@ void GPIO_Init()
     static uint8_t fInitialized = 0;
     if(!fInitialized)
     {
-        // Configure SPI signals as digital outputs.
-        tris_SPI_CLK = 0;
-        tris_SPI_MOSI = 0;
-        // Configure SPI signals as digital inputs.
-        tris_SPI_MISO = 1;
-        //configure CTRL signals as outputs
-        tris_CTRL_RLU = 0;
-        tris_CTRL_RLD = 0;
-        tris_CTRL_RLI = 0;    
-        
-        // Configure DMM Slave Select as digital output.
-        tris_SPI_SS = 0;
+        // Configure the pins direction
+        HAL_InitPins();
+
         // // Deactivate CS_DMM
         GPIO_SetValue_CS_DMM(1); 
         
-        // Configure EPROM Slave Select as digital output.
-        tris_ESPI_SS = 0;
-        
         // Deactivate EPROM SS
         GPIO_SetValue_CS_EPROM(0); 
-
-        // configure relays as digital output
-        tris_CTRL_RLU = 0;
-        tris_CTRL_RLD = 0;
-        tris_CTRL_RLI = 0;
-        
-        
-
         
         fInitialized = 1;
     }
@@ -22,6 +22,9 @@
 #ifndef CONFIG_H
 #define	CONFIG_H
 
+#include "spi.h"
+#include "hal.h"
+
 #define PB_FRQ  10000000
 
 #define macro_enable_interrupts() \
@@ -69,6 +72,14 @@ extern "C" {
 #define tris_SPI_CLK   TRISGbits.TRISG6
 //#define  lat_SPI_CLK   LATGbits.LATG6
 
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+// the SPI2 peripheral uses SDO2 (RG8) for DI and SDI2 (RG7) for DO
+// corresponds to schematic signal DI
+#define tris_SPI_MOSI   TRISGbits.TRISG8
+
+// corresponds to schematic signal DO
+#define tris_SPI_MISO   TRISGbits.TRISG7
+#else
 // corresponds to schematic signal DI
 #define tris_SPI_MOSI   TRISGbits.TRISG7
 //#define  lat_SPI_MOSI   LATGbits.LATG7
@@ -76,6 +87,7 @@ extern "C" {
 // corresponds to schematic signal DO
 #define tris_SPI_MISO   TRISGbits.TRISG8
 //#define  prt_SPI_MISO   PORTGbits.RG8
+#endif
 
 
 // UART
@@ -83,29 +95,33 @@ extern "C" {
 #define tris_UART_RX   TRISFbits.TRISF2
 
 
+// the pins are accessed through the HAL (see hal.h), 
+// the PIC32 implementation uses LATD3, LATD4, LATG6, LATG7 (LATG8 for SPI hardware transport), LATF1, LATD0, LATD8 and RG8 (RG7 for SPI hardware transport)
 #define GPIO_SetValue_CS_EPROM(val) \
-		LATDbits.LATD3 = val
+		HAL_SetPin(HAL_PIN_CS_EPROM, val)
 
 #define GPIO_SetValue_CS_DMM(val) \
-		LATDbits.LATD4 = val
+		HAL_SetPin(HAL_PIN_CS_DMM, val)
 
 #define GPIO_SetValue_CLK(val) \
-		LATGbits.LATG6 = val
+		HAL_SetPin(HAL_PIN_CLK, val)
 
 #define GPIO_SetValue_MOSI(val) \
-		LATGbits.LATG7 = val
+		HAL_SetPin(HAL_PIN_MOSI, val)
 
 #define GPIO_SetValue_RLD(val) \
-		LATFbits.LATF1 = val
+		HAL_SetPin(HAL_PIN_RLD, val)
 
 #define GPIO_SetValue_RLU(val) \
-		LATDbits.LATD0 = val
+		HAL_SetPin(HAL_PIN_RLU, val)
 
 #define GPIO_SetValue_RLI(val) \
-		LATDbits.LATD8 = val
+		HAL_SetPin(HAL_PIN_RLI, val)
 
 #define GPIO_Get_MISO() \
-        PORTGbits.RG8
+        HAL_GetPin(HAL_PIN_MISO)
+
+void GPIO_Init();
 
 
 /*
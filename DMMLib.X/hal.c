@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    hal.c
+
+  @Description
+        This file groups the functions that implement the HAL module.
+        It holds the pointer to the operations table used by the library. 
+        By default the table corresponding to the build (PIC32 or host) is used.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, bus abstraction layer
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include "hal.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+#ifdef DMM_HOST
+const HAL_OPS *pHalOps = &halHostOps;
+#else
+const HAL_OPS *pHalOps = &halPic32Ops;
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	HAL_SetOps
+**
+**	Parameters:
+**		const HAL_OPS *pOps - the operations table to be used by the library
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function replaces the operations table used for all hardware accesses. 
+**      It allows running the library over a different bus implementation, for example an instrumented one.
+**      A NULL parameter is ignored.
+**      The function should be called before any initialization function.
+**          
+*/
+void HAL_SetOps(const HAL_OPS *pOps)
+{
+    if(pOps)
+    {
+        pHalOps = pOps;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
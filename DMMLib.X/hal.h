@@ -0,0 +1,165 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    hal.h
+
+  @Description
+        This file contains the declaration for the HAL (hardware abstraction layer) module.
+        All the accesses of the library to the hardware (digital pins, delays, SPI peripheral, UART) 
+        go through the operations table pointed by pHalOps, using the HAL_... macros defined below.
+        Two implementations are provided: halPic32Ops (hal_pic32.c), for the PIC32 target, 
+        and halHostOps (hal_host.c), for host (Linux) builds, when DMM_HOST is defined.
+        The implementation is selected at build time, and it can be replaced at run time using HAL_SetOps.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, bus abstraction layer
+
+ */
+/* ************************************************************************** */
+
+#ifndef _HAL_H    /* Guard against multiple inclusion */
+#define _HAL_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// digital pins
+#define HAL_PIN_CS_DMM      0   // DMM slave select, output, active low
+#define HAL_PIN_CS_EPROM    1   // EPROM slave select, output, active high
+#define HAL_PIN_CLK         2   // SPI clock, output
+#define HAL_PIN_MOSI        3   // SPI data output, corresponds to schematic signal DI
+#define HAL_PIN_RLD         4   // relay control, output
+#define HAL_PIN_RLU         5   // relay control, output
+#define HAL_PIN_RLI         6   // relay control, output
+#define HAL_PIN_MISO        7   // SPI data input, corresponds to schematic signal DO
+#define HAL_PIN_DMMINT      8   // DMM converter interrupt output, input, active low
+#define HAL_CNTPINS         9
+
+// external interrupt used for the DMM converter interrupt output: 0 - 4 (INT0 / RD0, INTn / RD(7+n) for n = 1 - 4)
+#ifndef HAL_DMMINT
+#define HAL_DMMINT          2
+#endif
+// 1 to trigger the DMM interrupt on the rising edge, 0 for the falling edge
+#ifndef HAL_DMMINT_RISING
+#define HAL_DMMINT_RISING   0
+#endif
+
+#define HAL_TICKS_FRQ       40000000    // timestamp counter frequency (core timer, SYSCLK / 2)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef struct _HAL_OPS{
+    // digital pins
+    void (*pfnInitPins)();                          // configure the pins direction
+    void (*pfnSetPin)(int idxPin, uint8_t val);     // set an output pin
+    uint8_t (*pfnGetPin)(int idxPin);               // read a pin
+    
+    // delay
+    void (*pfnDelay10Us)(unsigned int t10usDelay);  // approximate delay, in tens of microseconds
+    
+    // SPI peripheral, used by the SPI hardware transport
+    void (*pfnSpiHwInit)(unsigned int clkFrq);
+    void (*pfnSpiHwEnable)(uint8_t fEnable);
+    uint8_t (*pfnSpiHwTransferByte)(uint8_t bVal);
+    uint8_t (*pfnSpiHwStartBurst)(uint8_t *pbRdData, int cbData, void (*pfnDone)());
+    uint8_t (*pfnSpiHwFBurstBusy)();
+    
+    // UART, received characters are passed to UART_ProcessRxChar, receive errors to UART_ProcessRxError
+    // after pfnUartTxStart, the characters to transmit are taken from UART_ProcessTxChar (TX interrupt) until it returns 0
+    void (*pfnUartInit)(unsigned int baud);
+    void (*pfnUartPutChar)(char ch);                // polled transmit, waits for room in the transmitter
+    void (*pfnUartTxStart)();
+    void (*pfnUartRxEnable)(uint8_t fEnable);       // hold / release the RX interrupt, the received characters wait in the UART
+    void (*pfnUartSetFlow)(uint8_t bFlow);          // UART_FLOW_..., the hardware flow control pins are used for UART_FLOW_RTSCTS
+    
+    // DMM interrupt, pfnIsr is called on the active edge of HAL_PIN_DMMINT while enabled
+    // an edge detected while disabled is kept pending and serviced when enabled
+    void (*pfnExtIntInit)(void (*pfnIsr)());
+    void (*pfnExtIntEnable)(uint8_t fEnable);
+    
+    // timestamp counter, HAL_TICKS_FRQ
+    uint32_t (*pfnGetTicks)();
+} HAL_OPS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+extern const HAL_OPS *pHalOps;
+#ifdef DMM_HOST
+extern const HAL_OPS halHostOps;
+#else
+extern const HAL_OPS halPic32Ops;
+#endif
+
+void HAL_SetOps(const HAL_OPS *pOps);
+
+#define HAL_InitPins() \
+        pHalOps->pfnInitPins()
+
+#define HAL_SetPin(idxPin, val) \
+        pHalOps->pfnSetPin(idxPin, val)
+
+#define HAL_GetPin(idxPin) \
+        pHalOps->pfnGetPin(idxPin)
+
+#define HAL_Delay10Us(t10usDelay) \
+        pHalOps->pfnDelay10Us(t10usDelay)
+
+#define HAL_SpiHwInit(clkFrq) \
+        pHalOps->pfnSpiHwInit(clkFrq)
+
+#define HAL_SpiHwEnable(fEnable) \
+        pHalOps->pfnSpiHwEnable(fEnable)
+
+#define HAL_SpiHwTransferByte(bVal) \
+        pHalOps->pfnSpiHwTransferByte(bVal)
+
+#define HAL_SpiHwStartBurst(pbRdData, cbData, pfnDone) \
+        pHalOps->pfnSpiHwStartBurst(pbRdData, cbData, pfnDone)
+
+#define HAL_SpiHwFBurstBusy() \
+        pHalOps->pfnSpiHwFBurstBusy()
+
+#define HAL_UartInit(baud) \
+        pHalOps->pfnUartInit(baud)
+
+#define HAL_UartPutChar(ch) \
+        pHalOps->pfnUartPutChar(ch)
+
+#define HAL_UartTxStart() \
+        pHalOps->pfnUartTxStart()
+
+#define HAL_UartRxEnable(fEnable) \
+        pHalOps->pfnUartRxEnable(fEnable)
+
+#define HAL_UartSetFlow(bFlow) \
+        pHalOps->pfnUartSetFlow(bFlow)
+
+#define HAL_ExtIntInit(pfnIsr) \
+        pHalOps->pfnExtIntInit(pfnIsr)
+
+#define HAL_ExtIntEnable(fEnable) \
+        pHalOps->pfnExtIntEnable(fEnable)
+
+#define HAL_GetTicks() \
+        pHalOps->pfnGetTicks()
+
+#endif /* _HAL_H */
+
+/* *****************************************************************************
+ End of File
+ */
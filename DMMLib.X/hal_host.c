@@ -0,0 +1,551 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    hal_host.c
+
+  @Description
+        This file groups the functions that implement the host (Linux) HAL operations table (halHostOps).
+        It is only built when DMM_HOST is defined.
+        The digital pins and the SPI peripheral are emulated by the SPIMOCK module, 
+        delays advance the SPIMOCK simulated time instead of waiting.
+        The UART is mapped over the standard input / output: transmitted characters are written to stdout 
+        and the stdin content is passed to UART_ProcessRxChar, being polled each 1 ms of simulated time.
+        The interrupt driven transmission is emulated from the simulated time advance: once started, a character 
+        is taken from UART_ProcessTxChar and written each character duration at the configured baud rate.
+        The standard input is read by chunks of HALHOST_RXCHUNK characters. While the RX interrupt is held, the characters 
+        of the chunk wait, and no chunk is read, like with RTS / CTS flow control. With XON / XOFF flow control, 
+        the other side is emulated: the transmitted XOFF stops reading chunks (the current one is still received) until XON.
+        Characters can also be injected using HALHOST_InjectRx. The standard input polling can be disabled using HALHOST_SetRxPoll, 
+        for example by the host benchmark, which does not read commands.
+        The DMM external interrupt is emulated from the HAL_PIN_DMMINT level driven by the DMM converter model: 
+        the handler is called on the active edge, from the simulated time advance (like an interrupt preempting the main code), 
+        an edge detected while disabled or while the handler runs is kept pending. The timestamp counter is derived from the simulated time.
+        When the standard input reaches its end, the program exits after 1 more second of simulated time, 
+        so that the already received commands are processed.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, bus abstraction layer
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifdef DMM_HOST
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "stdint.h"
+#include "spihw.h"
+#include "spimock.h"
+#include "uart.h"
+#include "hal.h"
+#include "hal_host.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define HALHOST_RXPOLL_NS       1000000ull      // stdin polling period, simulated time
+#define HALHOST_EXITDELAY_NS    1000000000ull   // delay before exit after the end of stdin
+#define HALHOST_RXCHUNK         32              // characters read from stdin at once, also sent by the other side after XOFF
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void HALHOST_InitPins();
+void HALHOST_Delay10Us(unsigned int t10usDelay);
+void HALHOST_UartInit(unsigned int baud);
+void HALHOST_UartPutChar(char ch);
+void HALHOST_UartTxStart();
+void HALHOST_UartRxEnable(uint8_t fEnable);
+void HALHOST_UartSetFlow(uint8_t bFlow);
+void HALHOST_ServiceUartTx();
+void HALHOST_PollRx();
+void HALHOST_ExtIntInit(void (*pfnIsr)());
+void HALHOST_ExtIntEnable(uint8_t fEnable);
+uint32_t HALHOST_GetTicks();
+void HALHOST_InputChanged(int idxPin, uint8_t val);
+void HALHOST_ServiceExtInt();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+const HAL_OPS halHostOps = {
+    HALHOST_InitPins,
+    SPIMOCK_SetPin,
+    SPIMOCK_GetPin,
+    HALHOST_Delay10Us,
+    SPIHW_Init,
+    SPIHW_Enable,
+    SPIHW_TransferByte,
+    SPIHW_StartBurst,
+    SPIHW_FBurstBusy,
+    HALHOST_UartInit,
+    HALHOST_UartPutChar,
+    HALHOST_UartTxStart,
+    HALHOST_UartRxEnable,
+    HALHOST_UartSetFlow,
+    HALHOST_ExtIntInit,
+    HALHOST_ExtIntEnable,
+    HALHOST_GetTicks
+};
+
+uint8_t fHostUartInit = 0;
+uint8_t fHostRxPoll = 1;            // the standard input is polled once the UART is initialized, see HALHOST_SetRxPoll
+uint8_t fHostStdinEnd = 0;
+uint32_t tnsHostUartChar = 0;       // duration of one UART character (10 bits)
+uint64_t tnsHostLastRxPoll = 0;
+uint64_t tnsHostExit = 0;
+
+// UART TX interrupt emulation
+uint8_t fHostUartTxActive = 0;      // TX interrupt enabled
+uint8_t fHostInUartTx = 0;
+uint64_t tnsHostUartTxFree = 0;     // the transmitter accepts the next character
+
+// UART RX and flow control emulation
+char rgchHostRx[HALHOST_RXCHUNK];   // stdin chunk being received
+int cchHostRx = 0;
+int ichHostRx = 0;
+uint8_t fHostUartRxEnabled = 1;     // RX interrupt not held
+uint8_t bHostUartFlow = UART_FLOW_NONE;
+uint8_t fHostPeerPaused = 0;        // the other side received XOFF
+
+// DMM external interrupt emulation
+void (*pfnHostDmmIntIsr)() = NULL;
+uint8_t fHostExtIntEnabled = 0;
+uint8_t fHostExtIntPending = 0;     // interrupt flag
+uint8_t fHostInIsr = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	HALHOST_InjectRx
+**
+**	Parameters:
+**		const char *szData  - zero terminated string to be received over UART
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function passes the characters of szData to the UART module as if they were received over UART.
+**          
+*/
+void HALHOST_InjectRx(const char *szData)
+{
+    while(*szData)
+    {
+        UART_ProcessRxChar((uint8_t)*(szData++));
+    }
+}
+
+/***	HALHOST_SetRxPoll
+**
+**	Parameters:
+**		uint8_t fEnable     - 1 to poll the standard input (default), 0 to ignore it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables or disables the standard input polling. While disabled, no character is read from the standard input 
+**      and its end does not cause the exit, so that a program that does not read commands (the host benchmark) 
+**      runs to its end whatever the standard input is. The characters injected by HALHOST_InjectRx are still received.
+**          
+*/
+void HALHOST_SetRxPoll(uint8_t fEnable)
+{
+    fHostRxPoll = fEnable;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	HALHOST_InitPins
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		The emulated pins need no direction configuration, so this function does nothing.
+**          
+*/
+void HALHOST_InitPins()
+{
+}
+
+/***	HALHOST_Delay10Us
+**
+**	Parameters:
+**		unsigned int t10usDelay - the amount of time to delay, in tens of microseconds
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function advances the simulated time, and polls the standard input for UART received characters 
+**      when the polling period elapsed (unless disabled by HALHOST_SetRxPoll).
+**          
+*/
+void HALHOST_Delay10Us(unsigned int t10usDelay)
+{
+    SPIMOCK_AdvanceTimeNs(10000 * t10usDelay);
+    if(fHostUartInit && fHostRxPoll && SPIMOCK_GetTimeNs() - tnsHostLastRxPoll >= HALHOST_RXPOLL_NS)
+    {
+        tnsHostLastRxPoll = SPIMOCK_GetTimeNs();
+        HALHOST_PollRx();
+    }
+}
+
+/***	HALHOST_UartInit
+**
+**	Parameters:
+**		unsigned int baud - UART baud rate
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function computes the character duration for the actual baud rate (see UART_GetBaudDivisor), 
+**      used to pace the transmitted characters, and enables the standard input polling.
+**      When a character is being transmitted, the simulated time first advances to the end of its transmission.
+**      It registers the SPIMOCK time hook that emulates the TX interrupt.
+**          
+*/
+void HALHOST_UartInit(unsigned int baud)
+{
+    uint32_t baudActual = UART_GetBaudDivisor(baud, NULL, NULL);
+    if(fHostUartInit && tnsHostUartTxFree > SPIMOCK_GetTimeNs())
+    {
+        SPIMOCK_AdvanceTimeNs(tnsHostUartTxFree - SPIMOCK_GetTimeNs());
+    }
+    tnsHostUartChar = 10000000000ull / (baudActual ? baudActual: UART_GetBaudDivisor(UART_BAUD_DEFAULT, NULL, NULL));
+    fHostUartInit = 1;
+    fHostUartTxActive = 0;
+    SPIMOCK_SetTimeHook(HALHOST_ServiceUartTx);
+}
+
+/***	HALHOST_UartPutChar
+**
+**	Parameters:
+**          char ch -   the character to be transmitted over UART.
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function writes the character to the standard output and advances the simulated time 
+**      with the duration of one character at the configured baud rate.
+**          
+*/
+void HALHOST_UartPutChar(char ch)
+{
+    putchar(ch);
+    if(ch == '\n')
+    {
+        fflush(stdout);
+    }
+    SPIMOCK_AdvanceTimeNs(tnsHostUartChar);
+}
+
+/***	HALHOST_UartTxStart
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables the emulated TX interrupt. If the transmitter is idle, the first character is written immediately.
+**          
+*/
+void HALHOST_UartTxStart()
+{
+    if(!fHostUartTxActive)
+    {
+        fHostUartTxActive = 1;
+        if(tnsHostUartTxFree < SPIMOCK_GetTimeNs())
+        {
+            tnsHostUartTxFree = SPIMOCK_GetTimeNs();
+        }
+    }
+    HALHOST_ServiceUartTx();
+}
+
+/***	HALHOST_ServiceUartTx
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function is the SPIMOCK time hook. While the emulated TX interrupt is enabled, it writes to the standard output
+**      the characters provided by UART_ProcessTxChar, one for each character duration elapsed, 
+**      and disables the TX interrupt when no character is left.
+**      With XON / XOFF flow control, the XON and XOFF characters are not written, they resume or pause the emulated other side.
+**          
+*/
+void HALHOST_ServiceUartTx()
+{
+    char ch;
+    while(fHostUartTxActive && !fHostInUartTx && tnsHostUartTxFree <= SPIMOCK_GetTimeNs())
+    {
+        fHostInUartTx = 1;
+        if(UART_ProcessTxChar(&ch))
+        {
+            if(bHostUartFlow == UART_FLOW_XONXOFF && (ch == UART_XON || ch == UART_XOFF))
+            {
+                fHostPeerPaused = (ch == UART_XOFF);
+            }
+            else
+            {
+                putchar(ch);
+            }
+            if(ch == '\n')
+            {
+                fflush(stdout);
+            }
+            tnsHostUartTxFree += tnsHostUartChar;
+        }
+        else
+        {
+            fHostUartTxActive = 0;
+        }
+        fHostInUartTx = 0;
+    }
+}
+
+/***	HALHOST_UartRxEnable
+**
+**	Parameters:
+**		uint8_t fEnable     - 0 to hold the emulated RX interrupt, 1 to release it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function holds or releases the emulated RX interrupt. While it is held, the characters read from the standard input 
+**      wait, and no more characters are read. They are received by the next HALHOST_PollRx once released.
+**          
+*/
+void HALHOST_UartRxEnable(uint8_t fEnable)
+{
+    fHostUartRxEnabled = fEnable;
+}
+
+/***	HALHOST_UartSetFlow
+**
+**	Parameters:
+**		uint8_t bFlow       - the flow control mode, UART_FLOW_...
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function selects the flow control mode emulated for the other side. The RX interrupt is released.
+**          
+*/
+void HALHOST_UartSetFlow(uint8_t bFlow)
+{
+    bHostUartFlow = bFlow;
+    fHostPeerPaused = 0;
+    fHostUartRxEnabled = 1;
+}
+
+/***	HALHOST_PollRx
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function passes the available standard input characters to UART_ProcessRxChar, without blocking.
+**      The characters are read by chunks of HALHOST_RXCHUNK, and passed while the RX interrupt is not held. 
+**      No chunk is read while the emulated other side is paused by XOFF.
+**      When the end of the standard input is reached, the exit is scheduled. The characters still queued for transmission are written before exiting.
+**          
+*/
+void HALHOST_PollRx()
+{
+    fd_set fds;
+    struct timeval tv = {0, 0};
+    char ch;
+    int cch;
+    while(fHostUartRxEnabled && ichHostRx < cchHostRx)
+    {
+        UART_ProcessRxChar((uint8_t)rgchHostRx[ichHostRx++]);
+    }
+    if(ichHostRx < cchHostRx)
+    {
+        return;
+    }
+    if(fHostStdinEnd)
+    {
+        if(SPIMOCK_GetTimeNs() >= tnsHostExit)
+        {
+            while(UART_ProcessTxChar(&ch))
+            {
+                putchar(ch);
+            }
+            fflush(stdout);
+            exit(0);
+        }
+        return;
+    }
+    if(fHostPeerPaused)
+    {
+        return;
+    }
+    FD_ZERO(&fds);
+    FD_SET(0, &fds);
+    if(select(1, &fds, NULL, NULL, &tv) > 0)
+    {
+        cch = read(0, rgchHostRx, sizeof(rgchHostRx));
+        if(cch <= 0)
+        {
+            fHostStdinEnd = 1;
+            tnsHostExit = SPIMOCK_GetTimeNs() + HALHOST_EXITDELAY_NS;
+        }
+        cchHostRx = (cch > 0) ? cch: 0;
+        ichHostRx = 0;
+        while(fHostUartRxEnabled && ichHostRx < cchHostRx)
+        {
+            UART_ProcessRxChar((uint8_t)rgchHostRx[ichHostRx++]);
+        }
+    }
+}
+
+/***	HALHOST_ExtIntInit
+**
+**	Parameters:
+**		void (*pfnIsr)()    - the function called on the active edge of the DMM interrupt pin
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function registers the interrupt handler and the SPIMOCK input hook. The interrupt is left disabled, with no pending edge.
+**          
+*/
+void HALHOST_ExtIntInit(void (*pfnIsr)())
+{
+    fHostExtIntEnabled = 0;
+    fHostExtIntPending = 0;
+    pfnHostDmmIntIsr = pfnIsr;
+    SPIMOCK_SetInputHook(HALHOST_InputChanged);
+}
+
+/***	HALHOST_ExtIntEnable
+**
+**	Parameters:
+**		uint8_t fEnable     - 1 to enable the DMM interrupt, 0 to disable it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables or disables the emulated interrupt. A pending edge is serviced when enabled.
+**          
+*/
+void HALHOST_ExtIntEnable(uint8_t fEnable)
+{
+    fHostExtIntEnabled = fEnable;
+    HALHOST_ServiceExtInt();
+}
+
+/***	HALHOST_GetTicks
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint32_t    - the timestamp counter
+**
+**	Description:
+**		This function returns the simulated time converted to HAL_TICKS_FRQ ticks, wrapping like the core timer.
+**          
+*/
+uint32_t HALHOST_GetTicks()
+{
+    return (uint32_t)(SPIMOCK_GetTimeNs() * (HAL_TICKS_FRQ / 1000000) / 1000);
+}
+
+/***	HALHOST_InputChanged
+**
+**	Parameters:
+**		int idxPin      - the input pin index
+**      uint8_t val     - the new level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function is the SPIMOCK input hook. An active edge of the DMM interrupt pin (see HAL_DMMINT_RISING) 
+**      sets the interrupt flag and the handler is called if possible.
+**          
+*/
+void HALHOST_InputChanged(int idxPin, uint8_t val)
+{
+    if(idxPin == HAL_PIN_DMMINT && val == HAL_DMMINT_RISING)
+    {
+        fHostExtIntPending = 1;
+        HALHOST_ServiceExtInt();
+    }
+}
+
+/***	HALHOST_ServiceExtInt
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function calls the interrupt handler while an edge is pending, the interrupt is enabled 
+**      and the handler is not already running (an interrupt does not preempt itself).
+**          
+*/
+void HALHOST_ServiceExtInt()
+{
+    while(fHostExtIntPending && fHostExtIntEnabled && !fHostInIsr && pfnHostDmmIntIsr)
+    {
+        fHostInIsr = 1;
+        fHostExtIntPending = 0;
+        pfnHostDmmIntIsr();
+        fHostInIsr = 0;
+    }
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
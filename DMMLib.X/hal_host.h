@@ -0,0 +1,33 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    hal_host.h
+
+  @Description
+        This file contains the declaration for the host specific functions of the host HAL implementation.
+        They are defined in hal_host.c source file, only for host builds (DMM_HOST defined).
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, bus abstraction layer
+
+ */
+/* ************************************************************************** */
+
+#ifndef _HAL_HOST_H    /* Guard against multiple inclusion */
+#define _HAL_HOST_H
+
+#include "stdint.h"
+
+void HALHOST_InjectRx(const char *szData);
+void HALHOST_SetRxPoll(uint8_t fEnable);
+
+#endif /* _HAL_HOST_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,532 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    hal_pic32.c
+
+  @Description
+        This file groups the functions that implement the PIC32 HAL operations table (halPic32Ops).
+        The digital pins are accessed using the LAT / PORT / TRIS registers (see the definitions from gpio.h), 
+        the SPI peripheral functions are implemented by the SPIHW module and the UART uses the UART1 interface.
+        The UART1 interrupt handler passes the received characters to UART_ProcessRxChar 
+        and transmits the characters provided by UART_ProcessTxChar.
+        None of these functions is intended to be called by user, they are called through the HAL macros.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, bus abstraction layer
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifndef DMM_HOST
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stddef.h>
+#include "stdint.h"
+#include "gpio.h"
+#include "spihw.h"
+#include "uart.h"
+#include "hal.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void HALPIC32_InitPins();
+void HALPIC32_SetPin(int idxPin, uint8_t val);
+uint8_t HALPIC32_GetPin(int idxPin);
+void HALPIC32_Delay10Us(unsigned int t10usDelay);
+void HALPIC32_UartInit(unsigned int baud);
+void HALPIC32_UartPutChar(char ch);
+void HALPIC32_UartTxStart();
+void HALPIC32_UartRxEnable(uint8_t fEnable);
+void HALPIC32_UartSetFlow(uint8_t bFlow);
+void HALPIC32_ExtIntInit(void (*pfnIsr)());
+void HALPIC32_ExtIntEnable(uint8_t fEnable);
+uint32_t HALPIC32_GetTicks();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// DMM interrupt registers, according to HAL_DMMINT
+#define HALPIC32_CAT3(a, b, c)          a ## b ## c
+#define HALPIC32_XCAT3(a, b, c)         HALPIC32_CAT3(a, b, c)
+#define HALPIC32_DMMINT_VECTOR          HALPIC32_XCAT3(_EXTERNAL_, HAL_DMMINT, _VECTOR)
+#define HALPIC32_DMMINT_IF              IFS0bits.HALPIC32_XCAT3(INT, HAL_DMMINT, IF)
+#define HALPIC32_DMMINT_IE              IEC0bits.HALPIC32_XCAT3(INT, HAL_DMMINT, IE)
+#define HALPIC32_DMMINT_EP              INTCONbits.HALPIC32_XCAT3(INT, HAL_DMMINT, EP)
+#define HALPIC32_DMMINT_IP              HALPIC32_XCAT3(IPC, HAL_DMMINT, bits).HALPIC32_XCAT3(INT, HAL_DMMINT, IP)
+#define HALPIC32_DMMINT_PORTBIT         ((HAL_DMMINT) ? 7 + (HAL_DMMINT): 0)   // RD0, RD8 - RD11
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+const HAL_OPS halPic32Ops = {
+    HALPIC32_InitPins,
+    HALPIC32_SetPin,
+    HALPIC32_GetPin,
+    HALPIC32_Delay10Us,
+    SPIHW_Init,
+    SPIHW_Enable,
+    SPIHW_TransferByte,
+    SPIHW_StartBurst,
+    SPIHW_FBurstBusy,
+    HALPIC32_UartInit,
+    HALPIC32_UartPutChar,
+    HALPIC32_UartTxStart,
+    HALPIC32_UartRxEnable,
+    HALPIC32_UartSetFlow,
+    HALPIC32_ExtIntInit,
+    HALPIC32_ExtIntEnable,
+    HALPIC32_GetTicks
+};
+
+void (*pfnHalDmmIntIsr)() = NULL;
+uint8_t fHalUartRtsCts = 0;         // U1RTS / U1CTS used, see HALPIC32_UartSetFlow
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interrupt service routines                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/* ------------------------------------------------------------ */
+/***	Uart1Handler
+**
+**	Description:
+**		This is the interrupt handler for UART1 RX, TX and errors. 
+**      While the RX interrupt is enabled (see HALPIC32_UartRxEnable), it passes all the available received bytes 
+**      to UART_ProcessRxChar, which builds the received lines. A byte received with a framing or parity error is reported 
+**      to UART_ProcessRxError instead. A receive buffer overrun is reported to UART_ProcessRxError and cleared, 
+**      so that the reception continues.
+**      While the TX interrupt is enabled (see HALPIC32_UartTxStart), it fills the UART1 TX buffer with the characters 
+**      provided by UART_ProcessTxChar, and disables the TX interrupt when no character is left.
+**          
+*/
+void __ISR(_UART_1_VECTOR, ipl6) Uart1Handler (void)
+{
+    char ch;
+    uint8_t bErrors;
+	//Read the Uart1 RX buffer while data is available
+	while(IEC0bits.U1RXIE && U1STAbits.URXDA)
+	{
+        // the error flags refer to the byte at the top of the RX buffer
+        bErrors = (U1STAbits.FERR ? UART_RXERR_FRAMING: 0) | (U1STAbits.PERR ? UART_RXERR_PARITY: 0);
+        ch = U1RXREG;
+        if(bErrors)
+        {
+            UART_ProcessRxError(bErrors);
+        }
+        else
+        {
+            UART_ProcessRxChar((uint8_t)ch);
+        }
+    }  
+    if(U1STAbits.OERR)
+    {
+        // the reception is stopped until OERR is cleared, which also empties the RX buffer
+        U1STAbits.OERR = 0;
+        UART_ProcessRxError(UART_RXERR_OVERRUN);
+    }
+	//Clear the Uart1 interrupt flags.
+	IFS0bits.U1RXIF = 0;
+    IFS0bits.U1EIF = 0;
+    if(IEC0bits.U1TXIE && IFS0bits.U1TXIF)
+    {
+        // fill the Uart1 TX buffer
+        while(!U1STAbits.UTXBF && UART_ProcessTxChar(&ch))
+        {
+            U1TXREG = ch;
+        }
+        if(!U1STAbits.UTXBF)
+        {
+            // there is room left, so no character is left to transmit
+            IEC0bits.U1TXIE = 0;
+        }
+        IFS0bits.U1TXIF = 0;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/***	DmmIntHandler
+**
+**	Description:
+**		This is the interrupt handler for the external interrupt connected to the DMM converter interrupt output (see HAL_DMMINT). 
+**      It clears the interrupt flag and calls the function registered by HALPIC32_ExtIntInit.
+**          
+*/
+void __ISR(HALPIC32_DMMINT_VECTOR, ipl4) DmmIntHandler (void)
+{
+    HALPIC32_DMMINT_IF = 0;
+    if(pfnHalDmmIntIsr)
+    {
+        pfnHalDmmIntIsr();
+    }
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	HALPIC32_InitPins
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function configures the digital pins used by DMMShield: 
+**      SPI_CLK, SPI_MOSI, CS_EPROM, CS_DMM and the relays control pins are configured as digital outputs, 
+**      SPI_MISO is configured as digital input.
+**          
+*/
+void HALPIC32_InitPins()
+{
+    // Configure SPI signals as digital outputs.
+    tris_SPI_CLK = 0;
+    tris_SPI_MOSI = 0;
+    // Configure SPI signals as digital inputs.
+    tris_SPI_MISO = 1;
+    
+    // Configure DMM Slave Select as digital output.
+    tris_SPI_SS = 0;
+    
+    // Configure EPROM Slave Select as digital output.
+    tris_ESPI_SS = 0;
+
+    // configure relays as digital output
+    tris_CTRL_RLU = 0;
+    tris_CTRL_RLD = 0;
+    tris_CTRL_RLI = 0;
+}
+
+/***	HALPIC32_SetPin
+**
+**	Parameters:
+**		int idxPin      - the pin index (HAL_PIN_...)
+**      uint8_t val     - the pin value
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function sets the latch of an output pin.
+**          
+*/
+void HALPIC32_SetPin(int idxPin, uint8_t val)
+{
+    switch(idxPin)
+    {
+        case HAL_PIN_CS_DMM:
+            LATDbits.LATD4 = val;
+            break;
+        case HAL_PIN_CS_EPROM:
+            LATDbits.LATD3 = val;
+            break;
+        case HAL_PIN_CLK:
+            LATGbits.LATG6 = val;
+            break;
+        case HAL_PIN_MOSI:
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+            LATGbits.LATG8 = val;
+#else
+            LATGbits.LATG7 = val;
+#endif
+            break;
+        case HAL_PIN_RLD:
+            LATFbits.LATF1 = val;
+            break;
+        case HAL_PIN_RLU:
+            LATDbits.LATD0 = val;
+            break;
+        case HAL_PIN_RLI:
+            LATDbits.LATD8 = val;
+            break;
+    }
+}
+
+/***	HALPIC32_GetPin
+**
+**	Parameters:
+**		int idxPin      - the pin index (HAL_PIN_...)
+**
+**	Return Value:
+**		uint8_t         - the pin value
+**
+**	Description:
+**		This function reads the SPI_MISO and DMM interrupt input pins. For the other pins it returns 0.
+**          
+*/
+uint8_t HALPIC32_GetPin(int idxPin)
+{
+    if(idxPin == HAL_PIN_MISO)
+    {
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+        return PORTGbits.RG7;
+#else
+        return PORTGbits.RG8;
+#endif
+    }
+    if(idxPin == HAL_PIN_DMMINT)
+    {
+        return (PORTD >> HALPIC32_DMMINT_PORTBIT) & 1;
+    }
+    return 0;
+}
+
+/***    HALPIC32_Delay10Us
+**
+**	Parameters:
+**		unsigned int t10usDelay - the amount of time to delay, in tens of microseconds
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This procedure delays program execution for the specified number
+**      of tens of microseconds. This delay is not precise.
+**		It is written with the assumption that the system clock is 40 MHz.
+*/
+void HALPIC32_Delay10Us(unsigned int t10usDelay)
+{
+    int j;
+    while ( 0 < t10usDelay )
+    {
+        t10usDelay--;
+        j = 14;
+        while ( 0 < j )
+        {
+            j--;
+        }   // end while 
+        asm volatile("nop"); // do nothing
+        asm volatile("nop"); // do nothing
+        asm volatile("nop"); // do nothing
+        asm volatile("nop"); // do nothing
+        asm volatile("nop"); // do nothing
+         
+    }   // end while
+}
+
+/***	HALPIC32_UartInit
+**
+**	Parameters:
+**		unsigned int baud - UART baud rate.
+**                                     for example 115200 corresponds to 115200 baud
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function configures the UART1 hardware interface of PIC32, according 
+**      to the provided baud rate, no parity and 1 stop bit, and additionally configures the interrupt on RX.
+**      The baud rate generator settings (BRGH, U1BRG) are computed by UART_GetBaudDivisor, 
+**      UART_BAUD_DEFAULT is used when the baud rate is not achievable.
+**      When the UART is already enabled, the function first waits for the end of the current transmission.
+**      The U1RTS / U1CTS pins are used when selected by HALPIC32_UartSetFlow.
+**      The error interrupt is enabled, so that a receive buffer overrun is cleared by the interrupt handler.
+**      The TX interrupt is requested while the TX buffer has room, it is left disabled (see HALPIC32_UartTxStart).
+**      The interrupts are not enabled globally, this is done once by the application (see Demo_UART_Dispatch).
+**          
+*/
+void HALPIC32_UartInit(unsigned int baud)
+{
+    uint8_t fBrgh;
+    uint16_t brg;
+    if(!UART_GetBaudDivisor(baud, &fBrgh, &brg))
+    {
+        UART_GetBaudDivisor(UART_BAUD_DEFAULT, &fBrgh, &brg);
+    }
+    while(U1MODEbits.ON && U1STAbits.UTXEN && !U1STAbits.TRMT);  // the characters in the TX buffer are sent at the previous baud rate
+    U1MODEbits.ON     = 0;
+    U1MODEbits.SIDL   = 0;
+    U1MODEbits.IREN   = 0; 
+    U1MODEbits.RTSMD  = 0;    // U1RTS in flow control mode
+    U1MODEbits.UEN0   = 0; 
+    U1MODEbits.UEN1   = fHalUartRtsCts; // UEN = 10: U1TX, U1RX, U1CTS and U1RTS used
+    U1MODEbits.WAKE   = 0;
+    U1MODEbits.LPBACK = 0; 
+    U1MODEbits.ABAUD  = 0;
+    U1MODEbits.RXINV  = 0; 
+    U1MODEbits.PDSEL1 = 0; 
+    U1MODEbits.PDSEL0 = 0; 
+    U1MODEbits.STSEL  = 0;  
+
+    
+    U1MODEbits.BRGH   = fBrgh; 
+
+    U1BRG = brg;
+
+    U1STAbits.UTXISEL  = 0;    // TX interrupt while the TX buffer has room
+    U1STAbits.UTXEN    = 1;
+    U1STAbits.URXEN    = 1;
+    U1MODEbits.ON      = 1; 
+
+    
+    IPC6bits.U1IP = 6;
+    IPC6bits.U1IS = 3;
+
+	IFS0bits.U1RXIF = 0;    //Clear the Uart1 interrupt flag.
+    IEC0bits.U1RXIE = 1;    // enable RX interrupt
+    IFS0bits.U1EIF = 0;
+    IEC0bits.U1EIE = 1;     // enable error interrupt
+    IEC0bits.U1TXIE = 0;    // TX interrupt enabled by HALPIC32_UartTxStart
+}
+
+/***	HALPIC32_UartPutChar
+**
+**	Parameters:
+**          char ch -   the character to be transmitted over UART.
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function transmits a character over UART1. 
+**          
+*/
+void HALPIC32_UartPutChar(char ch)
+{
+    while(U1STAbits.UTXBF == 1);
+    U1TXREG = ch;
+}
+
+/***	HALPIC32_UartTxStart
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables the UART1 TX interrupt: the interrupt handler then transmits the characters 
+**      provided by UART_ProcessTxChar, until none is left.
+**          
+*/
+void HALPIC32_UartTxStart()
+{
+    IEC0bits.U1TXIE = 1;
+}
+
+/***	HALPIC32_UartRxEnable
+**
+**	Parameters:
+**		uint8_t fEnable     - 0 to hold the UART1 RX interrupt, 1 to release it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function holds or releases the UART1 RX interrupt. While it is held, the received bytes wait in the RX buffer; 
+**      with RTS / CTS flow control, the UART deasserts U1RTS when the RX buffer is full, which stops the other side.
+**          
+*/
+void HALPIC32_UartRxEnable(uint8_t fEnable)
+{
+    IEC0bits.U1RXIE = fEnable ? 1: 0;
+}
+
+/***	HALPIC32_UartSetFlow
+**
+**	Parameters:
+**		uint8_t bFlow       - the flow control mode, UART_FLOW_...
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function selects the UART1 pins: U1RTS and U1CTS are used for UART_FLOW_RTSCTS, only U1TX and U1RX otherwise 
+**      (XON / XOFF is implemented by the UART module). The UART is configured again, at the current baud rate (U1BRG is kept).
+**          
+*/
+void HALPIC32_UartSetFlow(uint8_t bFlow)
+{
+    fHalUartRtsCts = (bFlow == UART_FLOW_RTSCTS);
+    while(U1MODEbits.ON && U1STAbits.UTXEN && !U1STAbits.TRMT);
+    U1MODEbits.ON   = 0;
+    U1MODEbits.UEN1 = fHalUartRtsCts;
+    U1MODEbits.UEN0 = 0;
+    U1MODEbits.ON   = 1;
+    IEC0bits.U1RXIE = 1;
+}
+
+/***	HALPIC32_ExtIntInit
+**
+**	Parameters:
+**		void (*pfnIsr)()    - the function called from the interrupt
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function configures the external interrupt selected by HAL_DMMINT: the pin as digital input, 
+**      the active edge according to HAL_DMMINT_RISING, and priority 4. The interrupt is left disabled, 
+**      with the flag cleared, see HALPIC32_ExtIntEnable. The interrupts are not enabled globally, this is done by the application.
+**          
+*/
+void HALPIC32_ExtIntInit(void (*pfnIsr)())
+{
+    HALPIC32_DMMINT_IE = 0;
+    pfnHalDmmIntIsr = pfnIsr;
+    TRISDSET = 1 << HALPIC32_DMMINT_PORTBIT;
+    HALPIC32_DMMINT_EP = HAL_DMMINT_RISING;
+    HALPIC32_DMMINT_IP = 4;
+    HALPIC32_DMMINT_IF = 0;
+}
+
+/***	HALPIC32_ExtIntEnable
+**
+**	Parameters:
+**		uint8_t fEnable     - 1 to enable the DMM interrupt, 0 to disable it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables or disables the DMM external interrupt. 
+**      The flag is not cleared, so an edge detected while disabled triggers the interrupt when enabled.
+**          
+*/
+void HALPIC32_ExtIntEnable(uint8_t fEnable)
+{
+    HALPIC32_DMMINT_IE = fEnable ? 1: 0;
+}
+
+/***	HALPIC32_GetTicks
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint32_t    - the core timer value
+**
+**	Description:
+**		This function returns the core timer, which counts at SYSCLK / 2 (HAL_TICKS_FRQ).
+**          
+*/
+uint32_t HALPIC32_GetTicks()
+{
+    return _CP0_GET_COUNT();
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -11,6 +11,10 @@
         This file is the application entry point.
         It contains the definition of the UART dispatch commands demo function, used for communicating with the DMM module and is called from main function
         It also implements a demo function for EPROM functionality, which is not called by the main function.
+        When built for host (DMM_HOST defined, see the host target from Makefile) the UART commands are read from 
+        the standard input and the answers are written to the standard output, the DMM converter and the EPROM being simulated by DMMSIM and EPROMSIM modules.
+        On host, the "-bench [samples]" argument runs the Demo_HostBenchmark function instead, which measures the software cost 
+        of the measurements and of the EPROM accesses. The "-eprom <file>" argument selects the EPROM content backing file.
 
   @Author
     Cristian Fatu 
@@ -25,8 +29,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#ifndef DMM_HOST
 #include <xc.h>
 #include <sys/attribs.h>
+#endif
 #include "math.h"
 #include "stdint.h"
 #include "spi.h"
@@ -37,7 +44,10 @@
 #include "serialno.h"
 #include "errors.h"
 #include "gpio.h"
+#include "eprom.h"
+#include "utils.h"
 
+#ifndef DMM_HOST
 #pragma config FWDTEN = OFF     
 
 
@@ -57,16 +67,75 @@
 #pragma config FPLLIDIV =	DIV_2
 #pragma config FPLLMUL =	MUL_20
 #pragma config FPLLODIV =	DIV_1
+#else
+#include <time.h>
+#include "spimock.h"
+#include "dmmsim.h"
+#include "epromsim.h"
+#include "dmmacq.h"
+#include "autorange.h"
+#include "dmmfilt.h"
+#include "mains.h"
+#include "dmmbin.h"
+#include "hal_host.h"
+#endif
 
 
 void Demo_UART_Dispatch();
 void Demo_UserEPROM();
+#ifdef DMM_HOST
+#define DEMO_HOST_SERIALNO  "HOST00000001"    // serial number placed in the simulated EPROM, SERIALNO_SIZE characters
+int Demo_HostBenchmark(int cntSamples);
+int Demo_HostBenchmarkConversion();
+int Demo_HostBenchmarkISqrt();
+double Demo_HostSoftSqrt(double d);
+int Demo_HostBenchmarkAutorange();
+int Demo_HostBenchmarkFilter();
+int Demo_HostBenchmarkMains();
+int Demo_HostBenchmarkUart();
+int Demo_HostBenchmarkStream();
+int Demo_HostCheck(uint8_t fPass, const char *szName, const char *szCheck);
+double Demo_HostInputGain();
+void Demo_HostGetSimCfg(uint8_t *pbCfg);
+void Demo_HostInitEprom();
+#endif
 
 
 
 
 int main(int argc, char** argv) 
 {
+#ifdef DMM_HOST
+    EPROMSIM_CFG cfgEprom;
+    int idxArg, cntBenchSamples = 0;
+    uint8_t fEpromLoaded = 0;
+    DMMSIM_Init();
+    EPROMSIM_Init();
+    for(idxArg = 1; idxArg < argc; idxArg++)
+    {
+        if(!strcmp(argv[idxArg], "-bench"))
+        {
+            cntBenchSamples = (idxArg + 1 < argc && atoi(argv[idxArg + 1]) > 0) ? atoi(argv[++idxArg]): 10000;
+        }
+        else if(!strcmp(argv[idxArg], "-eprom") && idxArg + 1 < argc)
+        {
+            EPROMSIM_GetDefaultCfg(&cfgEprom);
+            cfgEprom.szFile = argv[++idxArg];
+            fEpromLoaded = EPROMSIM_SetCfg(&cfgEprom);
+        }
+    }
+    if(!fEpromLoaded)
+    {
+        Demo_HostInitEprom();
+    }
+    if(cntBenchSamples)
+    {
+        // the benchmark reads no command, the UART benchmark must not end the program at the end of stdin
+        HALHOST_SetRxPoll(0);
+        // a failed check gives a non zero exit status, so that the benchmark can be run as a test
+        return Demo_HostBenchmark(cntBenchSamples) ? 1: 0;
+    }
+#endif
 //    Demo_UserEPROM();
     Demo_UART_Dispatch();
     return (1);
@@ -82,8 +151,11 @@ int main(int argc, char** argv)
 **
 **	Description:
 **		This function implements the main demo UART command dispatch interpreter. 
-**      It calls the initialization function for DMMCMD module DMMCMD_Init(). 
+**      It calls the initialization function for DMMCMD module DMMCMD_Init(), then enables the interrupts 
+**      (the library initialization functions only configure their interrupt sources).
 **      In an infinite - while - loop the function calls DMMCMD_CheckForCommand to check with null parameter for uartCmdFurtherProcess.
+**      The loop only waits 10 us between the calls, so that the repeated session keeps the background status read 
+**      overlapping the UART output instead of waiting between the values.
 **      
 */
 void Demo_UART_Dispatch()
@@ -91,11 +163,14 @@ void Demo_UART_Dispatch()
     ERRORS_Init("OK", "ERROR");
     //perform modules initialization
     DMMCMD_Init();
+#ifndef DMM_HOST
+    macro_enable_interrupts();
+#endif
     UART_PutString("Demo UART CMD, Send commands \r\n");
     DelayAprox10Us(10000);
     while(1)
     {
-        DelayAprox10Us(10000);
+        DelayAprox10Us(1);
         DMMCMD_CheckForCommand();
     }
 }
@@ -120,6 +195,9 @@ void Demo_UserEPROM()
     uint8_t bErrCode;
     EPROM_Init();
     UART_Init(9600);
+#ifndef DMM_HOST
+    macro_enable_interrupts();
+#endif
     UART_PutString("EPROM demo\r\n");
     UART_PutString("Stored string:\r\n");
     UART_PutString(sUserText);
@@ -148,6 +226,1199 @@ void Demo_UserEPROM()
     }
 }
 
+#ifdef DMM_HOST
+/***	Demo_HostInitEprom()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          none
+**
+**	Description:
+**		This function is only built for host. It places neutral calibration data (Mult = 0, Add = 0 for all scales) 
+**      in the user and factory calibration areas of the simulated EPROM, as a blank EPROM would lead to invalid coefficients.
+**      It also places a valid serial number record (DEMO_HOST_SERIALNO), so that SERIALNO_ReadSerialNoFromEPROM succeeds.
+**      It is called when no EPROM content file was loaded.
+**
+*/
+void Demo_HostInitEprom()
+{
+    CALIBDATA calibNeutral;
+    SERIALNODATA serialNo;
+    uint16_t *pwCalib = (uint16_t *)&calibNeutral;
+    uint16_t *pwSerialNo = (uint16_t *)&serialNo;
+    int i;
+    memset(&calibNeutral, 0, sizeof(calibNeutral));
+    calibNeutral.magic = EPROM_MAGIC_NO;
+    calibNeutral.crc = GetBufferChecksum((uint8_t *)&calibNeutral, sizeof(calibNeutral));
+    for(i = 0; i < sizeof(calibNeutral)/2; i++)
+    {
+        EPROMSIM_SetWord(ADR_EPROM_CALIB + i, pwCalib[i]);
+        EPROMSIM_SetWord(ADR_EPROM_FACTCALIB + i, pwCalib[i]);
+    }
+    memset(&serialNo, 0, sizeof(serialNo));
+    serialNo.magic = EPROM_MAGIC_NO;
+    memcpy(serialNo.rgchSN, DEMO_HOST_SERIALNO, SERIALNO_SIZE);
+    serialNo.crc = GetBufferChecksum((uint8_t *)&serialNo, sizeof(serialNo));
+    for(i = 0; i < sizeof(serialNo)/2; i++)
+    {
+        EPROMSIM_SetWord(ADR_EPROM_SERIALNO + i, pwSerialNo[i]);
+    }
+}
+
+/***	Demo_HostBenchmark()
+**
+**	Parameters:
+**		int cntSamples  - the number of samples for each measurement
+**
+**	Return Value:
+**          int     - the number of failed checks (see Demo_HostCheck), 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It measures the software cost of DMM_DGetValue (for both polling modes), 
+**      DMM_DGetAvgValue and the block capture DMM_GetSamples followed by DMM_CodesToValues, using the DMMSIM converter model: 1 V DC on the 5 V DC scale and 1 V RMS on the 5 V AC scale.
+**      For each measurement it prints the value, the host CPU time, simulated time and SPI clocks per sample.
+**      For each scale it also prints the statistics computed by DMM_AcquireStats and checks the moving average window against the direct average.
+**      The DMMSIM converter keeps the conversion done flags when INTF is read, unless built with DMM_INTF_READCLEAR: 
+**      the bytes saved by DMM_POLL_INTF are those of the library default configuration.
+**      The interrupt driven acquisition (DMMACQ) is also measured on the 5 V DC scale: samples interval and overflows. 
+**      It is only available when built with -DSPI_TRANSPORT=1 -DDMM_INTF_READCLEAR=1 (see make host-check).
+**      The scale switching is measured on a sweep through all the scales and on switches between scales using the same relays, 
+**      with the full configuration sequence and incremental, each switch being followed by a value read, 
+**      using the settle detection and the fixed settling delays. The SPI bytes transferred by DMM_SetScale are counted 
+**      (see DMM_GetCfgBytes), the incremental switching must transfer less bytes than the full sequence of the same sweep. 
+**      The DMMSIM settling model counts the values read before the scale settled (see the DMM_SETTLE_... constants).
+**      The auto-ranging is measured by Demo_HostBenchmarkAutorange, the filter stages by Demo_HostBenchmarkFilter,
+**      the mains synchronous integration by Demo_HostBenchmarkMains, the UART transmission by Demo_HostBenchmarkUart,
+**      the text and binary (DMMBIN) formats of the repeated values by Demo_HostBenchmarkStream.
+**      The double and fixed point conversions are compared by Demo_HostBenchmarkConversion, 
+**      the integer square root is checked by Demo_HostBenchmarkISqrt.
+**      Then it runs the calibration boot load, the calibration save and the serial number read, 
+**      printing the simulated time and the EPROM bus cycles and operations counted by EPROMSIM.
+**      Along the measurements it checks the error codes, the values (1 V within 1e-4), that DMM_GetSamples captures 
+**      a different conversion for each code (the DMMSIM conversions count), the moving average window,
+**      the DMMACQ overflows, the values read before the scale settled and the results checked by the other benchmarks.
+**
+*/
+int Demo_HostBenchmark(int cntSamples)
+{
+    const struct {int idxScale; double dcCode; double acCode; const char *szName;} rgBench[] = {
+        {8, 1208012.0, 0, "5 V DC"},        // 1 V: 1 / (12.5 / 1.8 / 8388608)
+        {12, 0, 14142.1356, "5 V AC"},      // 1 V RMS: sqrt(mean square) = 1 / 1e-4
+    };
+    const char *rgszEpromOps[] = {"CALIB_ReadAllCalibsFromEPROM_User", "CALIB_WriteAllCalibsToEPROM_User", "SERIALNO_ReadSerialNoFromEPROM"};
+    char szSerialNo[SERIALNO_SIZE + 1];
+    DMMSIM_CFG cfg;
+    DMMSIM_STATS stats;
+    DMMSTATS statsVal;
+    DMMSTATS_WND wnd;
+    double rgdWnd[20], dSum, dDevMax, dJitterMax;
+    EPROMSIM_STATS statsEprom;
+    DMMSAMPLE sample;
+    uint32_t tFirst = 0, tPrev = 0;
+    struct timespec tsStart, tsStop;
+    uint64_t tnsSimStart;
+    double dVal, dCpuNs;
+    uint8_t bErr;
+    SPIMOCK_STATS statsSpi;
+    const char *rgszMeas[] = {"DMM_DGetValue full status", "DMM_DGetValue INTF polling", "DMM_DGetAvgValue", "DMM_GetSamples + DMM_CodesToValues"};
+    int64_t rgCodes[256];
+    double rgdVals[256];
+    int idxBench, idxMeas, i, cntBlock, cntDetected;
+    uint32_t tusSettleSum, cntUnsettled, cbCfgFull = 0;
+    uint8_t fDetected;
+    int cntFailed = 0;
+
+    ERRORS_Init("OK", "ERROR");
+    DMM_Init();
+    printf("Host benchmark, %d samples\n", cntSamples);
+    for(idxBench = 0; idxBench < sizeof(rgBench)/sizeof(rgBench[0]); idxBench++)
+    {
+        DMMSIM_GetDefaultCfg(&cfg);
+        cfg.dcCode = rgBench[idxBench].dcCode;
+        cfg.acCode = rgBench[idxBench].acCode;
+        cfg.noiseCode = 8;
+        DMMSIM_SetCfg(&cfg);
+        bErr = DMM_SetScale(rgBench[idxBench].idxScale);
+        if(bErr != ERRVAL_SUCCESS)
+        {
+            printf("%s: DMM_SetScale error 0x%02X\n", rgBench[idxBench].szName, bErr);
+            cntFailed++;
+            continue;
+        }
+        for(idxMeas = 0; idxMeas < sizeof(rgszMeas)/sizeof(rgszMeas[0]); idxMeas++)
+        {
+            DMM_SetPollMode(idxMeas ? DMM_POLL_INTF: DMM_POLL_FULLSTATUS);
+            DMM_ResetPollSavedBytes();
+            DMMSIM_ResetStats();
+            SPIMOCK_ResetStats();
+            tnsSimStart = SPIMOCK_GetTimeNs();
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+            if(idxMeas == 2)
+            {
+                dVal = DMM_DGetAvgValue(cntSamples, &bErr);
+            }
+            else if(idxMeas == 3)
+            {
+                bErr = ERRVAL_SUCCESS;
+                for(i = 0; i < cntSamples && bErr == ERRVAL_SUCCESS; i += cntBlock)
+                {
+                    cntBlock = (cntSamples - i < 256) ? cntSamples - i: 256;
+                    bErr = DMM_GetSamples(rgCodes, cntBlock);
+                    if(bErr == ERRVAL_SUCCESS)
+                    {
+                        bErr = DMM_CodesToValues(rgCodes, rgdVals, cntBlock);
+                    }
+                    dVal = rgdVals[cntBlock - 1];
+                }
+            }
+            else
+            {
+                for(i = 0; i < cntSamples; i++)
+                {
+                    dVal = DMM_DGetValue(&bErr);
+                }
+            }
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+            DMMSIM_GetStats(&stats);
+            SPIMOCK_GetStats(&statsSpi);
+            dCpuNs = (tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec);
+            printf("%s %s: value %f, err 0x%02X, cpu %.0f ns/sample, simulated %.1f us/sample, %u status reads, %.1f SPI clocks/sample, %u bytes saved\n", 
+                rgBench[idxBench].szName, rgszMeas[idxMeas], dVal, bErr, 
+                dCpuNs / cntSamples, (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e3 / cntSamples, stats.cntStatusReads, 
+                (double)statsSpi.cntClocks / cntSamples, DMM_GetPollSavedBytes());
+            cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && fabs(dVal - 1) < 1e-4, rgBench[idxBench].szName, rgszMeas[idxMeas]);
+            if(idxMeas == 3)
+            {
+                // each captured code comes from a different conversion
+                cntFailed += Demo_HostCheck(stats.cntConversions >= cntSamples, rgBench[idxBench].szName, "DMM_GetSamples new conversions");
+            }
+        }
+        // all the statistics from the same acquisition pass
+        DMMSTATS_Init(&statsVal, DMMSTATS_POLICY_SKIP);
+        bErr = DMM_AcquireStats(cntSamples, &statsVal);
+        printf("%s DMM_AcquireStats: err 0x%02X, count %u, mean %f, stddev %.3e, min %f, max %f, rms %f, %u overloads\n", 
+            rgBench[idxBench].szName, bErr, statsVal.cntValues, DMMSTATS_DGetMean(&statsVal), DMMSTATS_DGetStdDev(&statsVal), 
+            statsVal.dMin, statsVal.dMax, DMMSTATS_DGetRMS(&statsVal), statsVal.cntOverloads);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && statsVal.cntValues == cntSamples && fabs(DMMSTATS_DGetMean(&statsVal) - 1) < 1e-4, 
+            rgBench[idxBench].szName, "DMM_AcquireStats");
+        // moving average: one conversion for each averaged value, checked against the direct average of the same values
+        DMMSTATS_WndInit(&wnd, rgdWnd, 20);
+        dDevMax = 0;
+        tnsSimStart = SPIMOCK_GetTimeNs();
+        for(i = 0; i < cntSamples && bErr == ERRVAL_SUCCESS; i++)
+        {
+            rgdVals[i % 20] = DMM_DGetValue(&bErr);
+            dVal = DMMSTATS_DWndAdd(&wnd, rgdVals[i % 20], rgBench[idxBench].idxScale, rgBench[idxBench].acCode != 0);
+            for(cntBlock = 0, dSum = 0; cntBlock < 20 && cntBlock <= i; cntBlock++)
+            {
+                dSum += (rgBench[idxBench].acCode != 0) ? rgdVals[cntBlock] * rgdVals[cntBlock]: rgdVals[cntBlock];
+            }
+            dSum = (rgBench[idxBench].acCode != 0) ? sqrt(dSum / cntBlock): dSum / cntBlock;
+            dDevMax = fmax(dDevMax, fabs(dVal - dSum));
+        }
+        printf("%s DMMSTATS_DWndAdd 20 values: value %f, err 0x%02X, simulated %.1f us/averaged value, max deviation from direct average %.3e\n", 
+            rgBench[idxBench].szName, dVal, bErr, (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e3 / cntSamples, dDevMax);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && dDevMax < 1e-12, rgBench[idxBench].szName, "DMMSTATS_DWndAdd");
+    }
+
+    DMM_SetPollMode(DMM_POLL_INTF);
+
+    // interrupt driven acquisition, the main loop only waits for samples 
+    // (only available with the hardware SPI transport and a converter clearing the flags when INTF is read)
+    DMMSIM_GetDefaultCfg(&cfg);
+    cfg.dcCode = rgBench[0].dcCode;
+    DMMSIM_SetCfg(&cfg);
+    DMM_SetScale(rgBench[0].idxScale);
+    bErr = DMMACQ_Start();
+    if(bErr == ERRVAL_DMMACQ_UNAVAILABLE)
+    {
+        printf("5 V DC DMMACQ: err 0x%02X, not available in this build (build with -DSPI_TRANSPORT=1 -DDMM_INTF_READCLEAR=1, see make host-check)\n", bErr);
+    }
+    tnsSimStart = SPIMOCK_GetTimeNs();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+    dJitterMax = 0;
+    for(i = 0; i < cntSamples && bErr == ERRVAL_SUCCESS; i++)
+    {
+        bErr = DMMACQ_WaitSample(&sample, 100000);
+        if(i == 0)
+        {
+            tFirst = sample.tstamp;
+        }
+        else if(i > 1 && bErr == ERRVAL_SUCCESS)
+        {
+            // each conversion is stamped when its interrupt is taken: the intervals are the conversion period
+            // (the first conversion may be done before the external interrupt is enabled, it is serviced late), 
+            // within the 10 us main loop delay at which the host HAL services the emulated interrupt
+            dJitterMax = fmax(dJitterMax, fabs((double)(sample.tstamp - tPrev) / (HAL_TICKS_FRQ / 1e6) - cfg.tusConv));
+        }
+        tPrev = sample.tstamp;
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+    DMMACQ_Stop();
+    dCpuNs = (tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec);
+    if(bErr != ERRVAL_DMMACQ_UNAVAILABLE)
+    {
+        printf("5 V DC DMMACQ: value %f, err 0x%02X, cpu %.0f ns/sample, simulated %.1f us/sample, interval %.1f us (max deviation %.1f us), %u overflows, high water %u\n", 
+            DMM_DSampleToValue(&sample, NULL), bErr, dCpuNs / cntSamples, (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e3 / cntSamples, 
+            (i > 1) ? (double)(sample.tstamp - tFirst) / (i - 1) / (HAL_TICKS_FRQ / 1e6): 0, dJitterMax, DMMACQ_GetOverflows(), DMMACQ_GetHighWater());
+    }
+#if (SPI_TRANSPORT == SPI_TRANSPORT_HW) && DMM_INTF_READCLEAR
+    // all the conversions acquired, none lost, 1 V within 1e-4, timestamps within 1 % of the conversion period
+    cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && i == cntSamples && DMMACQ_GetOverflows() == 0 
+        && fabs(DMM_DSampleToValue(&sample, NULL) - 1) < 1e-4 && dJitterMax < cfg.tusConv * 0.01, "5 V DC", "DMMACQ");
+#else
+    cntFailed += Demo_HostCheck(bErr == ERRVAL_DMMACQ_UNAVAILABLE, "5 V DC", "DMMACQ not available");
+#endif
+
+    // scales sweep (all the scales, then 5 V DC / 50 V DC which use the same relays), 
+    // full configuration sequence compared to the incremental scale switching, each switch followed by a value read,
+    // with the settle detection, then with the fixed settling delays
+    DMMSIM_GetDefaultCfg(&cfg);
+    cfg.dcCode = rgBench[0].dcCode;
+    cfg.noiseCode = 8;
+    DMMSIM_SetCfg(&cfg);
+    for(idxMeas = 0; idxMeas < 8; idxMeas++)
+    {
+        DMM_SetSettleDetect(idxMeas < 4);
+        DMM_InvalidateCfgShadow();
+        DMM_SetScale(0);
+        DMM_ResetCfgBytes();
+        DMMSIM_ResetStats();
+        SPIMOCK_ResetStats();
+        tnsSimStart = SPIMOCK_GetTimeNs();
+        bErr = ERRVAL_SUCCESS;
+        tusSettleSum = 0;
+        cntDetected = 0;
+        cntUnsettled = 0;
+        for(i = 1; i < DMM_CNTSCALES && bErr == ERRVAL_SUCCESS; i++)
+        {
+            if(!(idxMeas & 1))
+            {
+                DMM_InvalidateCfgShadow();
+            }
+            bErr = DMM_SetScale((idxMeas & 2) ? ((i & 1) ? 8: 7): i);
+            tusSettleSum += DMM_GetSettleTime(&fDetected);
+            cntDetected += fDetected;
+            if(bErr == ERRVAL_SUCCESS)
+            {
+                // only the reads after DMM_SetScale returned are counted, the settle detection reads the settling codes on purpose
+                DMMSIM_GetStats(&stats);
+                cntUnsettled -= stats.cntUnsettledReads;
+                dVal = DMM_DGetValue(&bErr);
+                DMMSIM_GetStats(&stats);
+                cntUnsettled += stats.cntUnsettledReads;
+            }
+        }
+        DMMSIM_GetStats(&stats);
+        SPIMOCK_GetStats(&statsSpi);
+        printf("DMM_SetScale %s %s %s: err 0x%02X, simulated %.2f ms/switch and read, settle %.2f ms (%d detected), %.1f SPI clocks/switch, %u resets, %.1f bytes/switch, %u unsettled reads\n", 
+            (idxMeas & 2) ? "5 V DC / 50 V DC": "all scales", (idxMeas & 1) ? "incremental": "full", (idxMeas < 4) ? "detect": "fixed", bErr, 
+            (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6 / (DMM_CNTSCALES - 1), tusSettleSum / 1e3 / (DMM_CNTSCALES - 1), cntDetected, 
+            (double)statsSpi.cntClocks / (DMM_CNTSCALES - 1), stats.cntResets, (double)DMM_GetCfgBytes() / (DMM_CNTSCALES - 1), cntUnsettled);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && cntUnsettled == 0, "DMM_SetScale", "scales sweep");
+        if(!(idxMeas & 1))
+        {
+            cbCfgFull = DMM_GetCfgBytes();
+        }
+        else
+        {
+            // the full sequence of the same sweep was measured just before
+            printf("DMM_SetScale %s %s: incremental saves %.1f bytes/switch\n", (idxMeas & 2) ? "5 V DC / 50 V DC": "all scales", 
+                (idxMeas < 4) ? "detect": "fixed", ((double)cbCfgFull - DMM_GetCfgBytes()) / (DMM_CNTSCALES - 1));
+            cntFailed += Demo_HostCheck(DMM_GetCfgBytes() < cbCfgFull, "DMM_SetScale", "incremental bytes");
+        }
+    }
+    DMM_SetSettleDetect(1);
+
+    cntFailed += Demo_HostBenchmarkAutorange();
+    cntFailed += Demo_HostBenchmarkFilter();
+    cntFailed += Demo_HostBenchmarkMains();
+    cntFailed += Demo_HostBenchmarkUart();
+    cntFailed += Demo_HostBenchmarkStream();
+    cntFailed += Demo_HostBenchmarkConversion();
+    cntFailed += Demo_HostBenchmarkISqrt();
+    CALIB_Init();
+    for(idxBench = 0; idxBench < sizeof(rgszEpromOps)/sizeof(rgszEpromOps[0]); idxBench++)
+    {
+        EPROMSIM_ResetStats();
+        tnsSimStart = SPIMOCK_GetTimeNs();
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+        switch(idxBench)
+        {
+            case 0:
+                bErr = CALIB_ReadAllCalibsFromEPROM_User();
+                break;
+            case 1:
+                bErr = CALIB_WriteAllCalibsToEPROM_User();
+                break;
+            default:
+                bErr = SERIALNO_ReadSerialNoFromEPROM(szSerialNo);
+                break;
+        }
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+        EPROMSIM_GetStats(&statsEprom);
+        dCpuNs = (tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec);
+        printf("%s: err 0x%02X, cpu %.0f us, simulated %.3f ms, %u clocks, %u selects, %u reads, %u writes, %u busy polls\n", 
+            rgszEpromOps[idxBench], bErr, dCpuNs / 1e3, (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6, 
+            statsEprom.cntClocks, statsEprom.cntSelects, statsEprom.cntReads, statsEprom.cntWrites, statsEprom.cntBusyPolls);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS, rgszEpromOps[idxBench], "error");
+    }
+    printf("Host benchmark: %d failed checks\n", cntFailed);
+    return cntFailed;
+}
+
+/***	Demo_HostCheck()
+**
+**	Parameters:
+**		uint8_t fPass           - the check result, 0 if it failed
+**		const char *szName      - the name of the measurement
+**		const char *szCheck     - the name of the check
+**
+**	Return Value:
+**          int     - 1 if the check failed, 0 otherwise
+**
+**	Description:
+**		This function is only built for host. It prints a line when a benchmark check failed, 
+**      its return value is added to the number of failed checks returned by the benchmark functions.
+**
+*/
+int Demo_HostCheck(uint8_t fPass, const char *szName, const char *szCheck)
+{
+    if(!fPass)
+    {
+        printf("CHECK FAILED: %s %s\n", szName, szCheck);
+    }
+    return fPass ? 0: 1;
+}
+double rgdHostInputGain[DMM_CNTSCALES];   // AD1 codes per signal unit of each scale, see Demo_HostInputGain
+uint8_t rgbHostScaleCfg[DMM_CNTSCALES][DMM_CFG_CNTREGS + 1];  // simulated configuration of each scale, see Demo_HostGetSimCfg
+
+/***	Demo_HostBenchmarkAutorange()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It measures the auto-ranging (AUTORANGE module) on the resistance, 
+**      DC voltage and DC low current modes: the DMMSIM input is expressed in signal units (see Demo_HostInputGain)
+**      and steps through values requiring range changes in both directions, including overload from the lowest range. 
+**      For each step, AUTORANGE_DGetValue is called and the selected scale and value are printed.
+**      For each mode it prints the scale changes, the relay transitions and the last / maximum ranging latency.
+**      It checks the error codes and the values, within 0.1 % of the input (the simulated input gain is linear, 
+**      the VoltageDC50 compensation is not).
+**      It returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkAutorange()
+{
+    const struct {int mode; const char *szName; double rgdVals[6];} rgBench[] = {
+        {DmmDCVoltage, "DC voltage", {1.0, 0.03, 20, 0.3, 3, -0.004}},
+        {DmmResistance, "Resistance", {1e3, 47, 2.2e6, 330, 1e5, 12}},
+        {DmmDCLowCurrent, "DC low current", {0.1, 2e-4, 0.02, -3e-3, 0.3, 1e-5}},
+    };
+    DMMSIM_CFG cfg;
+    int64_t rgCodes[2] = {0, 1 << 20};
+    double rgdVals[2], dVal;
+    char szVal[20];
+    AUTORANGESTATS stats;
+    uint64_t tnsSimStart;
+    uint8_t bErr;
+    int idxBench, i, cntFailed = 0;
+
+    // the AD1 codes per signal unit of each scale, from the uncalibrated conversion (only meaningful for the AD1 scales)
+    DMM_SetUseCalib(0);
+    for(i = 0; i < DMM_CNTSCALES; i++)
+    {
+        rgdHostInputGain[i] = 1;
+        if(DMM_SetScale(i) == ERRVAL_SUCCESS && DMM_CodesToValues(rgCodes, rgdVals, 2) == ERRVAL_SUCCESS)
+        {
+            rgdHostInputGain[i] = (rgCodes[1] - rgCodes[0]) / (rgdVals[1] - rgdVals[0]);
+        }
+        Demo_HostGetSimCfg(rgbHostScaleCfg[i]);
+    }
+    DMM_SetUseCalib(1);
+    DMMSIM_GetDefaultCfg(&cfg);
+    cfg.pfnInputGain = Demo_HostInputGain;
+    for(idxBench = 0; idxBench < sizeof(rgBench)/sizeof(rgBench[0]); idxBench++)
+    {
+        cfg.dcCode = rgBench[idxBench].rgdVals[0];
+        cfg.noiseCode = cfg.dcCode * 1e-5;
+        DMMSIM_SetCfg(&cfg);
+        bErr = AUTORANGE_Start(rgBench[idxBench].mode);
+        AUTORANGE_ResetStats();
+        tnsSimStart = SPIMOCK_GetTimeNs();
+        printf("Autorange %s:", rgBench[idxBench].szName);
+        for(i = 0; i < sizeof(rgBench[0].rgdVals)/sizeof(rgBench[0].rgdVals[0]) && bErr == ERRVAL_SUCCESS; i++)
+        {
+            cfg.dcCode = rgBench[idxBench].rgdVals[i];
+            cfg.noiseCode = fabs(cfg.dcCode) * 1e-5;
+            DMMSIM_SetCfg(&cfg);
+            // without DMM_INTF_READCLEAR the last conversion is read: the input step is done one conversion before the reading
+            DelayAprox10Us(cfg.tusConv / 10);
+            dVal = AUTORANGE_DGetValue(&bErr);
+            DMM_FormatValue(dVal, szVal, 1);
+            printf(" %s (scale %d)", szVal, DMM_GetCurrentScale());
+            if(bErr == ERRVAL_SUCCESS && fabs(dVal - cfg.dcCode) > fabs(cfg.dcCode) * 1e-3)
+            {
+                cntFailed += Demo_HostCheck(0, "Autorange", rgBench[idxBench].szName);
+            }
+        }
+        AUTORANGE_GetStats(&stats);
+        printf("\n    err 0x%02X, %u range changes, %u relay changes, %u rangings, latency last %.2f ms max %.2f ms, simulated %.2f ms\n", 
+            bErr, stats.cntRangeChanges, stats.cntRelayChanges, stats.cntRangings, stats.tusLastLatency / 1e3, stats.tusMaxLatency / 1e3, 
+            (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS, "Autorange", rgBench[idxBench].szName);
+    }
+    AUTORANGE_Stop();
+    DMMSIM_GetDefaultCfg(&cfg);
+    DMMSIM_SetCfg(&cfg);
+    return cntFailed;
+}
+
+/***	Demo_HostInputGain()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          double  - the AD1 codes per signal unit of the current scale
+**
+**	Description:
+**		This function is only built for host. It is the DMMSIM pfnInputGain function used by Demo_HostBenchmarkAutorange, 
+**      so that the simulated input is expressed in signal units and saturates the convertor on the too low ranges.
+**      The range is the one of the configuration written in the simulated converter and relays (see Demo_HostGetSimCfg), 
+**      not the current scale: DMM_SetScale only updates the current scale after the settling, 
+**      the conversions read by the settle detection must already use the gain of the new range.
+**      When several scales have the same configuration, the current scale is preferred.
+**
+*/
+double Demo_HostInputGain()
+{
+    uint8_t rgbCfg[DMM_CFG_CNTREGS + 1];
+    int idxScale = DMM_GetCurrentScale();
+    int i;
+    Demo_HostGetSimCfg(rgbCfg);
+    if(idxScale >= 0 && !memcmp(rgbCfg, rgbHostScaleCfg[idxScale], sizeof(rgbCfg)))
+    {
+        return rgdHostInputGain[idxScale];
+    }
+    for(i = 0; i < DMM_CNTSCALES; i++)
+    {
+        if(!memcmp(rgbCfg, rgbHostScaleCfg[i], sizeof(rgbCfg)))
+        {
+            return rgdHostInputGain[i];
+        }
+    }
+    return (idxScale >= 0) ? rgdHostInputGain[idxScale]: 1;
+}
+
+/***	Demo_HostGetSimCfg()
+**
+**	Parameters:
+**		uint8_t *pbCfg  - buffer receiving the DMM_CFG_CNTREGS configuration registers and the relay pins
+**
+**	Return Value:
+**          none
+**
+**	Description:
+**		This function is only built for host. It retrieves the configuration written in the DMMSIM registers 
+**      (DMM_REG_CFG and the following ones) and the relay pins (RLD bit 0, RLU bit 1, RLI bit 2), used by Demo_HostInputGain.
+**
+*/
+void Demo_HostGetSimCfg(uint8_t *pbCfg)
+{
+    int i;
+    for(i = 0; i < DMM_CFG_CNTREGS; i++)
+    {
+        pbCfg[i] = DMMSIM_GetReg(DMM_REG_CFG + i);
+    }
+    pbCfg[DMM_CFG_CNTREGS] = SPIMOCK_PeekPin(HAL_PIN_RLD) | (SPIMOCK_PeekPin(HAL_PIN_RLU) << 1) | (SPIMOCK_PeekPin(HAL_PIN_RLI) << 2);
+}
+
+/***	Demo_HostBenchmarkFilter()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It measures each DMMFILT filter stage, then a complete chain, on synthetic AD1 codes
+**      of the 5 V DC scale: 1 V, uniform noise of +/- 16 codes and a spike of 4000 codes every 50 codes.
+**      For each chain it prints the host CPU time per code and, from the DMMSTATS statistics of the filtered codes, 
+**      the standard deviation and the maximum deviation from the 1 V code. Then it applies a step of 100000 codes 
+**      (without noise) and prints the output deviation from the step value after 256 codes.
+**      It checks that the chains rejecting the spikes (median, spike) keep the output within the +/- 16 codes noise band, 
+**      that the averaging filters (boxcar, EMA) reduce the standard deviation of the noise, and that all the chains 
+**      settle to the step value. It returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkFilter()
+{
+    const struct {uint8_t rgTypes[3]; uint8_t rgParams[3];} rgChains[] = {
+        {{DMMFILT_NONE}, {0}},
+        {{DMMFILT_BOXCAR}, {8}},
+        {{DMMFILT_EMA}, {3}},
+        {{DMMFILT_MEDIAN}, {5}},
+        {{DMMFILT_SPIKE}, {3}},
+        {{DMMFILT_SPIKE, DMMFILT_MEDIAN, DMMFILT_EMA}, {3, 5, 2}},
+    };
+    const int cntCodes = 4096, cntRepeat = 100;
+    const int64_t codeBase = 1208012;   // 1 V on the 5 V DC scale
+    const int64_t codeStep = 100000;
+    static int64_t rgCodes[4096];
+    char szChain[10 * DMMFILT_MAXSTAGES];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    struct timespec tsStart, tsStop;
+    DMMSAMPLE sample = {0, 0, 8, 0};
+    DMMSTATS stats;
+    double dNs, dStdDevNone = 0, dDevMax;
+    int64_t sum = 0;
+    uint8_t bType;
+    int idxChain, i, j, cntFailed = 0;
+
+    for(i = 0; i < cntCodes; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        rgCodes[i] = codeBase + (int64_t)(seed % 33) - 16 + ((i % 50 == 49) ? 4000: 0);
+    }
+    for(idxChain = 0; idxChain < sizeof(rgChains)/sizeof(rgChains[0]); idxChain++)
+    {
+        DMMFILT_ClearChain();
+        for(i = 0; i < 3 && rgChains[idxChain].rgTypes[i] != DMMFILT_NONE; i++)
+        {
+            DMMFILT_AddStage(rgChains[idxChain].rgTypes[i], rgChains[idxChain].rgParams[i]);
+        }
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+        for(j = 0; j < cntRepeat; j++)
+        {
+            for(i = 0; i < cntCodes; i++)
+            {
+                sample.code = rgCodes[i];
+                DMMFILT_Apply(&sample);
+                sum += sample.code;
+            }
+        }
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+        dNs = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+        // output quality, after the first 64 codes (filters warm up)
+        DMMFILT_Reset();
+        DMMSTATS_Init(&stats, DMMSTATS_POLICY_SKIP);
+        for(i = 0; i < cntCodes; i++)
+        {
+            sample.code = rgCodes[i];
+            DMMFILT_Apply(&sample);
+            if(i >= 64)
+            {
+                DMMSTATS_Add(&stats, (double)(sample.code - codeBase));
+            }
+        }
+        dDevMax = fmax(stats.dMax, -stats.dMin);
+        // step response, without noise: the output after 256 codes of the new value (Ema3 needs about 90 codes to reach 1 code)
+        for(i = 0; i < 256; i++)
+        {
+            sample.code = codeBase + codeStep;
+            DMMFILT_Apply(&sample);
+        }
+        DMMFILT_FormatChain(szChain);
+        printf("DMMFILT %s: %.1f ns/code, output stddev %.2f codes, max deviation %.0f codes, step deviation %lld codes (checksum %lld)\n", 
+            szChain, dNs, DMMSTATS_DGetStdDev(&stats), dDevMax, (long long)(sample.code - codeBase - codeStep), (long long)sum);
+        bType = rgChains[idxChain].rgTypes[0];
+        if(bType == DMMFILT_NONE)
+        {
+            dStdDevNone = DMMSTATS_DGetStdDev(&stats);
+        }
+        else if(bType == DMMFILT_BOXCAR || bType == DMMFILT_EMA)
+        {
+            // the spikes are averaged, not rejected: only the standard deviation is reduced
+            cntFailed += Demo_HostCheck(DMMSTATS_DGetStdDev(&stats) < dStdDevNone / 2, szChain, "stddev reduction");
+        }
+        else
+        {
+            // the 4000 codes spikes are rejected, the output stays within the noise band
+            cntFailed += Demo_HostCheck(dDevMax <= 16, szChain, "spike rejection");
+        }
+        cntFailed += Demo_HostCheck(llabs(sample.code - codeBase - codeStep) <= 1, szChain, "step settling");
+    }
+    DMMFILT_ClearChain();
+    return cntFailed;
+}
+
+/***	Demo_HostBenchmarkMains()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It measures the mains synchronous integration (MAINS module) on the 5 V DC scale:
+**      1 V with a 50 Hz ripple, then with a 60 Hz ripple (12000 codes peak, about 10 mV), then without ripple.
+**      For each input it prints the detected frequency and the detection ratio, then, for the fixed number of samples 
+**      average DMM_DGetAvgValue and for the mains integration over 1 and 5 cycles, the standard deviation 
+**      of the readings (the ripple rejection) and the simulated time per reading.
+**      It checks the error codes, the detected frequency and, with a ripple, that the standard deviation of the 1 cycle 
+**      mains integration is below a quarter of the worst one of the fixed number of samples averages. It returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkMains()
+{
+    const double rgdFrqs[] = {50, 60, 0};
+    const int cntReadings = 20;
+    DMMSIM_CFG cfg;
+    DMMSTATS stats;
+    uint64_t tnsSimStart;
+    uint16_t frq;
+    double dRatio, dVal, dStdDevFixed = 0;
+    uint8_t bErr;
+    int idxFrq, idxMethod, i, cntFailed = 0;
+
+    DMM_SetScale(8);
+    DMMSIM_GetDefaultCfg(&cfg);
+    for(idxFrq = 0; idxFrq < sizeof(rgdFrqs)/sizeof(rgdFrqs[0]); idxFrq++)
+    {
+        cfg.dcCode = 1208012;       // 1 V on the 5 V DC scale
+        cfg.acCode = rgdFrqs[idxFrq] ? 12000: 0;
+        cfg.acFrq = rgdFrqs[idxFrq];
+        cfg.noiseCode = 8;
+        DMMSIM_SetCfg(&cfg);
+        // without DMM_INTF_READCLEAR the last conversion is read: the detection starts one conversion after the input change
+        DelayAprox10Us(cfg.tusConv / 10);
+        frq = 0;
+        dRatio = 0;
+        bErr = MAINS_Detect(&frq, &dRatio);
+        printf("Mains %.0f Hz ripple: err 0x%02X, detected %u Hz, ratio %.1f\n", rgdFrqs[idxFrq], bErr, frq, dRatio);
+        cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS && frq == rgdFrqs[idxFrq], "MAINS_Detect", "frequency");
+        for(idxMethod = 0; idxMethod < 4; idxMethod++)
+        {
+            if(idxMethod >= 2)
+            {
+                MAINS_Start(rgdFrqs[idxFrq] ? rgdFrqs[idxFrq]: MAINS_FRQ_DEFAULT, (idxMethod == 2) ? 1: 5);
+            }
+            DMMSTATS_Init(&stats, DMMSTATS_POLICY_SKIP);
+            tnsSimStart = SPIMOCK_GetTimeNs();
+            for(i = 0; i < cntReadings; i++)
+            {
+                dVal = (idxMethod >= 2) ? MAINS_DGetAvgValue(&bErr): DMM_DGetAvgValue((idxMethod == 0) ? 20: 14, &bErr);
+                DMMSTATS_Add(&stats, dVal);
+            }
+            printf("    %s: err 0x%02X, stddev %.3e V, simulated %.2f ms/reading\n", 
+                (idxMethod == 0) ? "DMM_DGetAvgValue 20 samples": (idxMethod == 1) ? "DMM_DGetAvgValue 14 samples": 
+                (idxMethod == 2) ? "MAINS 1 cycle": "MAINS 5 cycles", bErr, DMMSTATS_DGetStdDev(&stats), 
+                (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6 / cntReadings);
+            cntFailed += Demo_HostCheck(bErr == ERRVAL_SUCCESS, "Mains", "error");
+            if(idxMethod < 2)
+            {
+                // a fixed number of samples may span a whole mains cycle by chance, keep the worst of the two averages
+                dStdDevFixed = (idxMethod == 0 || DMMSTATS_DGetStdDev(&stats) > dStdDevFixed) ? DMMSTATS_DGetStdDev(&stats): dStdDevFixed;
+            }
+            else if(idxMethod == 2 && rgdFrqs[idxFrq])
+            {
+                cntFailed += Demo_HostCheck(DMMSTATS_DGetStdDev(&stats) < dStdDevFixed / 4, "MAINS 1 cycle", "ripple rejection");
+            }
+        }
+        MAINS_Stop();
+    }
+    DMMSIM_GetDefaultCfg(&cfg);
+    DMMSIM_SetCfg(&cfg);
+    return cntFailed;
+}
+
+/***	Demo_HostBenchmarkUart()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It sends a measurement line at 9600 baud, first using the polled transmit 
+**      (HAL_UartPutChar and a 100 us delay per character, like UART_PutString before the transmit ring), 
+**      then using UART_PutString at 9600, 115200 and 230400 baud (see UART_SetBaud), and prints the simulated time 
+**      the caller is blocked and the time until the line is sent.
+**      Then it queues 20 lines back to back using the UART_TX_DROP policy and prints the number of lines queued and dropped.
+**      The sent lines appear in the output.
+**      Finally it checks the baud rate confirmation (see UART_CheckBaudTimeout): a baud rate followed by a received line 
+**      is kept after UART_BAUD_TIMEOUT_MS, a baud rate without received line is reverted to the UART_Init one.
+**      It returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkUart()
+{
+    const uint32_t rgBauds[] = {9600, 115200, 230400};
+    char szLine[] = "UART benchmark line, Value: 1.000000 V\r\n";
+    uint64_t tnsSimStart;
+    double dMsBlocked;
+    uint32_t cntDropped;
+    int cntQueued = 0, i;
+    uint8_t fConfirmedKept, fUnconfirmedReverted;
+
+    UART_Init(9600);
+    tnsSimStart = SPIMOCK_GetTimeNs();
+    for(i = 0; szLine[i]; i++)
+    {
+        HAL_UartPutChar(szLine[i]);
+        DelayAprox10Us(10);
+    }
+    dMsBlocked = (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6;
+    printf("UART polled %d chars: simulated %.2f ms blocked\n", (int)strlen(szLine), dMsBlocked);
+    for(i = 0; i < sizeof(rgBauds)/sizeof(rgBauds[0]); i++)
+    {
+        DelayAprox10Us(100);
+        UART_SetBaud(rgBauds[i]);
+        tnsSimStart = SPIMOCK_GetTimeNs();
+        UART_PutString(szLine);
+        dMsBlocked = (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6;
+        UART_TxFlush();
+        printf("UART_PutString %d chars, %u baud (actual %u): simulated %.3f ms blocked, %.2f ms to pass the line to the UART\n", 
+            (int)strlen(szLine), rgBauds[i], UART_GetBaudDivisor(rgBauds[i], NULL, NULL), dMsBlocked, (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6);
+    }
+    UART_SetBaud(9600);
+    DelayAprox10Us(100);
+    cntDropped = UART_GetTxDropped();
+    tnsSimStart = SPIMOCK_GetTimeNs();
+    for(i = 0; i < 20; i++)
+    {
+        cntQueued += UART_TxQueue(szLine, strlen(szLine), UART_TX_DROP);
+    }
+    dMsBlocked = (SPIMOCK_GetTimeNs() - tnsSimStart) / 1e6;
+    UART_TxFlush();
+    printf("UART_TxQueue drop policy, 20 lines: %d queued, %u chars dropped, simulated %.3f ms blocked\n", 
+        cntQueued, UART_GetTxDropped() - cntDropped, dMsBlocked);
+    // baud rate confirmation
+    UART_SetBaud(115200);
+    DelayAprox10Us(100000);
+    HALHOST_InjectRx("DMMUartStats\r\n");
+    if(UART_GetLine())
+    {
+        UART_ReleaseLine();
+    }
+    for(i = 0; i < UART_BAUD_TIMEOUT_MS / 100 + 10; i++)
+    {
+        DelayAprox10Us(10000);
+    }
+    fConfirmedKept = !UART_CheckBaudTimeout() && UART_GetBaud() == 115200;
+    UART_SetBaud(230400);
+    for(i = 0; i < UART_BAUD_TIMEOUT_MS / 100 + 10; i++)
+    {
+        DelayAprox10Us(10000);
+    }
+    fUnconfirmedReverted = UART_CheckBaudTimeout() && UART_GetBaud() == 9600;
+    printf("UART baud confirmation: confirmed 115200 kept %s, unconfirmed 230400 reverted to 9600 %s\n", 
+        fConfirmedKept ? "ok": "FAILED", fUnconfirmedReverted ? "ok": "FAILED");
+    return Demo_HostCheck(fConfirmedKept, "UART baud", "confirmed kept") + Demo_HostCheck(fUnconfirmedReverted, "UART baud", "unconfirmed reverted");
+}
+
+/***	Demo_HostBenchmarkStream()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It compares the formats of the repeated session values (see DMMCMD_CmdStream) 
+**      on synthetic AD1 codes of the 5 V DC scale, covering the convertor range: the text line built by DMM_DSampleToValue, 
+**      DMM_FormatValue and sprintf, the DMMBIN frame of the fixed point value and the DMMBIN frame of the raw code.
+**      For each format it prints the host CPU time per value, the average bytes per value and the values per second
+**      that fit in a 115200 baud link.
+**      Then it decodes the frames using DMMBIN_DecodeFrame, checks the sequence numbers, the codes and the values, 
+**      and checks that a corrupted byte is detected.
+**      It returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkStream()
+{
+    const char rgszFormats[][8] = {"Text", "Value", "Code"};
+    const int cntCodes = 4096, cntRepeat = 20;
+    static int64_t rgCodes[4096];
+    uint8_t rgFrame[DMMBIN_MAXFRAME];
+    char szVal[20], szLine[40];
+    struct timespec tsStart, tsStop;
+    DMMSAMPLE sample = {0, 0, 8, 0};
+    DMMBINPKT pkt;
+    DMMFIX fix;
+    double dNs, dVal;
+    int64_t cbTotal;
+    int idxFormat, i, j, cb, cntErrors = 0;
+    uint8_t bErr;
+
+    DMM_SetScale(8);
+    DMM_FixPrepare(&fix);
+    for(i = 0; i < cntCodes; i++)
+    {
+        rgCodes[i] = -0x7FFFF0 + (int64_t)i * 0xFFFFE0 / (cntCodes - 1);
+    }
+    for(idxFormat = 0; idxFormat < sizeof(rgszFormats)/sizeof(rgszFormats[0]); idxFormat++)
+    {
+        cbTotal = 0;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+        for(j = 0; j < cntRepeat; j++)
+        {
+            for(i = 0; i < cntCodes; i++)
+            {
+                sample.code = rgCodes[i];
+                switch(idxFormat)
+                {
+                    case 0:
+                        dVal = DMM_DSampleToValue(&sample, &bErr);
+                        DMM_FormatValue(dVal, szVal, 1);
+                        sprintf(szLine, "Value: %s\r\n", szVal);
+                        cb = strlen(szLine);
+                        break;
+                    case 1:
+                        cb = DMMBIN_EncodePacket(rgFrame, DMMBIN_PKT_VALUE, sample.idxScale, fix.exp, DMM_FixCodeToValue(&fix, sample.code));
+                        break;
+                    default:
+                        cb = DMMBIN_EncodePacket(rgFrame, DMMBIN_PKT_CODE, sample.idxScale, 0, sample.code);
+                        break;
+                }
+                cbTotal += cb;
+            }
+        }
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+        dNs = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+        printf("Stream %s: %.1f ns/value, %.2f bytes/value, %.0f values/s at 115200 baud\n", rgszFormats[idxFormat], 
+            dNs, (double)cbTotal / cntRepeat / cntCodes, 11520.0 * cntRepeat * cntCodes / cbTotal);
+    }
+    // round trip
+    DMMBIN_Reset();
+    for(i = 0; i < cntCodes; i++)
+    {
+        cb = DMMBIN_EncodePacket(rgFrame, (i & 1) ? DMMBIN_PKT_CODE: DMMBIN_PKT_VALUE, 8, fix.exp, 
+                                 (i & 1) ? rgCodes[i]: DMM_FixCodeToValue(&fix, rgCodes[i]));
+        if(DMMBIN_DecodeFrame(rgFrame, cb, &pkt) != ERRVAL_SUCCESS || pkt.bSeq != (uint8_t)i || pkt.idxScale != 8 
+            || pkt.val != ((i & 1) ? rgCodes[i]: DMM_FixCodeToValue(&fix, rgCodes[i])))
+        {
+            cntErrors++;
+        }
+        rgFrame[i % (cb - 1)] ^= 1 << (i % 8);
+        if(DMMBIN_DecodeFrame(rgFrame, cb, &pkt) == ERRVAL_SUCCESS)
+        {
+            cntErrors++;
+        }
+    }
+    printf("Stream round trip, %d frames: %d errors (including the undetected corrupted frames)\n", cntCodes, cntErrors);
+    return Demo_HostCheck(cntErrors == 0, "Stream", "round trip");
+}
+
+/***	Demo_HostBenchmarkConversion()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It compares the double precision conversion DMM_CodesToValues 
+**      with the fixed point conversion DMM_FixCodesToValues, on codes covering the whole convertor range, 
+**      without and with calibration coefficients. 
+**      For each scale it prints the host CPU time per sample of both paths and the maximum difference: 
+**      in AD1 code LSB for DC scales, relative to the value for AC scales.
+**      It checks the difference against the tolerance documented for DMM_FixCodesToValues and returns the number of failed checks.
+**      The calibration coefficients are changed, they must be loaded again afterwards (CALIB_Init).
+**
+*/
+int Demo_HostBenchmarkConversion()
+{
+    // tolerance: 0.005 LSB for DC scales, 0.02 LSB for VoltageDC50, 2e-5 relative for AC scales, see DMM_FixCodesToValues
+    const struct {int idxScale; const char *szName; double dTol;} rgBench[] = {
+        {8, "5 V DC", 0.005}, {7, "50 V DC", 0.02}, {0, "50 MOhm", 0.005}, {12, "5 V AC", 2e-5}, {26, "500 uA AC", 2e-5}
+    };
+    const int cntCodes = 4096, cntRepeat = 100;
+    static int64_t rgCodes[4096], rgFixVals[4096];
+    static double rgdVals[4096];
+    int64_t rgLsbCodes[2] = {0, 1};
+    double rgdLsb[2], dErr, dMaxErr, dNsDouble, dNsFix;
+    struct timespec tsStart, tsStop;
+    int idxBench, fCalib, i, j, cntFailed = 0;
+    int8_t exp;
+    DMMFIX fix;
+
+    printf("Conversion, %d codes\n", cntCodes);
+    for(idxBench = 0; idxBench < sizeof(rgBench)/sizeof(rgBench[0]); idxBench++)
+    {
+        DMM_SetScale(rgBench[idxBench].idxScale);
+        DMM_FixPrepare(&fix);
+        for(i = 0; i < cntCodes; i++)
+        {
+            if(fix.fAC)
+            {
+                // RMS register, up to 40 bits
+                rgCodes[i] = (int64_t)(1099511627775.0 * ((double)i / cntCodes) * ((double)i / cntCodes));
+            }
+            else
+            {
+                // AD1, including the values outside the convertor range
+                rgCodes[i] = -0x800000 + (int64_t)i * 0xFFFFFF / (cntCodes - 1);
+            }
+        }
+        for(fCalib = 0; fCalib < 2; fCalib++)
+        {
+            CALIB_ImportCalibCoefficients(rgBench[idxBench].idxScale, fCalib ? 1.5e-3: 0, fCalib ? DMM_GetScaleRange(rgBench[idxBench].idxScale) * 2e-4: 0);
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+            for(j = 0; j < cntRepeat; j++)
+            {
+                DMM_CodesToValues(rgCodes, rgdVals, cntCodes);
+            }
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+            dNsDouble = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+            for(j = 0; j < cntRepeat; j++)
+            {
+                DMM_FixCodesToValues(rgCodes, rgFixVals, cntCodes, &exp);
+            }
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+            dNsFix = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+            DMM_CodesToValues(rgLsbCodes, rgdLsb, 2);
+            dMaxErr = 0;
+            for(i = 0; i < cntCodes; i++)
+            {
+                if(rgFixVals[i] == DMM_FIX_INFINITY || rgFixVals[i] == -DMM_FIX_INFINITY)
+                {
+                    // the double VoltageDC50 compensation can change the sign of the overrange values
+                    dErr = (fabs(rgdVals[i]) >= INFINITY) ? 0: INFINITY;
+                }
+                else if(fix.fAC)
+                {
+                    dErr = (rgdVals[i] > 0) ? fabs(rgFixVals[i] * pow(10, -exp) - rgdVals[i]) / rgdVals[i]: 0;
+                }
+                else
+                {
+                    dErr = fabs(rgFixVals[i] * pow(10, -exp) - rgdVals[i]) / fabs(rgdLsb[1] - rgdLsb[0]);
+                }
+                if(dErr > dMaxErr)
+                {
+                    dMaxErr = dErr;
+                }
+            }
+            printf("%s %s: double %.1f ns/sample, fixed point %.1f ns/sample, exp %d, max difference %.3g %s\n", 
+                rgBench[idxBench].szName, fCalib ? "calibrated": "not calibrated", dNsDouble, dNsFix, exp, 
+                dMaxErr, fix.fAC ? "relative": "LSB");
+            cntFailed += Demo_HostCheck(dMaxErr <= rgBench[idxBench].dTol, rgBench[idxBench].szName, "fixed point difference");
+        }
+    }
+    return cntFailed;
+}
+
+/***	Demo_HostBenchmarkISqrt()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          int     - the number of failed checks, 0 if all the checks passed
+**
+**	Description:
+**		This function is only built for host. It checks the integer square root DMM_ISqrt64 against the libm square root 
+**      (corrected to the exact integer square root) on values covering the whole 40 bits RMS register range: 
+**      pseudo random values of each bit length, the perfect squares and their neighbors, the same values shifted to Q22 
+**      (as used by the AC conversion) and the 64 bits limits. 
+**      It prints the number of mismatches, the maximum relative difference of the Q11 RMS square root (DMM_RmsSqrtQ11, 
+**      through DMM_CodesToValues on the 5 V AC scale without calibration) compared to the double sqrt 
+**      and the host CPU time per call of the integer square root, of the FPU double sqrt and of Demo_HostSoftSqrt. 
+**      The host has a FPU, while on PIC32MX the double sqrt is a software routine: the FPU time does not show the PIC32 cost, 
+**      the integer square root is compared to the software double square root (both only use integer operations).
+**      It checks the mismatches, the relative difference documented for DMM_RmsSqrtQ11 and that the software double square root 
+**      matches the FPU one, and returns the number of failed checks.
+**
+*/
+int Demo_HostBenchmarkISqrt()
+{
+    const int cntCodes = 4096, cntRepeat = 100;
+    static int64_t rgCodes[4096];
+    static double rgdVals[4096];
+    uint64_t rgEdges[] = {0, 1, 2, 3, 4, 0xFFFFFFFFFFULL, 0xFFFFFFFFFFULL << 22, 0xFFFFFFFFFFFFFFFFULL, 
+        0xFFFFFFFE00000001ULL, 0xFFFFFFFE00000000ULL, 0x4000000000000000ULL, 0x3FFFFFFFFFFFFFFFULL};
+    uint64_t x, ref, seed = 0x9E3779B97F4A7C15ULL;
+    uint32_t sum = 0;
+    uint32_t cntChecks = 0, cntMismatches = 0, cntSoftMismatches = 0;
+    double dSum = 0, dSoftSum = 0, dErr, dMaxErr = 0, dMaxErrLow = 0, dNsInt, dNsDouble, dNsSoft;
+    struct timespec tsStart, tsStop;
+    int i, j, k, bits;
+
+    for(i = 0; i < 3 * 41 * 4096 + sizeof(rgEdges)/sizeof(rgEdges[0]); i++)
+    {
+        if(i < 3 * 41 * 4096)
+        {
+            // xorshift pseudo random value of "bits" length
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            bits = (i / 3 / 4096);
+            x = bits ? (seed >> (64 - bits)): 0;
+            if(i % 3 == 1)
+            {
+                // perfect square or neighbor
+                ref = DMM_ISqrt64(x);
+                x = ref * ref + (seed & 1) - ((seed >> 1) & 1);
+            }
+            if(i % 3 == 2)
+            {
+                x <<= 22;
+            }
+        }
+        else
+        {
+            x = rgEdges[i - 3 * 41 * 4096];
+        }
+        ref = (uint64_t)sqrt((double)x);
+        if(ref > 0xFFFFFFFFULL)
+        {
+            ref = 0xFFFFFFFFULL;
+        }
+        while(ref * ref > x)
+        {
+            ref--;
+        }
+        while(ref < 0xFFFFFFFFULL && (ref + 1) * (ref + 1) <= x)
+        {
+            ref++;
+        }
+        cntChecks++;
+        if(DMM_ISqrt64(x) != ref)
+        {
+            if(cntMismatches++ < 4)
+            {
+                printf("DMM_ISqrt64 mismatch: x 0x%016llX, result %u, expected %llu\n", (unsigned long long)x, DMM_ISqrt64(x), (unsigned long long)ref);
+            }
+        }
+    }
+
+    // Q11 RMS square root, compared to the double sqrt
+    DMM_SetScale(12);
+    CALIB_ImportCalibCoefficients(12, 0, 0);
+    for(i = 0; i < cntCodes; i++)
+    {
+        // the first codes cover the small values
+        rgCodes[i] = (i < 64) ? i: (int64_t)(1099511627775.0 * ((double)i / cntCodes) * ((double)i / cntCodes));
+    }
+    DMM_CodesToValues(rgCodes, rgdVals, cntCodes);
+    for(i = 0; i < cntCodes; i++)
+    {
+        cntSoftMismatches += (Demo_HostSoftSqrt((double)rgCodes[i]) != sqrt((double)rgCodes[i]));
+    }
+    for(i = 1; i < cntCodes; i++)
+    {
+        dErr = fabs(rgdVals[i] - sqrt((double)rgCodes[i]) * 1e-4) / rgdVals[i];
+        if(rgCodes[i] >= 0x10000)
+        {
+            dMaxErr = (dErr > dMaxErr) ? dErr: dMaxErr;
+        }
+        else
+        {
+            dMaxErrLow = (dErr > dMaxErrLow) ? dErr: dMaxErrLow;
+        }
+    }
+
+    // throughput, the codes are shifted to Q22 as in the AC conversion
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+    for(j = 0; j < cntRepeat; j++)
+    {
+        for(k = 0; k < cntCodes; k++)
+        {
+            sum += DMM_ISqrt64((uint64_t)rgCodes[k] << 22);
+        }
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+    dNsInt = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+    for(j = 0; j < cntRepeat; j++)
+    {
+        for(k = 0; k < cntCodes; k++)
+        {
+            dSum += sqrt((double)rgCodes[k]);
+        }
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+    dNsDouble = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStart);
+    for(j = 0; j < cntRepeat; j++)
+    {
+        for(k = 0; k < cntCodes; k++)
+        {
+            dSoftSum += Demo_HostSoftSqrt((double)rgCodes[k]);
+        }
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tsStop);
+    dNsSoft = ((tsStop.tv_sec - tsStart.tv_sec) * 1e9 + (tsStop.tv_nsec - tsStart.tv_nsec)) / cntRepeat / cntCodes;
+    printf("DMM_ISqrt64: %u values, %u mismatches, Q11 RMS sqrt max relative difference %.3g (%.3g below 0x10000), "
+        "integer %.1f ns/call, software double sqrt %.1f ns/call, FPU double sqrt %.1f ns/call (checksum %u %.0f %.0f)\n", 
+        cntChecks, cntMismatches, dMaxErr, dMaxErrLow, dNsInt, dNsSoft, dNsDouble, sum, dSoftSum, dSum);
+    return Demo_HostCheck(cntMismatches == 0, "DMM_ISqrt64", "mismatches") + 
+        Demo_HostCheck(dMaxErr < 1e-8 && dMaxErrLow < 2e-4, "DMM_RmsSqrtQ11", "relative difference") + 
+        Demo_HostCheck(cntSoftMismatches == 0, "Demo_HostSoftSqrt", "mismatches");
+}
+
+/***	Demo_HostSoftSqrt()
+**
+**	Parameters:
+**		double d    - the value, positive or 0
+**
+**	Return Value:
+**          double  - the correctly rounded square root of d
+**
+**	Description:
+**		This function is only built for host. It computes the double square root using only integer operations, 
+**      as the soft-float libraries do on a core without FPU: the bit by bit square root of the mantissa 
+**      (one result bit per iteration, 53 bits and the rounding bit), as in the fdlibm / newlib __ieee754_sqrt. 
+**      It is the reference for the cost of the double sqrt on PIC32MX in Demo_HostBenchmarkISqrt. 
+**      The negative, subnormal, infinite and NaN values are not handled (the RMS codes are positive integers).
+**
+*/
+double Demo_HostSoftSqrt(double d)
+{
+    uint64_t u, m, q = 0, s = 0, r, t;
+    int e;
+    memcpy(&u, &d, sizeof(u));
+    if(!(u << 1))
+    {
+        return d;
+    }
+    e = (int)(u >> 52) - 1023;
+    m = (u & ((1ULL << 52) - 1)) | (1ULL << 52);
+    if(e & 1)
+    {
+        // odd exponent, the mantissa is doubled
+        m += m;
+        e--;
+    }
+    m += m;
+    for(r = 1ULL << 53; r; r >>= 1)
+    {
+        t = s + r;
+        if(t <= m)
+        {
+            s = t + r;
+            m -= t;
+            q += r;
+        }
+        m += m;
+    }
+    if(m)
+    {
+        // round to nearest, the remainder is never 0 with the rounding bit set (no tie)
+        q += q & 1;
+    }
+    u = ((uint64_t)(e / 2 + 1022) << 52) + (q >> 1);
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+#endif
+
 /* *****************************************************************************
  End of File
  */
\ No newline at end of file
@@ -0,0 +1,369 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    mains.c
+
+  @Description
+        This file groups the functions that implement the MAINS module (mains synchronous integration).
+        The line frequency ripple picked up by the DC readings is rejected by averaging over an integer number of mains cycles:
+        the integral of the ripple over whole cycles is zero, whatever its phase.
+        The average is integrated over the conversions rather than over a number of samples: the values are read every cntStep
+        conversion periods (DMM_CONV_TUS), cntStep being the smallest number of periods longer than a read (which depends on
+        the scale, the SPI transport and the polling mode), so that the reads sample the conversions at the same phase and 
+        each value stands for a known time. The values are integrated by trapezoids and the last one is interpolated at the end 
+        of the window, so that the window is exactly cntCycles mains periods, which is not a multiple of the conversion period in general.
+        Weighting the values by their read timestamps instead does not reject the ripple, as a read may return a conversion 
+        up to one period older than its timestamp.
+        The mains frequency, 50 Hz or 60 Hz, can be detected from the values: their ripple is correlated with both frequencies over
+        MAINS_DETECT_MS, an integer number of cycles of both, so that each frequency does not leak into the other one.
+        The timestamps are used for the correlation (instead of a Goertzel filter), as the values are not evenly spaced.
+        The frequency having the largest power is selected when it exceeds MAINS_DETECT_RATIO times the power of the other frequency
+        plus the power expected from the noise of the values, otherwise MAINS_FRQ_DEFAULT is used.
+        The AC scales values are RMS values, which show no mains ripple: on these scales the detection is not performed.
+        The converter data rate is not changed, the integration time only depends on the number of cycles.
+        DMM_CONV_TUS must match the conversion period set by DMM_SetScale.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, mains synchronous integration
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <math.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "mains.h"
+#include "hal.h"
+#include "errors.h"
+#include "utils.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t DMM_FACScale(int idxScale);
+uint8_t DMM_ERR_CheckIdxCalib(int idxScale);
+uint8_t DMM_IsNotANumber(double dVal);
+uint8_t DMM_FGetCode(uint8_t fAC, int64_t *pCode);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Data, local to this module                                 */
+/* ************************************************************************** */
+/* ************************************************************************** */
+MAINSSTATE mainsState = {0, 0, MAINS_FRQ_DEFAULT, 1, 0, 0.0};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	MAINS_Start
+**
+**	Parameters:
+**      uint16_t frq        - the mains frequency: MAINS_FRQ_50, MAINS_FRQ_60 or MAINS_FRQ_AUTO to detect it using MAINS_Detect
+**      uint8_t cntCycles   - the number of mains cycles integrated by MAINS_DGetAvgValue, 1 to MAINS_MAXCYCLES
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_MAINS_PARAM          0xE9    // wrong mains frequency or number of cycles
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout, during the detection
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index, during the detection
+**
+**	Description:
+**		This function activates the mains synchronous integration: MAINS_DGetAvgValue integrates the values over cntCycles mains periods.
+**      For MAINS_FRQ_AUTO, the frequency is detected on the current scale, which must be a DC scale.
+**      If no ripple is detected (or the current scale is an AC scale), MAINS_FRQ_DEFAULT is used.
+**      The frequency is kept when the scale changes, as it is a property of the power line.
+**
+*/
+uint8_t MAINS_Start(uint16_t frq, uint8_t cntCycles)
+{
+    uint8_t bErr = ERRVAL_SUCCESS;
+    uint16_t frqDetected = 0;
+    double dRatio = 0.0;
+    if((frq != MAINS_FRQ_AUTO && frq != MAINS_FRQ_50 && frq != MAINS_FRQ_60) || cntCycles < 1 || cntCycles > MAINS_MAXCYCLES)
+    {
+        return ERRVAL_MAINS_PARAM;
+    }
+    if(frq == MAINS_FRQ_AUTO)
+    {
+        bErr = MAINS_Detect(&frqDetected, &dRatio);
+        if(bErr != ERRVAL_SUCCESS)
+        {
+            return bErr;
+        }
+    }
+    mainsState.fDetected = (frqDetected != 0);
+    mainsState.frq = (frq != MAINS_FRQ_AUTO) ? frq: (frqDetected ? frqDetected: MAINS_FRQ_DEFAULT);
+    mainsState.dRatio = dRatio;
+    mainsState.cntCycles = cntCycles;
+    mainsState.tusWindow = (uint32_t)(1000000ULL * cntCycles / mainsState.frq);
+    mainsState.fActive = 1;
+    return ERRVAL_SUCCESS;
+}
+
+/***	MAINS_Stop
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function deactivates the mains synchronous integration.
+**
+*/
+void MAINS_Stop()
+{
+    mainsState.fActive = 0;
+}
+
+/***	MAINS_FActive
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		uint8_t     - 1 if the mains synchronous integration is active, 0 otherwise
+**
+**	Description:
+**		This function returns the mains synchronous integration state.
+**
+*/
+uint8_t MAINS_FActive()
+{
+    return mainsState.fActive;
+}
+
+/***	MAINS_Detect
+**
+**	Parameters:
+**      uint16_t *pFrq      - pointer to the variable receiving the detected frequency, MAINS_FRQ_50 or MAINS_FRQ_60,
+**                            or 0 if no ripple was detected
+**      double *pdRatio     - pointer to the variable receiving the ratio between the power of the detected frequency
+**                            and the power of the other frequency plus the noise, can be NULL
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**
+**	Description:
+**		This function reads the values of the current scale during MAINS_DETECT_MS and correlates them (after the mean is removed)
+**      with 50 Hz and 60 Hz, each value being weighted by the time elapsed since the previous one.
+**      The expected power of the noise is the variance of the values multiplied by the sum of the squared weights.
+**      A frequency is detected when its power exceeds MAINS_DETECT_RATIO times the power of the other frequency plus the noise.
+**      No detection is performed on AC scales (their RMS values show no mains ripple), *pFrq being set to 0.
+**      The values outside the convertor range are skipped.
+**
+*/
+uint8_t MAINS_Detect(uint16_t *pFrq, double *pdRatio)
+{
+    const uint16_t rgFrqs[2] = {MAINS_FRQ_50, MAINS_FRQ_60};
+    double rgdCorrC[2] = {0, 0}, rgdCorrS[2] = {0, 0}, rgdWndC[2] = {0, 0}, rgdWndS[2] = {0, 0}, rgdPow[2];
+    double dSumW = 0, dSumWV = 0, dSumWVV = 0, dSumWW = 0;
+    double dVal, dW, dT, dMean, dNoise, dRatio = 0.0;
+    uint32_t tStart, tPrev, t;
+    uint8_t bErr = DMM_ERR_CheckIdxCalib(DMM_GetCurrentScale());
+    int i, idxMax;
+    *pFrq = 0;
+    if(bErr != ERRVAL_SUCCESS || DMM_FACScale(DMM_GetCurrentScale()))
+    {
+        return bErr;
+    }
+    DMM_DGetValue(&bErr);   // the first value starts the detection
+    tStart = tPrev = HAL_GetTicks();
+    while(bErr == ERRVAL_SUCCESS && (tPrev - tStart) < (uint32_t)MAINS_DETECT_MS * (HAL_TICKS_FRQ / 1000))
+    {
+        dVal = DMM_DGetValue(&bErr);
+        t = HAL_GetTicks();
+        if(bErr != ERRVAL_SUCCESS || DMM_IsNotANumber(dVal) || dVal == INFINITY || dVal == -INFINITY)
+        {
+            continue;
+        }
+        dW = (double)(t - tPrev) / HAL_TICKS_FRQ;
+        dT = (double)(t - tStart) / HAL_TICKS_FRQ;
+        tPrev = t;
+        dSumW += dW;
+        dSumWV += dW * dVal;
+        dSumWVV += dW * dVal * dVal;
+        dSumWW += dW * dW;
+        for(i = 0; i < 2; i++)
+        {
+            rgdCorrC[i] += dW * dVal * cos(2 * M_PI * rgFrqs[i] * dT);
+            rgdCorrS[i] += dW * dVal * sin(2 * M_PI * rgFrqs[i] * dT);
+            rgdWndC[i] += dW * cos(2 * M_PI * rgFrqs[i] * dT);
+            rgdWndS[i] += dW * sin(2 * M_PI * rgFrqs[i] * dT);
+        }
+    }
+    if(bErr != ERRVAL_SUCCESS || dSumW <= 0)
+    {
+        return bErr;
+    }
+    // remove the mean: sum(w * (v - mean) * cos) = sum(w * v * cos) - mean * sum(w * cos)
+    dMean = dSumWV / dSumW;
+    for(i = 0; i < 2; i++)
+    {
+        rgdCorrC[i] -= dMean * rgdWndC[i];
+        rgdCorrS[i] -= dMean * rgdWndS[i];
+        rgdPow[i] = rgdCorrC[i] * rgdCorrC[i] + rgdCorrS[i] * rgdCorrS[i];
+    }
+    dNoise = (dSumWVV / dSumW - dMean * dMean) * dSumWW;
+    idxMax = (rgdPow[1] > rgdPow[0]) ? 1: 0;
+    if(rgdPow[1 - idxMax] + dNoise > 0)
+    {
+        dRatio = rgdPow[idxMax] / (rgdPow[1 - idxMax] + dNoise);
+    }
+    if(dRatio >= MAINS_DETECT_RATIO)
+    {
+        *pFrq = rgFrqs[idxMax];
+    }
+    if(pdRatio)
+    {
+        *pdRatio = dRatio;
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	MAINS_DGetAvgValue
+**
+**	Parameters:
+**      uint8_t *pbErr    - Pointer to the error parameter, the error can be set to:
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**
+**	Return Value:
+**		double
+**          the DMM value averaged over the mains cycles, or
+**          +/- INFINITY if a value is outside the expected convertor range, or
+**          NAN (not a number) value if errors were detected
+**
+**	Description:
+**		This function integrates the values over exactly cntCycles mains periods (see MAINS_Start).
+**      The duration of the first read sets cntStep, then a value is read every cntStep conversion periods (DMM_CONV_TUS) 
+**      from the start of the first read, waiting with DelayAprox10Us, so that all the reads return conversions of the same phase. 
+**      The values are integrated by trapezoids of cntStep periods, the last value being interpolated at the end of the window.
+**      Like DMM_DGetAvgValue, it returns the arithmetic mean for all but AC scales and the RMS (quadratic mean) for AC scales,
+**      and it stops at the first value outside the convertor range, which is returned.
+**      The error is copied on the byte pointed by pbErr, if pbErr is not null.
+**
+*/
+double MAINS_DGetAvgValue(uint8_t *pbErr)
+{
+    const uint32_t tPeriod = (uint32_t)((uint64_t)DMM_CONV_TUS * HAL_TICKS_FRQ / 1000000);
+    double dWindow = 1e6 * mainsState.cntCycles / mainsState.frq / DMM_CONV_TUS;    // the window, in conversion periods
+    uint8_t fAC = DMM_FACScale(DMM_GetCurrentScale());
+    uint8_t bErr = DMM_ERR_CheckIdxCalib(DMM_GetCurrentScale());
+    uint32_t tStart = 0, tRead = 0, cntStep = 1, cntTimeout = 0, j;
+    int64_t code = 0;
+    double dVal = NAN, dPrev, dPos = 0.0, dSum = 0.0;
+    // 1. the first value, the duration of its read sets the pace of the reads
+    while(bErr == ERRVAL_SUCCESS)
+    {
+        tStart = HAL_GetTicks();
+        if(DMM_FGetCode(fAC, &code))
+        {
+            tRead = HAL_GetTicks() - tStart;
+            cntStep = (tRead + HAL_TICKS_FRQ / 100000) / tPeriod + 1;
+            DMM_CodesToValues(&code, &dVal, 1);
+            break;
+        }
+        if(++cntTimeout >= DMM_VALIDDATA_CNTTIMEOUT)
+        {
+            bErr = ERRVAL_DMM_VALIDDATATIMEOUT;
+        }
+    }
+    dPrev = fAC ? dVal * dVal: dVal;
+    // 2. a value each cntStep conversion periods, the reads start at the same phase of the conversions
+    for(j = 1; bErr == ERRVAL_SUCCESS && dVal != INFINITY && dVal != -INFINITY; j++)
+    {
+        while((int32_t)(HAL_GetTicks() - (tStart + j * cntStep * tPeriod)) < 0)
+        {
+            DelayAprox10Us(1);
+        }
+        cntTimeout = 0;
+        while(!DMM_FGetCode(fAC, &code))
+        {
+            if(++cntTimeout >= DMM_VALIDDATA_CNTTIMEOUT)
+            {
+                bErr = ERRVAL_DMM_VALIDDATATIMEOUT;
+                break;
+            }
+        }
+        if(bErr != ERRVAL_SUCCESS)
+        {
+            break;
+        }
+        DMM_CodesToValues(&code, &dVal, 1);
+        if(dVal == INFINITY || dVal == -INFINITY)
+        {
+            break;
+        }
+        if(fAC)
+        {
+            dVal *= dVal;
+        }
+        if(dPos + cntStep >= dWindow)
+        {
+            // the window ends in this step: trapezoid up to the value interpolated at the end
+            dVal = dPrev + (dVal - dPrev) * (dWindow - dPos) / cntStep;
+            dSum += (dPrev + dVal) / 2 * (dWindow - dPos);
+            dVal = dSum / dWindow;
+            dVal = fAC ? sqrt(dVal): dVal;
+            break;
+        }
+        dSum += (dPrev + dVal) / 2 * cntStep;
+        dPos += cntStep;
+        dPrev = dVal;
+    }
+    if(bErr != ERRVAL_SUCCESS)
+    {
+        dVal = NAN;
+    }
+    if(pbErr)
+    {
+        *pbErr = bErr;
+    }
+    return dVal;
+}
+
+/***	MAINS_GetState
+**
+**	Parameters:
+**      MAINSSTATE *pState      - pointer to the structure receiving the state
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function copies the mains synchronization state: active flag, frequency, detection result and integration window.
+**
+*/
+void MAINS_GetState(MAINSSTATE *pState)
+{
+    *pState = mainsState;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,71 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    mains.h
+
+  @Description
+        This file contains the declaration for the functions of the MAINS module (mains synchronous integration).
+        The MAINS functions are defined in mains.c source file.
+
+  @Versioning:
+ 	 2026/10/17 - Initial release, mains synchronous integration
+
+ */
+/* ************************************************************************** */
+
+#ifndef _MAINS_H    /* Guard against multiple inclusion */
+#define _MAINS_H
+
+#include "stdint.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define MAINS_FRQ_AUTO          0       // detect the mains frequency, see MAINS_Start
+#define MAINS_FRQ_50            50
+#define MAINS_FRQ_60            60
+#ifndef MAINS_FRQ_DEFAULT
+#define MAINS_FRQ_DEFAULT       50      // used when the detection finds no mains ripple
+#endif
+#define MAINS_MAXCYCLES         50      // maximum number of integrated mains cycles
+#define MAINS_DETECT_MS         200     // detection duration, an integer number of cycles of both 50 Hz and 60 Hz
+#define MAINS_DETECT_RATIO      4       // the ripple power at the detected frequency exceeds the other one at least this number of times
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// mains synchronization state, see MAINS_GetState
+typedef struct _MAINSSTATE{
+    uint8_t fActive;            // the averages are integrated over mains cycles
+    uint8_t fDetected;          // the frequency was detected from the samples, otherwise it was provided or defaulted
+    uint16_t frq;               // the mains frequency, Hz
+    uint8_t cntCycles;          // the number of integrated mains cycles
+    uint32_t tusWindow;         // the integration time, us
+    double dRatio;              // the detection ripple power ratio (detected / other frequency)
+} MAINSSTATE;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t MAINS_Start(uint16_t frq, uint8_t cntCycles);
+void MAINS_Stop();
+uint8_t MAINS_FActive();
+uint8_t MAINS_Detect(uint16_t *pFrq, double *pdRatio);
+double MAINS_DGetAvgValue(uint8_t *pbErr);
+void MAINS_GetState(MAINSSTATE *pState);
+
+#endif /* _MAINS_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -29,12 +29,12 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
+#include <string.h>
 #include "dmm.h"
 #include "errors.h"
 #include "eprom.h"
 #include "serialno.h"
+#include "utils.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
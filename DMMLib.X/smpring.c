@@ -0,0 +1,207 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    smpring.c
+
+  @Description
+        This file groups the functions that implement the SMPRING module (raw samples ring buffer).
+        The ring buffers DMMSAMPLE raw samples between a single producer (for example the interrupt driven acquisition
+        or the function that completes a background status read) and a single consumer (the main loop),
+        so that the acquisition and the UART output of the values overlap.
+        The ring needs no lock and no interrupt disabling: the head index is written only by the producer and the tail index only
+        by the consumer. Both indexes are free running, the number of samples is a power of 2 so that the index is masked
+        and the count is computed by a wrapping subtraction.
+        A sample is published by incrementing the head index only after it was completely written (and a slot is released
+        by incrementing the tail index only after it was completely read), the order being enforced by SMPRING_BARRIER.
+        When the ring is full, the new sample is dropped and counted as overflow. The high water mark records the maximum
+        number of samples held, which helps sizing the ring.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, samples ring buffer
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stddef.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "smpring.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SMPRING_Init
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**      DMMSAMPLE *pSamples     - the samples storage
+**      uint32_t cntSamples     - the number of samples in the storage, must be a power of 2
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_SMPRING_SIZE      0xEC    // error, the number of samples is not a power of 2
+**
+**	Description:
+**		This function initializes an empty ring over the provided storage and clears the counters.
+**      It must be called while neither the producer nor the consumer use the ring.
+**
+*/
+uint8_t SMPRING_Init(SMPRING *pRing, DMMSAMPLE *pSamples, uint32_t cntSamples)
+{
+    if(cntSamples == 0 || (cntSamples & (cntSamples - 1)))
+    {
+        return ERRVAL_SMPRING_SIZE;
+    }
+    pRing->pSamples = pSamples;
+    pRing->cntMask = cntSamples - 1;
+    pRing->idxHead = 0;
+    pRing->idxTail = 0;
+    pRing->cntOverflows = 0;
+    pRing->cntHighWater = 0;
+    return ERRVAL_SUCCESS;
+}
+
+/***	SMPRING_Push
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**      DMMSAMPLE *pSample      - the sample to be added
+**
+**	Return Value:
+**		uint8_t     - 1 if the sample was added, 0 if the ring is full and the sample was dropped
+**
+**	Description:
+**		This function adds a sample to the ring. It must be called only by the producer, it can be called from an interrupt.
+**      When the ring is full the overflow counter is incremented.
+**
+*/
+uint8_t SMPRING_Push(SMPRING *pRing, DMMSAMPLE *pSample)
+{
+    uint32_t idxHead = pRing->idxHead;
+    uint32_t cntSamples = idxHead - pRing->idxTail;
+    if(cntSamples > pRing->cntMask)
+    {
+        pRing->cntOverflows++;
+        return 0;
+    }
+    pRing->pSamples[idxHead & pRing->cntMask] = *pSample;
+    SMPRING_BARRIER();
+    pRing->idxHead = idxHead + 1;   // publish the sample after it is completely written
+    if(cntSamples + 1 > pRing->cntHighWater)
+    {
+        pRing->cntHighWater = cntSamples + 1;
+    }
+    return 1;
+}
+
+/***	SMPRING_Pop
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**      DMMSAMPLE *pSample      - pointer to the structure receiving the sample
+**
+**	Return Value:
+**		uint8_t     - 1 if a sample was retrieved, 0 if the ring is empty
+**
+**	Description:
+**		This function removes the oldest sample from the ring, without waiting. It must be called only by the consumer.
+**
+*/
+uint8_t SMPRING_Pop(SMPRING *pRing, DMMSAMPLE *pSample)
+{
+    uint32_t idxTail = pRing->idxTail;
+    if(pRing->idxHead == idxTail)
+    {
+        return 0;
+    }
+    SMPRING_BARRIER();
+    *pSample = pRing->pSamples[idxTail & pRing->cntMask];
+    SMPRING_BARRIER();
+    pRing->idxTail = idxTail + 1;   // release the slot after it is completely read
+    return 1;
+}
+
+/***	SMPRING_GetCount
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**
+**	Return Value:
+**		uint32_t    - the number of samples in the ring
+**
+**	Description:
+**		This function returns the number of samples that can be retrieved using SMPRING_Pop.
+**
+*/
+uint32_t SMPRING_GetCount(SMPRING *pRing)
+{
+    return pRing->idxHead - pRing->idxTail;
+}
+
+/***	SMPRING_GetOverflows
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**
+**	Return Value:
+**		uint32_t    - the number of dropped samples
+**
+**	Description:
+**		This function returns the number of samples dropped because the ring was full, since SMPRING_Init.
+**
+*/
+uint32_t SMPRING_GetOverflows(SMPRING *pRing)
+{
+    return pRing->cntOverflows;
+}
+
+/***	SMPRING_GetHighWater
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**
+**	Return Value:
+**		uint32_t    - the high water mark
+**
+**	Description:
+**		This function returns the maximum number of samples held by the ring, since SMPRING_Init.
+**
+*/
+uint32_t SMPRING_GetHighWater(SMPRING *pRing)
+{
+    return pRing->cntHighWater;
+}
+
+/***	SMPRING_Flush
+**
+**	Parameters:
+**      SMPRING *pRing          - the ring
+**
+**	Return Value:
+**
+**	Description:
+**		This function drops the samples present in the ring. It must be called only by the consumer.
+**
+*/
+void SMPRING_Flush(SMPRING *pRing)
+{
+    pRing->idxTail = pRing->idxHead;
+}
+
+/* *****************************************************************************
+ End of File
+ */
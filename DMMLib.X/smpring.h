@@ -0,0 +1,67 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    smpring.h
+
+  @Description
+        This file contains the declaration for the functions of the SMPRING module (raw samples ring buffer).
+        The SMPRING functions are defined in smpring.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, samples ring buffer
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SMPRING_H    /* Guard against multiple inclusion */
+#define _SMPRING_H
+
+#include "stdint.h"
+#include "dmm.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// compiler barrier: the memory accesses are not moved across it
+// (PIC32MX has a single core and no write buffer reordering visible to the interrupts)
+#define SMPRING_BARRIER()   __asm__ __volatile__("" ::: "memory")
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// single producer / single consumer ring, the indexes are free running
+typedef struct _SMPRING{
+    DMMSAMPLE *pSamples;            // the storage, provided by the caller
+    uint32_t cntMask;               // the number of samples - 1, the number of samples is a power of 2
+    volatile uint32_t idxHead;      // written only by the producer
+    volatile uint32_t idxTail;      // written only by the consumer
+    volatile uint32_t cntOverflows; // samples dropped because the ring was full, written only by the producer
+    volatile uint32_t cntHighWater; // the maximum number of samples held, written only by the producer
+} SMPRING;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t SMPRING_Init(SMPRING *pRing, DMMSAMPLE *pSamples, uint32_t cntSamples);
+uint8_t SMPRING_Push(SMPRING *pRing, DMMSAMPLE *pSample);
+uint8_t SMPRING_Pop(SMPRING *pRing, DMMSAMPLE *pSample);
+uint32_t SMPRING_GetCount(SMPRING *pRing);
+uint32_t SMPRING_GetOverflows(SMPRING *pRing);
+uint32_t SMPRING_GetHighWater(SMPRING *pRing);
+void SMPRING_Flush(SMPRING *pRing);
+
+#endif /* _SMPRING_H */
+
+/* *****************************************************************************
+ End of File
+ */
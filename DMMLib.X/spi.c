@@ -9,8 +9,11 @@
 
   @Description
         This file groups the functions that implement the SPI module.
-        The hardware interface SPI module of PIC32 is not used, instead bit bang SPI is implemented.
-        The module is using pins definitions from config.h.
+        Two transports are available, selected at build time using SPI_TRANSPORT (see spi.h):
+        bit bang SPI (default) and the SPI2 hardware interface of PIC32, accessed through the HAL SPI peripheral operations.
+        The hardware transport only handles 8 bit frames. Shorter frames (like the 3 bits 
+        Microwire start bit / opcode frames needed by EPROM) are bit banged while the peripheral is disabled.
+        The module is using the pins definitions from gpio.h, mapped over the HAL.
         The module implements the data communication layer for DMM and EPROM modules, each of these modules 
         handling the specific Slave Select pin.
         The "Internal low level functions" section groups functions that are called from other modules (DMM and EPROM). 
@@ -33,10 +36,27 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
+#include <stddef.h>
 #include "gpio.h"
 #include "spi.h"
+#include "hal.h"
+#include "utils.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t SPI_BitBangTransferBits(uint8_t bVal, uint8_t cbBits);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+volatile int cntSpiBusLocks = 0;
+void (*pfnSpiBusLockHook)(uint8_t fLocked) = NULL;
 
 
 /* ************************************************************************** */
@@ -58,6 +78,7 @@
 **      The following digital pins are configured as digital outputs: SPI_CLK, SPI_MOSI, CS_EPROM, CS_DMM.
 **      The following digital pins are configured as digital inputs: SPI_MISO.
 **      The CS_EPROM and CS_DMM pins are deactivated.
+**      When the hardware transport is selected, the SPI2 peripheral is configured as master, at SPI_HW_CLK_FRQ.
 **      This function is not intended to be called by user, as it is an internal low level function.
 **      This function is called by DMM_Init() and EPROM_Init().
 **      The function guards against multiple calls using a static flag variable.
@@ -69,6 +90,9 @@ void SPI_Init()
     if(!fInitialized)
     {
         GPIO_Init();    // GPIO_Init is protected against multiple calls
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+        HAL_SpiHwInit(SPI_HW_CLK_FRQ);
+#endif
         fInitialized = 1;
     }
 }
@@ -106,20 +130,191 @@ uint8_t SPI_CoreTransferByte(uint8_t bVal)
 **		uint8_t           - the byte containing bits received over SPI	
 **
 **	Description:
-**		This function implements basic bit bang SPI transfer. 
+**		This function transfers the specified number of bits over the selected SPI transport. 
 **      It transmits the number of bits specified by the bVal parameter and returns the received bits.
 **      The cbBits parameter must be <= 8. The bits to be transmitted are cbBits placed on LSB positions of bVal. 
 **      The first bit to be transmitted is the MSB bit.
 **      If less than 8 bits are transmitted, the bits on MSB positions are ignored and  
 **      the returned byte will contain 0 value on the MSB positions. 
-**      It uses SPI_CLK_DELAY definition to determine clock period (frequency).
+**      For the hardware transport, 8 bits transfers are performed by the SPI2 peripheral, while shorter transfers are 
+**      bit banged with the peripheral temporarily disabled, so that the pins are controlled by the GPIO latches.
 **      This function does not handle Slave Select (SS) pins.
 **      This function is not intended to be called by user, as it is an internal low level function.
 **      It is called by SPI_CoreTransferByte and functions from DMM and EPROM modules.
 **          
 */
-
 uint8_t SPI_CoreTransferBits(uint8_t bVal, uint8_t cbBits)
+{
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+    uint8_t bRx;
+    if(cbBits == 8)
+    {
+        return HAL_SpiHwTransferByte(bVal);
+    }
+    // the peripheral only handles 8 bit frames, release the pins to GPIO for the short frame
+    HAL_SpiHwEnable(0);
+    bRx = SPI_BitBangTransferBits(bVal, cbBits);
+    HAL_SpiHwEnable(1);
+    return bRx;
+#else
+    return SPI_BitBangTransferBits(bVal, cbBits);
+#endif
+}
+
+/***	SPI_CoreStartBurstRead
+**
+**	Parameters:
+**		uint8_t *pbRdData   - the buffer receiving the bytes. It must remain valid until the burst is completed.
+**      int cbData          - the number of bytes to be read
+**      void (*pfnDone)()   - function called when the burst is completed, can be NULL
+**
+**	Return Value:
+**		uint8_t             - the error code
+**          ERRVAL_SUCCESS          0       // success
+**          ERRVAL_SPI_BUSY         0xEE    // a burst transfer is already in progress
+**          ERRVAL_SPI_BURSTSIZE    0xED    // cbData exceeds SPIHW_BURST_MAXBYTES
+**
+**	Description:
+**		This function starts reading cbData bytes over SPI (0 bytes are transmitted). 
+**      For the hardware transport the transfer is performed by DMA: the function returns immediately 
+**      and pfnDone is called from the DMA interrupt when the last byte was received.
+**      For the bit bang transport the transfer is performed before returning and pfnDone is called before returning.
+**      In both cases SPI_CoreFBurstBusy can be polled for completion. 
+**      No other SPI transfer must be performed until the burst is completed.
+**      This function does not handle Slave Select (SS) pins.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**      It is called by functions from DMM module.
+**          
+*/
+uint8_t SPI_CoreStartBurstRead(uint8_t *pbRdData, int cbData, void (*pfnDone)())
+{
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+    return HAL_SpiHwStartBurst(pbRdData, cbData, pfnDone);
+#else
+    int i;
+    for(i = 0; i < cbData; i++)
+    {
+        pbRdData[i] = SPI_BitBangTransferBits(0, 8);
+    }
+    if(pfnDone)
+    {
+        pfnDone();
+    }
+    return ERRVAL_SUCCESS;
+#endif
+}
+
+/***	SPI_CoreFBurstBusy
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 if a burst transfer started by SPI_CoreStartBurstRead is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the burst transfer state. For the bit bang transport it always returns 0.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**          
+*/
+uint8_t SPI_CoreFBurstBusy()
+{
+#if SPI_TRANSPORT == SPI_TRANSPORT_HW
+    return HAL_SpiHwFBurstBusy();
+#else
+    return 0;
+#endif
+}
+
+/***	SPI_LockBus
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function marks the beginning of a SPI transaction (a DMM or EPROM slave select activation). 
+**      The calls can be nested. On the first call the lock hook (see SPI_SetBusLockHook) is called with fLocked = 1, 
+**      so that the interrupt driven acquisition does not access the bus until SPI_UnlockBus.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**          
+*/
+void SPI_LockBus()
+{
+    if(cntSpiBusLocks++ == 0 && pfnSpiBusLockHook)
+    {
+        pfnSpiBusLockHook(1);
+    }
+}
+
+/***	SPI_UnlockBus
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function marks the end of a SPI transaction started by SPI_LockBus. 
+**      On the last nested call the lock hook is called with fLocked = 0.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**          
+*/
+void SPI_UnlockBus()
+{
+    if(cntSpiBusLocks > 0 && --cntSpiBusLocks == 0 && pfnSpiBusLockHook)
+    {
+        pfnSpiBusLockHook(0);
+    }
+}
+
+/***	SPI_SetBusLockHook
+**
+**	Parameters:
+**		void (*pfnHook)(uint8_t fLocked)    - the function called when the bus is locked / unlocked, NULL to remove it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function registers the function called when the bus lock state changes. 
+**      It is used by the interrupt driven acquisition (DMMACQ) to disable its interrupt while the bus is locked.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**          
+*/
+void SPI_SetBusLockHook(void (*pfnHook)(uint8_t fLocked))
+{
+    pfnSpiBusLockHook = pfnHook;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPI_BitBangTransferBits
+**
+**	Parameters:
+**		uint8_t bVal      - the byte containing bits to be transmitted over SPI
+**      uint8_t cbBits    - the number of bits to be transmitted over SPI. It should <= 8.
+**
+**	Return Value:
+**		uint8_t           - the byte containing bits received over SPI	
+**
+**	Description:
+**		This function implements basic bit bang SPI transfer. 
+**      It transmits the number of bits specified by the bVal parameter and returns the received bits.
+**      The bits to be transmitted are cbBits placed on LSB positions of bVal, the MSB bit is transmitted first.
+**      It uses SPI_CLK_DELAY definition to determine clock period (frequency).
+**      This function does not handle Slave Select (SS) pins.
+**      It is called by SPI_CoreTransferBits.
+**          
+*/
+uint8_t SPI_BitBangTransferBits(uint8_t bVal, uint8_t cbBits)
 {
 	int		idxBit;
 	uint8_t bRx = 0;
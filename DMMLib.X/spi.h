@@ -34,6 +34,18 @@
 /* ************************************************************************** */
 #define SPI_CLK_DELAY   1   // the parameter used in delay functions in order to implement a clock phase.
 
+// SPI transport, selected at build time by defining SPI_TRANSPORT (for example -DSPI_TRANSPORT=1)
+#define SPI_TRANSPORT_BITBANG   0   // bit bang SPI on the GPIO pins (default)
+#define SPI_TRANSPORT_HW        1   // PIC32 SPI2 hardware peripheral, requires DI routed to SDO2 (RG8) and DO routed to SDI2 (RG7)
+
+#ifndef SPI_TRANSPORT
+#define SPI_TRANSPORT   SPI_TRANSPORT_BITBANG
+#endif
+
+#ifndef SPI_HW_CLK_FRQ
+#define SPI_HW_CLK_FRQ  1000000     // SPI clock frequency used by the hardware transport
+#endif
+
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -45,8 +57,15 @@ void SPI_Init();
 
 // SPI Transfer
 uint8_t SPI_CoreTransferBits(uint8_t bVal, uint8_t cbBits);
+uint8_t SPI_CoreStartBurstRead(uint8_t *pbRdData, int cbData, void (*pfnDone)());
+uint8_t SPI_CoreFBurstBusy();
 uint8_t SPI_CoreTransferByte(uint8_t bVal);
 
+// SPI bus lock, between the main loop transactions and the interrupt driven acquisition
+void SPI_LockBus();
+void SPI_UnlockBus();
+void SPI_SetBusLockHook(void (*pfnHook)(uint8_t fLocked));
+
 
 #endif /* _SPIJA_H */
 
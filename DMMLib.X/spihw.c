@@ -0,0 +1,269 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spihw.c
+
+  @Description
+        This file groups the functions that implement the SPIHW module.
+        The module drives the SPI2 hardware interface of PIC32 as SPI master, and it is used by the SPI module 
+        when the hardware transport is selected (SPI_TRANSPORT defined as SPI_TRANSPORT_HW).
+        The SPI2 peripheral uses SCK2 (RG6) as clock, SDO2 (RG8) as data output and SDI2 (RG7) as data input, 
+        so the shield DI line must be routed to RG8 and the DO line to RG7 (on uC32 using the JP5 / JP7 SPI jumpers).
+        The peripheral is configured for 8 bit frames, clock idle low, data changed on the falling edge 
+        and sampled on the rising edge, the same timing that is implemented by the bit bang transport.
+        When the module is disabled, the pins are controlled by the GPIO latches, as needed to bit bang shorter frames.
+        Burst reads are performed using two DMA channels: channel 0 feeds SPI2BUF with zero bytes 
+        on SPI2 transmit events and channel 1 moves the received bytes to the destination buffer on SPI2 receive events.
+        The DMA channel 1 block done interrupt signals the burst completion.
+        All SPIHW functions are not intended to be called by user, instead user should call functions from DMM and EPROM modules.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, SPI2 hardware transport
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifndef DMM_HOST
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stddef.h>
+#include "gpio.h"
+#include "spihw.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t rgbBurstTx[SPIHW_BURST_MAXBYTES];   // zero bytes transmitted during burst reads
+void (*pfnBurstDone)() = NULL;              // burst completion callback
+volatile uint8_t fBurstBusy = 0;
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Internal low level functions                                      */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIHW_Init
+**
+**	Parameters:
+**		unsigned int clkFrq - the SPI clock frequency, in Hz
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function configures the SPI2 peripheral as SPI master, 8 bit frames, 
+**      clock idle low, data sampled on the rising edge of the clock.
+**      The baud rate generator is set to the closest frequency not higher than clkFrq.
+**      The frequency is limited to PB_FRQ / 2.
+**      The DMA controller is enabled and the DMA channel 1 interrupt priority is set, used by the burst reads. 
+**      The interrupts are not enabled globally, this is done once by the application.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**      This function is called by SPI_Init().
+**          
+*/
+void SPIHW_Init(unsigned int clkFrq)
+{
+    unsigned int brg;
+    SPI2CON = 0;            // stop and reset the peripheral
+    (void)SPI2BUF;          // clear the receive buffer
+    
+    // Fsck = PB_FRQ / (2 * (SPI2BRG + 1)), round up the divider so that the clock does not exceed clkFrq
+    brg = (PB_FRQ + 2 * clkFrq - 1) / (2 * clkFrq);
+    SPI2BRG = brg ? brg - 1: 0;
+    
+    SPI2STATbits.SPIROV = 0;
+    SPI2CONbits.MSTEN = 1;  // master mode
+    SPI2CONbits.CKP = 0;    // clock idle low
+    SPI2CONbits.CKE = 1;    // data changes on the falling edge (active to idle)
+    SPI2CONbits.SMP = 0;    // input sampled in the middle of the data output time
+    SPI2CONbits.ON = 1;
+    
+    // DMA controller, used for burst reads
+    DMACONbits.ON = 1;
+    IPC9bits.DMA1IP = 5;
+    IPC9bits.DMA1IS = 0;
+}
+
+/***	SPIHW_Enable
+**
+**	Parameters:
+**		uint8_t fEnable - 1 to enable the SPI2 peripheral, 0 to disable it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function enables or disables the SPI2 peripheral, without changing its configuration.
+**      When disabled, the SCK2, SDO2 and SDI2 pins are controlled by the GPIO latches.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**      This function is called by SPI_CoreTransferBits() when frames shorter than 8 bits are transferred.
+**          
+*/
+void SPIHW_Enable(uint8_t fEnable)
+{
+    SPI2CONbits.ON = fEnable ? 1: 0;
+}
+
+/***	SPIHW_TransferByte
+**
+**	Parameters:
+**		uint8_t bVal  - the byte to be transmitted over SPI
+**
+**	Return Value:
+**		uint8_t       - the byte received over SPI	
+**
+**	Description:
+**		This function transfers one byte using the SPI2 peripheral. 
+**      It transmits the bVal byte and returns the received byte, MSB bit first.
+**      This function does not handle Slave Select (SS) pins. 
+**      This function is not intended to be called by user, as it is an internal low level function.
+**      It is called by SPI_CoreTransferBits().
+**          
+*/
+uint8_t SPIHW_TransferByte(uint8_t bVal)
+{
+    SPI2BUF = bVal;
+    while(!SPI2STATbits.SPIRBF);    // wait for the received byte
+    return (uint8_t)SPI2BUF;
+}
+
+/***	SPIHW_StartBurst
+**
+**	Parameters:
+**		uint8_t *pbRdData   - the buffer receiving the bytes. It must remain valid until the burst is completed.
+**      int cbData          - the number of bytes to be read, at most SPIHW_BURST_MAXBYTES
+**      void (*pfnDone)()   - function called (from the DMA interrupt) when the burst is completed, can be NULL
+**
+**	Return Value:
+**		uint8_t             - the error code
+**          ERRVAL_SUCCESS          0       // success, the burst was started
+**          ERRVAL_SPI_BUSY         0xEE    // a burst transfer is already in progress
+**          ERRVAL_SPI_BURSTSIZE    0xED    // cbData is outside 1 ... SPIHW_BURST_MAXBYTES
+**
+**	Description:
+**		This function starts a DMA burst read of cbData bytes, transmitting 0 bytes, and returns immediately. 
+**      The completion is signaled through the pfnDone callback and SPIHW_FBurstBusy.
+**      No other SPI transfer must be performed until the burst is completed.
+**      This function does not handle Slave Select (SS) pins. 
+**      This function is not intended to be called by user, as it is an internal low level function.
+**      It is called by SPI_CoreStartBurstRead().
+**          
+*/
+uint8_t SPIHW_StartBurst(uint8_t *pbRdData, int cbData, void (*pfnDone)())
+{
+    if(fBurstBusy)
+    {
+        return ERRVAL_SPI_BUSY;
+    }
+    if(cbData <= 0 || cbData > SPIHW_BURST_MAXBYTES)
+    {
+        return ERRVAL_SPI_BURSTSIZE;
+    }
+    pfnBurstDone = pfnDone;
+    fBurstBusy = 1;
+
+    // discard any stale received byte
+    (void)SPI2BUF;
+    SPI2STATbits.SPIROV = 0;
+    IFS1bits.SPI2RXIF = 0;
+    IFS1bits.SPI2TXIF = 0;
+
+    // channel 1: SPI2BUF -> pbRdData, one byte on each SPI2 receive event
+    DCH1CON = 0;
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = _SPI2_RX_IRQ;
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1SSA = KVA_TO_PA(&SPI2BUF);
+    DCH1SSIZ = 1;
+    DCH1DSA = KVA_TO_PA(pbRdData);
+    DCH1DSIZ = cbData;
+    DCH1CSIZ = 1;
+    DCH1INT = 0;
+    DCH1INTbits.CHBCIE = 1;     // block done interrupt
+    DCH1CONbits.CHPRI = 3;
+    IFS1bits.DMA1IF = 0;
+    IEC1bits.DMA1IE = 1;
+    DCH1CONbits.CHEN = 1;
+
+    // channel 0: zero bytes -> SPI2BUF, one byte on each SPI2 transmit event
+    DCH0CON = 0;
+    DCH0ECON = 0;
+    DCH0ECONbits.CHSIRQ = _SPI2_TX_IRQ;
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0SSA = KVA_TO_PA(rgbBurstTx);
+    DCH0SSIZ = cbData;
+    DCH0DSA = KVA_TO_PA(&SPI2BUF);
+    DCH0DSIZ = 1;
+    DCH0CSIZ = 1;
+    DCH0INT = 0;
+    DCH0CONbits.CHPRI = 2;
+    DCH0CONbits.CHEN = 1;
+    
+    // the transmit buffer is already empty, force the first byte
+    DCH0ECONbits.CFORCE = 1;
+    return ERRVAL_SUCCESS;
+}
+
+/***	SPIHW_FBurstBusy
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 if a burst transfer is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the DMA burst transfer.
+**      This function is not intended to be called by user, as it is an internal low level function.
+**          
+*/
+uint8_t SPIHW_FBurstBusy()
+{
+    return fBurstBusy;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interrupt Handlers                                                */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIHW_DmaRxHandler
+**
+**	Description:
+**		DMA channel 1 interrupt handler, called when all the burst bytes were received.
+**      It stops the transmit channel, clears the busy flag and calls the completion callback.
+**          
+*/
+void __ISR(_DMA_1_VECTOR, ipl5) SPIHW_DmaRxHandler(void)
+{
+    DCH1INTbits.CHBCIF = 0;
+    IFS1bits.DMA1IF = 0;
+    DCH0CONbits.CHEN = 0;
+    DCH1CONbits.CHEN = 0;
+    fBurstBusy = 0;
+    if(pfnBurstDone)
+    {
+        pfnBurstDone();
+    }
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
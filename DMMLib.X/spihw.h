@@ -0,0 +1,56 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    spihw.h
+
+  @Description
+        This file contains the declaration for the functions of SPIHW module.
+        The SPIHW functions are defined in spihw.c source file (PIC32) 
+        and in spimock.c source file (host builds, DMM_HOST defined).
+        They are the SPI peripheral operations of the HAL tables, the other modules call them through the HAL_SpiHw... macros.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, SPI2 hardware transport
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SPIHW_H    /* Guard against multiple inclusion */
+#define _SPIHW_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define SPIHW_BURST_MAXBYTES    64  // maximum number of bytes of a DMA burst transfer
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Internal low level functions                                      */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// SPI2 peripheral initialization
+void SPIHW_Init(unsigned int clkFrq);
+void SPIHW_Enable(uint8_t fEnable);
+
+// SPI2 peripheral transfer
+uint8_t SPIHW_TransferByte(uint8_t bVal);
+
+// DMA burst transfer
+uint8_t SPIHW_StartBurst(uint8_t *pbRdData, int cbData, void (*pfnDone)());
+uint8_t SPIHW_FBurstBusy();
+
+
+#endif /* _SPIHW_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,638 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spimock.c
+
+  @Description
+        This file groups the functions that implement the SPIMOCK module.
+        The module is only built for host (Linux) builds, when DMM_HOST is defined. 
+        It emulates the digital pins used by DMMShield (SPIMOCK_SetPin / SPIMOCK_GetPin are the pin operations of the host HAL)
+        and the SPI2 peripheral of PIC32 (it implements the SPIHW functions), so that both SPI transports can run on host.
+        Device models (DMM converter, EPROM) are attached as slaves using SPIMOCK_AttachSlave. 
+        They can also drive input pins (the DMM interrupt output) using SPIMOCK_SetInput 
+        and observe output pins (the relays) using SPIMOCK_PeekPin.
+        The bit bang transport and the peripheral model clock the same slave interface, so a slave sees identical bit 
+        sequences regardless of the selected transport.
+        The module maintains a simulated time: delays and peripheral transfers advance it, 
+        and bus activity counters are provided in order to compare transports.
+        DMA burst reads are modeled by clocking each byte when the simulated time reaches its transfer end time. 
+        The completion callback is called from SPIMOCK_AdvanceTimeNs, like an interrupt would preempt the main code, 
+        so the code that overlaps work with a burst can be exercised on host.
+        The time hook (see SPIMOCK_SetTimeHook) lets the host HAL emulate other time driven peripherals, like the UART transmitter.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, host SPI bus mock
+
+ */
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#ifdef DMM_HOST
+#include <stddef.h>
+#include <string.h>
+#include "spi.h"
+#include "spihw.h"
+#include "gpio.h"
+#include "spimock.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions Prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t SPIMOCK_FSelected(int idxSlave);
+void SPIMOCK_ClockRisingEdge(uint8_t bMosi);
+uint8_t SPIMOCK_ShiftByte(uint8_t bVal);
+void SPIMOCK_ProcessBurst();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// pin levels, slave selects and DMM interrupt are initially inactive
+uint8_t rgbMockPins[HAL_CNTPINS] = {1, 0, 0, 0, 0, 0, 0, 0, 1};
+void (*pfnMockInputHook)(int idxPin, uint8_t val) = NULL;
+void (*pfnMockTimeHook)() = NULL;
+const SPIMOCK_SLAVE *rgpMockSlaves[SPIMOCK_CNTSLAVES];
+SPIMOCK_STATS mockStats;
+uint64_t tnsMockTime = 0;
+
+// SPI2 peripheral model
+uint8_t fMockHwEnabled = 0;
+uint32_t tnsMockHwBit = 1000;   // duration of one bit
+
+// DMA burst model
+uint8_t *pbMockBurst = NULL;
+int cbMockBurst = 0;
+int idxMockBurst = 0;
+uint64_t tnsMockBurstStart = 0;
+void (*pfnMockBurstDone)() = NULL;
+uint8_t fMockBurstBusy = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIMOCK_AttachSlave
+**
+**	Parameters:
+**		int idxSlave                - SPIMOCK_SLAVE_DMM or SPIMOCK_SLAVE_EPROM
+**      const SPIMOCK_SLAVE *pSlave - the slave device model, NULL to detach
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function attaches a device model to the emulated bus, on the slave select line of DMM or EPROM.
+**          
+*/
+void SPIMOCK_AttachSlave(int idxSlave, const SPIMOCK_SLAVE *pSlave)
+{
+    if(idxSlave >= 0 && idxSlave < SPIMOCK_CNTSLAVES)
+    {
+        rgpMockSlaves[idxSlave] = pSlave;
+    }
+}
+
+/***	SPIMOCK_SetPin
+**
+**	Parameters:
+**		int idxPin      - the pin index (HAL_PIN_...)
+**      uint8_t val     - the pin level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function emulates a GPIO latch write. Writes to the input pins (MISO, DMM interrupt) are ignored.
+**      A rising edge on CLK clocks the selected slaves, with the current MOSI level.
+**      Slave select changes are reported to the attached slaves.
+**      While the SPI2 peripheral model is enabled, the CLK and MOSI writes are ignored (and counted), 
+**      as the real peripheral owns these pins.
+**          
+*/
+void SPIMOCK_SetPin(int idxPin, uint8_t val)
+{
+    uint8_t fPrevSelDmm, fPrevSelEprom;
+    val = val ? 1: 0;
+    if(idxPin < 0 || idxPin >= HAL_CNTPINS || idxPin == HAL_PIN_MISO || idxPin == HAL_PIN_DMMINT)
+    {
+        return;
+    }
+    if(fMockHwEnabled && (idxPin == HAL_PIN_CLK || idxPin == HAL_PIN_MOSI))
+    {
+        mockStats.cntIgnoredPinWrites++;
+        return;
+    }
+    fPrevSelDmm = SPIMOCK_FSelected(SPIMOCK_SLAVE_DMM);
+    fPrevSelEprom = SPIMOCK_FSelected(SPIMOCK_SLAVE_EPROM);
+    if(idxPin == HAL_PIN_CLK && val && !rgbMockPins[HAL_PIN_CLK])
+    {
+        rgbMockPins[idxPin] = val;
+        mockStats.cntBitBangClocks++;
+        SPIMOCK_ClockRisingEdge(rgbMockPins[HAL_PIN_MOSI]);
+        return;
+    }
+    rgbMockPins[idxPin] = val;
+    if(fPrevSelDmm != SPIMOCK_FSelected(SPIMOCK_SLAVE_DMM))
+    {
+        mockStats.cntSelects += !fPrevSelDmm;
+        if(rgpMockSlaves[SPIMOCK_SLAVE_DMM] && rgpMockSlaves[SPIMOCK_SLAVE_DMM]->pfnSelect)
+        {
+            rgpMockSlaves[SPIMOCK_SLAVE_DMM]->pfnSelect(!fPrevSelDmm);
+        }
+    }
+    if(fPrevSelEprom != SPIMOCK_FSelected(SPIMOCK_SLAVE_EPROM))
+    {
+        mockStats.cntSelects += !fPrevSelEprom;
+        if(rgpMockSlaves[SPIMOCK_SLAVE_EPROM] && rgpMockSlaves[SPIMOCK_SLAVE_EPROM]->pfnSelect)
+        {
+            rgpMockSlaves[SPIMOCK_SLAVE_EPROM]->pfnSelect(!fPrevSelEprom);
+        }
+    }
+}
+
+/***	SPIMOCK_GetPin
+**
+**	Parameters:
+**		int idxPin      - the pin index (HAL_PIN_...)
+**
+**	Return Value:
+**		uint8_t         - the pin level
+**
+**	Description:
+**		This function returns the level of an emulated pin. For HAL_PIN_MISO it returns SPIMOCK_GetMISO().
+**      Each read advances the simulated time by SPIMOCK_TNS_PINREAD, 
+**      so that the loops polling a pin (for example the EPROM ready wait) have a duration.
+**          
+*/
+uint8_t SPIMOCK_GetPin(int idxPin)
+{
+    SPIMOCK_AdvanceTimeNs(SPIMOCK_TNS_PINREAD);
+    if(idxPin == HAL_PIN_MISO)
+    {
+        return SPIMOCK_GetMISO();
+    }
+    return (idxPin >= 0 && idxPin < HAL_CNTPINS) ? rgbMockPins[idxPin]: 0;
+}
+
+/***	SPIMOCK_PeekPin
+**
+**	Parameters:
+**		int idxPin      - the pin index (HAL_PIN_...)
+**
+**	Return Value:
+**		uint8_t         - the pin level
+**
+**	Description:
+**		This function returns the latched level of an emulated pin without advancing the simulated time. 
+**      It is used by the slave models, which can be called while the time advances.
+**          
+*/
+uint8_t SPIMOCK_PeekPin(int idxPin)
+{
+    return (idxPin >= 0 && idxPin < HAL_CNTPINS) ? rgbMockPins[idxPin]: 0;
+}
+
+/***	SPIMOCK_GetMISO
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t         - the MISO level
+**
+**	Description:
+**		This function returns the data output level of the selected slave. 
+**      If no slave is selected (or the slave has no output), 0 is returned.
+**          
+*/
+uint8_t SPIMOCK_GetMISO()
+{
+    int idxSlave;
+    for(idxSlave = 0; idxSlave < SPIMOCK_CNTSLAVES; idxSlave++)
+    {
+        if(SPIMOCK_FSelected(idxSlave) && rgpMockSlaves[idxSlave] && rgpMockSlaves[idxSlave]->pfnGetMiso)
+        {
+            return rgpMockSlaves[idxSlave]->pfnGetMiso() ? 1: 0;
+        }
+    }
+    return 0;
+}
+
+/***	SPIMOCK_SetInput
+**
+**	Parameters:
+**		int idxPin      - the input pin index (HAL_PIN_DMMINT)
+**      uint8_t val     - the pin level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function is called by the device models to drive an input pin. 
+**      When the level changes, the input hook (see SPIMOCK_SetInputHook) is called. 
+**      The host HAL uses it to emulate the external interrupt.
+**          
+*/
+void SPIMOCK_SetInput(int idxPin, uint8_t val)
+{
+    val = val ? 1: 0;
+    if(idxPin != HAL_PIN_DMMINT || rgbMockPins[idxPin] == val)
+    {
+        return;
+    }
+    rgbMockPins[idxPin] = val;
+    if(pfnMockInputHook)
+    {
+        pfnMockInputHook(idxPin, val);
+    }
+}
+
+/***	SPIMOCK_SetInputHook
+**
+**	Parameters:
+**		void (*pfnHook)(int idxPin, uint8_t val)    - the function called when an input pin changes, NULL to remove it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function registers the function called when a device model changes an input pin level.
+**          
+*/
+void SPIMOCK_SetInputHook(void (*pfnHook)(int idxPin, uint8_t val))
+{
+    pfnMockInputHook = pfnHook;
+}
+
+/***	SPIMOCK_AdvanceTimeNs
+**
+**	Parameters:
+**		uint32_t tns    - the number of nanoseconds
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function advances the simulated time. It is called by the host HAL delay function.
+**      The bytes of a burst in progress whose transfer end time was reached are clocked, 
+**      and the burst completion callback is called when the last byte is transferred.
+**      Then the attached slaves are notified, so that they can update their state (for example the interrupt output),
+**      and the time hook is called.
+**          
+*/
+void SPIMOCK_AdvanceTimeNs(uint32_t tns)
+{
+    int idxSlave;
+    tnsMockTime += tns;
+    if(fMockBurstBusy)
+    {
+        SPIMOCK_ProcessBurst();
+    }
+    for(idxSlave = 0; idxSlave < SPIMOCK_CNTSLAVES; idxSlave++)
+    {
+        if(rgpMockSlaves[idxSlave] && rgpMockSlaves[idxSlave]->pfnTime)
+        {
+            rgpMockSlaves[idxSlave]->pfnTime();
+        }
+    }
+    if(pfnMockTimeHook)
+    {
+        pfnMockTimeHook();
+    }
+}
+
+/***	SPIMOCK_GetTimeNs
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint64_t        - the simulated time, in nanoseconds
+**
+**	Description:
+**		This function returns the simulated time elapsed since the program start.
+**          
+*/
+uint64_t SPIMOCK_GetTimeNs()
+{
+    return tnsMockTime;
+}
+
+/***	SPIMOCK_SetTimeHook
+**
+**	Parameters:
+**		void (*pfnHook)()   - the function called each time the simulated time advances, NULL to remove it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function registers the function called at the end of SPIMOCK_AdvanceTimeNs, like an interrupt preempting the main code.
+**          
+*/
+void SPIMOCK_SetTimeHook(void (*pfnHook)())
+{
+    pfnMockTimeHook = pfnHook;
+}
+
+/***	SPIMOCK_GetStats
+**
+**	Parameters:
+**		SPIMOCK_STATS *pStats   - pointer to the structure receiving the bus activity counters
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function copies the bus activity counters.
+**          
+*/
+void SPIMOCK_GetStats(SPIMOCK_STATS *pStats)
+{
+    if(pStats)
+    {
+        *pStats = mockStats;
+    }
+}
+
+/***	SPIMOCK_ResetStats
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function clears the bus activity counters.
+**          
+*/
+void SPIMOCK_ResetStats()
+{
+    memset(&mockStats, 0, sizeof(mockStats));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: SPI2 peripheral model (SPIHW functions)                           */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIHW_Init
+**
+**	Parameters:
+**		unsigned int clkFrq - the SPI clock frequency, in Hz
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		Host model of the SPI2 peripheral initialization. 
+**      It computes the bit duration using the same baud rate generator rounding as the PIC32 implementation, 
+**      and enables the peripheral model.
+**          
+*/
+void SPIHW_Init(unsigned int clkFrq)
+{
+    unsigned int brg = (PB_FRQ + 2 * clkFrq - 1) / (2 * clkFrq);
+    if(!brg)
+    {
+        brg = 1;
+    }
+    // Fsck = PB_FRQ / (2 * brg)
+    tnsMockHwBit = (uint32_t)((2000000000ull * brg) / PB_FRQ);
+    fMockHwEnabled = 1;
+}
+
+/***	SPIHW_Enable
+**
+**	Parameters:
+**		uint8_t fEnable - 1 to enable the SPI2 peripheral model, 0 to disable it
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		Host model of the SPI2 peripheral enable. When disabled, CLK and MOSI follow the GPIO latches.
+**          
+*/
+void SPIHW_Enable(uint8_t fEnable)
+{
+    fMockHwEnabled = fEnable ? 1: 0;
+    rgbMockPins[HAL_PIN_CLK] = 0;   // clock idle low
+}
+
+/***	SPIHW_TransferByte
+**
+**	Parameters:
+**		uint8_t bVal  - the byte to be transmitted over SPI
+**
+**	Return Value:
+**		uint8_t       - the byte received over SPI	
+**
+**	Description:
+**		Host model of an SPI2 peripheral byte transfer. 
+**      It clocks the selected slaves 8 times, MSB first, sampling MISO after each rising edge, 
+**      and advances the simulated time with the duration of 8 bits.
+**      If the peripheral model is not enabled, 0xFF is returned and nothing is clocked.
+**          
+*/
+uint8_t SPIHW_TransferByte(uint8_t bVal)
+{
+    uint8_t bRx;
+    if(!fMockHwEnabled)
+    {
+        return 0xFF;
+    }
+    bRx = SPIMOCK_ShiftByte(bVal);
+    tnsMockTime += 8 * tnsMockHwBit;
+    return bRx;
+}
+
+/***	SPIHW_StartBurst
+**
+**	Parameters:
+**		uint8_t *pbRdData   - the buffer receiving the bytes
+**      int cbData          - the number of bytes to be read, at most SPIHW_BURST_MAXBYTES
+**      void (*pfnDone)()   - function called when the burst is completed, can be NULL
+**
+**	Return Value:
+**		uint8_t             - the error code
+**          ERRVAL_SUCCESS          0       // success, the burst was started
+**          ERRVAL_SPI_BUSY         0xEE    // a burst transfer is already in progress
+**          ERRVAL_SPI_BURSTSIZE    0xED    // cbData is outside 1 ... SPIHW_BURST_MAXBYTES
+**
+**	Description:
+**		Host model of the DMA burst read. It only records the burst, the bytes are clocked 
+**      as the simulated time advances (see SPIMOCK_AdvanceTimeNs).
+**          
+*/
+uint8_t SPIHW_StartBurst(uint8_t *pbRdData, int cbData, void (*pfnDone)())
+{
+    if(fMockBurstBusy)
+    {
+        return ERRVAL_SPI_BUSY;
+    }
+    if(cbData <= 0 || cbData > SPIHW_BURST_MAXBYTES)
+    {
+        return ERRVAL_SPI_BURSTSIZE;
+    }
+    pbMockBurst = pbRdData;
+    cbMockBurst = cbData;
+    idxMockBurst = 0;
+    tnsMockBurstStart = tnsMockTime;
+    pfnMockBurstDone = pfnDone;
+    fMockBurstBusy = 1;
+    return ERRVAL_SUCCESS;
+}
+
+/***	SPIHW_FBurstBusy
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 if a burst transfer is in progress, 0 otherwise
+**
+**	Description:
+**		Host model of the burst state check. 
+**      As the caller usually spins on this function, each call that finds the burst in progress 
+**      advances the simulated time with the duration of one byte.
+**          
+*/
+uint8_t SPIHW_FBurstBusy()
+{
+    if(fMockBurstBusy)
+    {
+        SPIMOCK_AdvanceTimeNs(8 * tnsMockHwBit);
+    }
+    return fMockBurstBusy;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIMOCK_FSelected
+**
+**	Parameters:
+**		int idxSlave    - SPIMOCK_SLAVE_DMM or SPIMOCK_SLAVE_EPROM
+**
+**	Return Value:
+**		uint8_t         - 1 if the slave select line is active, 0 otherwise
+**
+**	Description:
+**		This function checks the slave select line, considering that CS_DMM is active low and CS_EPROM is active high.
+**          
+*/
+uint8_t SPIMOCK_FSelected(int idxSlave)
+{
+    if(idxSlave == SPIMOCK_SLAVE_DMM)
+    {
+        return !rgbMockPins[HAL_PIN_CS_DMM];
+    }
+    return rgbMockPins[HAL_PIN_CS_EPROM];
+}
+
+/***	SPIMOCK_ClockRisingEdge
+**
+**	Parameters:
+**		uint8_t bMosi   - the MOSI level
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function clocks the selected slaves with the provided MOSI level.
+**          
+*/
+void SPIMOCK_ClockRisingEdge(uint8_t bMosi)
+{
+    int idxSlave;
+    mockStats.cntClocks++;
+    for(idxSlave = 0; idxSlave < SPIMOCK_CNTSLAVES; idxSlave++)
+    {
+        if(SPIMOCK_FSelected(idxSlave) && rgpMockSlaves[idxSlave] && rgpMockSlaves[idxSlave]->pfnClock)
+        {
+            rgpMockSlaves[idxSlave]->pfnClock(bMosi);
+        }
+    }
+}
+
+/***	SPIMOCK_ShiftByte
+**
+**	Parameters:
+**		uint8_t bVal    - the byte to be transmitted
+**
+**	Return Value:
+**		uint8_t         - the received byte
+**
+**	Description:
+**		This function clocks the selected slaves 8 times, MSB first, sampling MISO after each rising edge, 
+**      as the SPI2 peripheral does. It does not advance the simulated time.
+**          
+*/
+uint8_t SPIMOCK_ShiftByte(uint8_t bVal)
+{
+    int idxBit;
+    uint8_t bRx = 0;
+    for(idxBit = 7; idxBit >= 0; idxBit--)
+    {
+        SPIMOCK_ClockRisingEdge((bVal >> idxBit) & 1);
+        bRx = (bRx << 1) | SPIMOCK_GetMISO();
+    }
+    mockStats.cntHwBytes++;
+    return bRx;
+}
+
+/***	SPIMOCK_ProcessBurst
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function transfers the burst bytes whose end time was reached by the simulated time.
+**      When the last byte is transferred, the burst is marked as done and the completion callback is called.
+**          
+*/
+void SPIMOCK_ProcessBurst()
+{
+    while(fMockBurstBusy && idxMockBurst < cbMockBurst && 
+        tnsMockBurstStart + (uint64_t)(idxMockBurst + 1) * 8 * tnsMockHwBit <= tnsMockTime)
+    {
+        pbMockBurst[idxMockBurst++] = SPIMOCK_ShiftByte(0);
+    }
+    if(fMockBurstBusy && idxMockBurst >= cbMockBurst)
+    {
+        fMockBurstBusy = 0;
+        if(pfnMockBurstDone)
+        {
+            pfnMockBurstDone();
+        }
+    }
+}
+
+#endif /* DMM_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
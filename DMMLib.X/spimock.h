@@ -0,0 +1,92 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    spimock.h
+
+  @Description
+        This file contains the declaration for the functions of SPIMOCK module.
+        The SPIMOCK module is only built for host (Linux) builds, when DMM_HOST is defined.
+        The SPIMOCK functions are defined in spimock.c source file.
+
+  @Versioning:
+ 	 2026/10/16 - Initial release, host SPI bus mock
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SPIMOCK_H    /* Guard against multiple inclusion */
+#define _SPIMOCK_H
+
+#include "stdint.h"
+#include "hal.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// the emulated pins are the HAL pins (HAL_PIN_...), see hal.h
+#define SPIMOCK_TNS_PINREAD     400     // simulated duration of a pin read (PORT read and loop overhead), so that polling loops advance the time
+
+// slaves that can be attached to the emulated bus
+#define SPIMOCK_SLAVE_DMM       0
+#define SPIMOCK_SLAVE_EPROM     1
+#define SPIMOCK_CNTSLAVES       2
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// slave device model, any of the functions can be NULL
+typedef struct _SPIMOCK_SLAVE{
+    void (*pfnSelect)(uint8_t fSelected);   // called when the slave select line changes
+    void (*pfnClock)(uint8_t bMosi);        // called on each rising clock edge while selected, the output set here is sampled by the master after this edge
+    uint8_t (*pfnGetMiso)();                // returns the level of the slave data output
+    void (*pfnTime)();                      // called when the simulated time advances, regardless of the slave select
+} SPIMOCK_SLAVE;
+
+// bus activity counters
+typedef struct _SPIMOCK_STATS{
+    uint32_t cntClocks;             // rising clock edges seen by the bus (bit bang and peripheral)
+    uint32_t cntBitBangClocks;      // rising clock edges generated from the GPIO latches
+    uint32_t cntHwBytes;            // bytes transferred by the SPI2 peripheral model
+    uint32_t cntSelects;            // slave select activations
+    uint32_t cntIgnoredPinWrites;   // CLK / MOSI latch writes while the pins are owned by the peripheral
+} SPIMOCK_STATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+// slaves
+void SPIMOCK_AttachSlave(int idxSlave, const SPIMOCK_SLAVE *pSlave);
+
+// pins
+void SPIMOCK_SetPin(int idxPin, uint8_t val);
+uint8_t SPIMOCK_GetPin(int idxPin);
+uint8_t SPIMOCK_PeekPin(int idxPin);
+uint8_t SPIMOCK_GetMISO();
+void SPIMOCK_SetInput(int idxPin, uint8_t val);
+void SPIMOCK_SetInputHook(void (*pfnHook)(int idxPin, uint8_t val));
+
+// simulated time
+void SPIMOCK_AdvanceTimeNs(uint32_t tns);
+uint64_t SPIMOCK_GetTimeNs();
+void SPIMOCK_SetTimeHook(void (*pfnHook)());
+
+// statistics
+void SPIMOCK_GetStats(SPIMOCK_STATS *pStats);
+void SPIMOCK_ResetStats();
+
+#endif /* _SPIMOCK_H */
+
+/* *****************************************************************************
+ End of File
+ */
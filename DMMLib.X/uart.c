@@ -12,10 +12,23 @@
         This module implements the UART1 functionality connected to the USB - UART 
         interface of the uc32 board. It provides basic functions to configure UART and  
         transmit / receive functions. The module initializes the UART to generate interrupt when a character is received.
-        In the interrupt handler, the array of characters are stored as commands, using a circular buffer. 
+        In the interrupt handler, the received characters are stored in a receive ring of characters, as zero terminated lines, 
+        so that each line uses only as many bytes as it contains. 
         A command is a sequence of characters terminated by one of '\r', '\n', or both. 
-        The "Interrupt service routines" section contains the Uart1 interrupt Handler function, 
-        that implements the UART receive mode if the interrupt mode is chosen.
+        The first cchRxMax characters of the ring are mirrored after its end, so that each line is contiguous in memory, 
+        even when it wraps around the end of the ring: the lines can be parsed in place (UART_GetLine, UART_ReleaseLine).
+        The lines that do not fit in the ring, or that are too long, are dropped and counted (see UART_GetRxStats). 
+        The receive errors reported by the HAL (UART buffer overrun, framing and parity errors) are counted 
+        and drop the line being received. The optional flow control (UART_SetFlowControl) stops the sender 
+        when the receive ring is nearly full, either by holding the RX interrupt, so that the UART buffer fills 
+        and the U1RTS pin is deasserted (RTS / CTS), or by sending XOFF (XON / XOFF), and resumes it once the lines are processed. 
+        The transmitted characters are queued in a transmit ring, drained by the UART1 TX interrupt (see UART_ProcessTxChar),
+        so that UART_PutString returns without waiting for the characters to be sent. 
+        When the ring has no room for a string, the string is either dropped and counted or the caller waits, according to the policy.
+        The baud rate can be changed at run time (UART_SetBaud), up to PB_FRQ / 4 using the high speed mode (BRGH). 
+        The new baud rate must be confirmed by receiving a line, otherwise UART_CheckBaudTimeout restores the initial baud rate.
+        The Uart1 interrupt handler is implemented in the PIC32 HAL (hal_pic32.c): it passes the received characters 
+        and the receive errors to UART_ProcessRxChar and UART_ProcessRxError, and fills the UART1 TX buffer using UART_ProcessTxChar.
         The "Interface functions" section groups functions that can also be called by User.
         The "Local functions" section groups low level functions that are only called from within current module. 
     
@@ -35,10 +48,13 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
-#include "gpio.h"
+#include <string.h>
+#include "stdint.h"
 #include "uart.h"
+#include "utils.h"
+#include "gpio.h"
+#include "errors.h"
+#include "hal.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -47,107 +63,44 @@
 /* ************************************************************************** */
 /* ************************************************************************** */
 
-void UART_ConfigureUartRXInt(unsigned int baud);
-void UART_PutChar(char ch);
 void UART_InitCircBuffer();
+void UART_StoreRxChar(char ch);
+void UART_ResumeRx();
 /* ************************************************************************** */
 /* ************************************************************************** */
 /* Section: Global Variables                                                  */
 /* ************************************************************************** */
 /* ************************************************************************** */
 // global variables, to communicate between interrupt handler and other 
-volatile uint8_t fRxLock = 0;
-volatile uint8_t ichRxCol;
-#define RX_NOLINES 10
-char rgchRxn[RX_NOLINES][cchRxMax];
-//circular buffer definition
-typedef struct circ_buf
-{
-    uint8_t ichRxLineWR;    
-    uint8_t ichRxLineRD;    
-    int cntRxLines;
-} CIRC_BUF;
-
-volatile CIRC_BUF cb;
-
-/* ************************************************************************** */
-/* ************************************************************************** */
-// Section: Interrupt service routines                                        */
-/* ************************************************************************** */
-/* ************************************************************************** */
-
-/* ------------------------------------------------------------ */
-/***	Uart1Handler
-**
-**	Description:
-**		This is the interrupt handler for UART1 RX. It is used to receive strings using interrupt method. 
-**      The interrupt recognizes a string having up to cchRxMax - 1/2 characters, followed by a CR or LF.
-**      When available received bytes are found they are placed in a global string rgchRxn, for each line.
-**      When a carriage return or a line feed ("\r", "\n", CR/LF) sequence is recognized, the interrupt handler 
-**      flags the passing to a new line, takes the new string value and performs specific checks for circular buffer - eg. full.
-**          
-*/
-
-void __ISR(_UART_1_VECTOR, ipl6) Uart1Handler (void)
-{
-	uint8_t bVal;
-	uint8_t fNewLine;
-	//Read the Uart1 RX buffer while data is available
-	while(U1STAbits.URXDA)
-	{
-		bVal = (uint8_t)U1RXREG;
-		
-		if(!fRxLock)
-	    {	
-            fNewLine = 0;
-	        // Do we have space to store another character?
-	        if (cchRxMax <= ichRxCol)
-	        {
-	            // No.
-                fNewLine = 1;
-                // step back to accommodate incoming terminator
-                ichRxCol--;
-            }
-            // Is this one of the line terminator chars ?
-            if(('\n' == bVal ) || ('\r' == bVal) )
-            {
-	            // Yes.
-                fNewLine = 1;
-            }
-            if(fNewLine)
-            {
-                if(ichRxCol > 0)
-                {
-                    // ignore new line if it comes after empty content (second of the '\n' '\r' pair)
-                    rgchRxn[cb.ichRxLineWR][ichRxCol] = '\0';
-                    // move to new line 
-                    ichRxCol = 0;
-                    if(cb.cntRxLines == RX_NOLINES)
-                    {
-                        // circ buffer full, no new line available
-                        fRxLock = 1;
-                    }
-                    else
-                    {
-                        //increase the number of line counter and check if maximum has been reached
-                        cb.cntRxLines++;
-                        if ((++cb.ichRxLineWR >= RX_NOLINES))
-                        {
-                            cb.ichRxLineWR = 0;                        
-                        }                            
-                    }
-                }
-	        }  
-            else
-            {
-                //store the UART content in the new line allocated space
-                rgchRxn[cb.ichRxLineWR][ichRxCol++] = bVal;
-            }
-    	}  	
-    }  
-	//Clear the Uart1 interrupt flag.
-	IFS0bits.U1RXIF = 0;
-}
+// receive ring, the indexes run freely and are reduced modulo UART_RXBUFSIZE
+char rgchRx[UART_RXBUFSIZE + cchRxMax];     // the first cchRxMax characters are mirrored after the end
+uint16_t ichRxWR;                           // next character, written by UART_ProcessRxChar
+volatile uint16_t ichRxLineWR;              // start of the line being received, written by UART_ProcessRxChar
+volatile uint16_t ichRxRD;                  // start of the oldest line, written by UART_ReleaseLine
+volatile uint32_t cntRxLinesIn;             // completed lines, written by UART_ProcessRxChar
+uint32_t cntRxLinesOut;                     // released lines, written by UART_ReleaseLine
+uint16_t cchRxLineRD;                       // length of the line returned by UART_GetLine
+uint8_t fRxLineHeld;                        // the oldest line was returned by UART_GetLine
+uint8_t fRxDiscard;                         // the line being received is dropped
+volatile UART_RXSTATS rxStats;              // written by UART_ProcessRxChar
+// flow control
+uint8_t bFlow = UART_FLOW_NONE;
+volatile uint8_t fRxStopped = 0;            // the sender was stopped, set by UART_StoreRxChar, cleared by UART_ReleaseLine
+volatile uint8_t fTxPaused = 0;             // XOFF was received
+volatile char chTxPriority = 0;             // XON / XOFF to be sent before the transmit ring characters, 0 if none
+
+// transmit ring, the indexes run freely and are reduced modulo UART_TXBUFSIZE
+char rgchTx[UART_TXBUFSIZE];
+volatile uint16_t ichTxWR = 0;      // written by UART_TxQueue
+volatile uint16_t ichTxRD = 0;      // written by UART_ProcessTxChar (TX interrupt)
+uint8_t bTxPolicy = UART_TX_BLOCK;  // policy of UART_PutString
+uint32_t cntTxDropped = 0;
+
+// baud rate
+uint32_t baudInit = UART_BAUD_DEFAULT;  // set by UART_Init, restored by UART_CheckBaudTimeout
+uint32_t baudCur = UART_BAUD_DEFAULT;
+volatile uint8_t fBaudUnconfirmed = 0;  // set by UART_SetBaud, cleared when a line is received
+uint32_t tickBaudSet = 0;
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -164,20 +117,140 @@ void __ISR(_UART_1_VECTOR, ipl6) Uart1Handler (void)
 **		
 **
 **	Description:
-**		This function initializes the UART1 hardware interface involved in the UART module, 
+**		This function initializes, through the HAL, the UART1 hardware interface involved in the UART module, 
 **      the UART receive with interrupt mode.
 **      The UART_TX digital pin is configured as digital output.
 **      The UART_RX digital pin is configured as digital input.
 **      The UART_TX and UART_RX are mapped over the UART1 interface.
 **      The UART1 module of PIC32 is configured to work at the specified baud, no parity and 1 stop bit.
-**      
+**      This baud rate is restored by UART_CheckBaudTimeout when a baud rate set by UART_SetBaud is not confirmed.
+**      The interrupts must be enabled globally by the application before characters are sent (see UART_TxQueue).
 **          
 */
 void UART_Init(unsigned int baud)
 {
-    UART_ConfigureUartRXInt(baud);
+    // configure circular buffer
+    UART_InitCircBuffer();
+    ichTxWR = 0;
+    ichTxRD = 0;
+    cntTxDropped = 0;
+    baudInit = baud;
+    baudCur = baud;
+    fBaudUnconfirmed = 0;
+    HAL_UartInit(baud);
 }
 
+/***	UART_ProcessRxChar
+**
+**	Parameters:
+**		uint8_t bVal - the received character
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function processes one character received over UART. It is called by the HAL 
+**      (from the UART1 RX interrupt handler on PIC32), so it is not intended to be called by user.
+**      The function recognizes strings having up to cchRxMax - 1 characters, followed by a CR or LF.
+**      The received characters are placed in the receive ring, after the previous line.
+**      When a carriage return or a line feed ("\r", "\n", CR/LF) sequence is recognized, the line is zero terminated 
+**      and becomes available to UART_GetLine. Empty lines are ignored.
+**      When the ring has no room for the character and the terminator, or the line exceeds cchRxMax - 1 characters, 
+**      the characters already received for the line are discarded, and the rest of the line is ignored.
+**      With the XON / XOFF flow control, the XON and XOFF characters resume and pause the transmission, they are not stored.
+**      A completed line confirms the baud rate set by UART_SetBaud, see UART_CheckBaudTimeout.
+**          
+*/
+void UART_ProcessRxChar(uint8_t bVal)
+{
+    uint16_t cchUsed;
+    if(bFlow == UART_FLOW_XONXOFF && (bVal == UART_XON || bVal == UART_XOFF))
+    {
+        // the other side controls the transmission
+        fTxPaused = (bVal == UART_XOFF);
+        if(!fTxPaused)
+        {
+            HAL_UartTxStart();
+        }
+        return;
+    }
+    if(('\n' == bVal ) || ('\r' == bVal))
+    {
+        // ignore new line if it comes after empty content (second of the '\n' '\r' pair) or a dropped line
+        if(ichRxWR != ichRxLineWR)
+        {
+            UART_StoreRxChar('\0');
+            ichRxLineWR = ichRxWR;
+            cntRxLinesIn++;
+            rxStats.cntLines++;
+            fBaudUnconfirmed = 0;   // the other side follows the baud rate
+        }
+        fRxDiscard = 0;
+        return;
+    }
+    if(fRxDiscard)
+    {
+        return;
+    }
+    // keep room for this character and the terminator
+    cchUsed = (uint16_t)(ichRxWR - ichRxRD);
+    if(cchUsed + 2 > UART_RXBUFSIZE || (uint16_t)(ichRxWR - ichRxLineWR) >= cchRxMax - 1)
+    {
+        if(cchUsed + 2 > UART_RXBUFSIZE)
+        {
+            rxStats.cntOverruns++;
+        }
+        else
+        {
+            rxStats.cntLongLines++;
+        }
+        ichRxWR = ichRxLineWR;
+        fRxDiscard = 1;
+        return;
+    }
+    UART_StoreRxChar(bVal);
+    if(cchUsed + 1 > rxStats.cchMaxUsed)
+    {
+        rxStats.cchMaxUsed = cchUsed + 1;
+    }
+}
+
+
+/***	UART_ProcessRxError
+**
+**	Parameters:
+**		uint8_t bErrors - the receive errors, a combination of:
+**          UART_RXERR_OVERRUN  1   // the UART receive buffer overflowed, characters were lost
+**          UART_RXERR_FRAMING  2   // a character was received with a framing error
+**          UART_RXERR_PARITY   4   // a character was received with a parity error
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function processes the receive errors detected by the HAL (from the UART1 interrupt handler on PIC32), 
+**      so it is not intended to be called by user. The character received with a framing or parity error is not passed 
+**      to UART_ProcessRxChar. The errors are counted (see UART_GetRxStats), and the line being received is dropped, 
+**      as it misses characters: the characters already received are discarded, and the rest of the line is ignored.
+**          
+*/
+void UART_ProcessRxError(uint8_t bErrors)
+{
+    if(bErrors & UART_RXERR_OVERRUN)
+    {
+        rxStats.cntFifoOverruns++;
+    }
+    if(bErrors & UART_RXERR_FRAMING)
+    {
+        rxStats.cntFramingErrors++;
+    }
+    if(bErrors & UART_RXERR_PARITY)
+    {
+        rxStats.cntParityErrors++;
+    }
+    ichRxWR = ichRxLineWR;
+    fRxDiscard = 1;
+}
 
 /***	UART_PutString
 **
@@ -189,17 +262,13 @@ void UART_Init(unsigned int baud)
 **
 **	Description:
 **		This function transmits all the characters from a zero terminated string over UART1. The terminator character is not sent.
-**      
+**      The characters are queued in the transmit ring and sent by the TX interrupt, see UART_TxQueue. 
+**      When the ring has no room for the string, the policy selected by UART_SetTxPolicy is applied (UART_TX_BLOCK by default).
 **          
 */
 void UART_PutString(char szData[])
 {
-    char *pData = szData;
-    while(*pData)
-    {
-        UART_PutChar((*(pData++)));
-        DelayAprox10Us(10);
-    }
+    UART_TxQueue(szData, strlen(szData), bTxPolicy);
 }
 
 /***	UART_GetString
@@ -216,132 +285,434 @@ void UART_PutString(char szData[])
 **
 **	Description:
 **		This function provides a zero terminated string received over UART1  
-**      which was placed in the circular buffer by the UART interrupt handler.
-**		If a received string is available in the circular buffer, the string
-**		is copied in the pchBuff string and its length is returned.
+**      which was placed in the receive ring by the UART interrupt handler.
+**		If a received string is available in the receive ring, the string
+**		is copied in the pchBuff string (truncated to cchBuff - 1 characters) and its length is returned.
 **		Otherwise, the function returns 0.
+**      UART_GetLine avoids the copy.
 **          
 */
 uint8_t UART_GetString(char* pchBuff, int cchBuff )
 {
-	uint8_t ich;
-	uint8_t cmdLen;
-	
+    char *szLine = UART_GetLine();
+    uint8_t cmdLen;
 	// Have we finished receiving a CR/LF terminated string via UART1?
-	if(cb.cntRxLines <= 0)
-	{
-		return 0;
-	}
-    cmdLen = strlen(rgchRxn[cb.ichRxLineRD]);
-	// Does the user buffer have enough space to store the CR/LF terminated string?
-	if(cchBuff < cmdLen)
-	{
-		// A buffer underrun occurred.
-		cmdLen = cchBuff;
-	}
-
-    // copy the received chars to the destination location.
-	for(ich = 0; ich <= cmdLen; ich++)
-	{
-		*pchBuff = rgchRxn[cb.ichRxLineRD][ich]; 
-		pchBuff++;
-	}
-
-    // move to next
-    cb.cntRxLines--;
-    if ((++cb.ichRxLineRD >= RX_NOLINES))
+    if(!szLine || cchBuff <= 0)
     {
-        cb.ichRxLineRD = 0;                        
-    }                            
-    fRxLock = 0;
-
-	return ich;
+        return 0;
+    }
+    cmdLen = (cchRxLineRD < cchBuff) ? cchRxLineRD: cchBuff - 1;
+    memcpy(pchBuff, szLine, cmdLen);
+    pchBuff[cmdLen] = '\0';
+    UART_ReleaseLine();
+	return cmdLen;
 }
 
+/***	UART_GetLine
+**
+**	Parameters:
+**          
+**
+**	Return Value:
+**          char *      - the oldest received zero terminated line, NULL if no line was received
+**
+**	Description:
+**		This function provides the oldest line of the receive ring, without copying it: the line is contiguous in memory 
+**      and it can be parsed in place (for example using strtok). The line is kept, and returned by the next calls, 
+**      until UART_ReleaseLine is called, which allows the UART interrupt handler to reuse its room.
+**          
+*/
+char *UART_GetLine()
+{
+    char *szLine;
+    if(cntRxLinesIn == cntRxLinesOut)
+    {
+        return NULL;
+    }
+    szLine = &rgchRx[ichRxRD & (UART_RXBUFSIZE - 1)];
+    if(!fRxLineHeld)
+    {
+        cchRxLineRD = strlen(szLine);   // kept, as the line may be modified by the parser
+        fRxLineHeld = 1;
+    }
+    return szLine;
+}
 
-/* ************************************************************************** */
-/* ************************************************************************** */
-// Section: Local Functions                                                   */
-/* ************************************************************************** */
-/* ************************************************************************** */
+/***	UART_ReleaseLine
+**
+**	Parameters:
+**          
+**
+**	Return Value:
+**          
+**
+**	Description:
+**		This function drops the line returned by UART_GetLine from the receive ring, after it was processed. 
+**      It does nothing when UART_GetLine did not return a line.
+**      When the flow control stopped the sender and the ring has at least UART_RXRESUME_ROOM room, the sender is resumed.
+**          
+*/
+void UART_ReleaseLine()
+{
+    if(fRxLineHeld)
+    {
+        fRxLineHeld = 0;
+        ichRxRD += cchRxLineRD + 1;
+        cntRxLinesOut++;
+        if(fRxStopped && UART_RXBUFSIZE - (uint16_t)(ichRxWR - ichRxRD) >= UART_RXRESUME_ROOM)
+        {
+            UART_ResumeRx();
+        }
+    }
+}
 
+/***	UART_GetRxStats
+**
+**	Parameters:
+**		UART_RXSTATS *pStats    - pointer to the structure receiving the receive counters
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function provides the receive counters since UART_Init: the received lines, the lines dropped because 
+**      the receive ring was full or because they were too long, the maximum receive ring occupancy, 
+**      the receive errors and the number of times the flow control stopped the sender.
+**          
+*/
+void UART_GetRxStats(UART_RXSTATS *pStats)
+{
+    *pStats = rxStats;
+}
 
-/***	UART_ConfigureUartRXInt
+/***	UART_SetTxPolicy
 **
 **	Parameters:
-**		unsigned int baud - UART baud rate.
-**                                     for example 115200 corresponds to 115200 baud
+**		uint8_t bPolicy - the policy applied by UART_PutString when the transmit ring has no room for a string:
+**          UART_TX_BLOCK   0   // wait until the TX interrupt makes room
+**          UART_TX_DROP    1   // drop the string, its characters are counted
 **
 **	Return Value:
 **		
 **
 **	Description:
-**		This function configures the UART1 hardware interface of PIC32, according 
-**      to the provided baud rate, no parity and 1 stop bit (by calling the UART_ConfigureUart function)
-**      and additionally configures the interrupt on RX.
-**      This is a low-level function called by initialization functions, so user should avoid calling it directly.   
-**      
+**		This function selects the transmit policy of UART_PutString.
 **          
 */
-void UART_ConfigureUartRXInt(unsigned int baud)
+void UART_SetTxPolicy(uint8_t bPolicy)
 {
+    bTxPolicy = bPolicy;
+}
 
-    U1MODEbits.ON     = 0;
-    U1MODEbits.SIDL   = 0;
-    U1MODEbits.IREN   = 0; 
-    U1MODEbits.RTSMD  = 0;
-    U1MODEbits.UEN0   = 0; 
-    U1MODEbits.UEN1   = 0;
-    U1MODEbits.WAKE   = 0;
-    U1MODEbits.LPBACK = 0; 
-    U1MODEbits.ABAUD  = 0;
-    U1MODEbits.RXINV  = 0; 
-    U1MODEbits.PDSEL1 = 0; 
-    U1MODEbits.PDSEL0 = 0; 
-    U1MODEbits.STSEL  = 0;  
+/***	UART_TxQueue
+**
+**	Parameters:
+**		char const *pData   - the characters to be transmitted
+**		int cchData         - the number of characters
+**		uint8_t bPolicy     - the policy applied when the transmit ring has no room for all the characters:
+**          UART_TX_BLOCK   0   // wait until the TX interrupt makes room
+**          UART_TX_DROP    1   // drop all the characters, they are counted
+**
+**	Return Value:
+**		uint8_t     - 1 if the characters were queued, 0 if they were dropped
+**
+**	Description:
+**		This function queues the characters in the transmit ring and starts the interrupt driven transmission, 
+**      then it returns without waiting for the characters to be sent.
+**      With UART_TX_DROP, the function never waits: the characters are either all queued or all dropped, 
+**      so that no partial line is sent. The dropped characters are counted, see UART_GetTxDropped.
+**      With UART_TX_BLOCK, the function waits for room as long as needed, so a string longer than the ring can be sent.
+**      UART_TX_BLOCK must not be used with the UART interrupt masked (for example from an interrupt handler of the same or higher priority).
+**          
+*/
+uint8_t UART_TxQueue(char const *pData, int cchData, uint8_t bPolicy)
+{
+    int ich;
+    if(bPolicy == UART_TX_DROP && cchData > UART_TXBUFSIZE - (uint16_t)(ichTxWR - ichTxRD))
+    {
+        cntTxDropped += cchData;
+        return 0;
+    }
+    for(ich = 0; ich < cchData; ich++)
+    {
+        while((uint16_t)(ichTxWR - ichTxRD) >= UART_TXBUFSIZE)
+        {
+            // the ring is full, wait for the TX interrupt to send some characters
+            HAL_UartTxStart();
+            DelayAprox10Us(1);
+        }
+        rgchTx[ichTxWR & (UART_TXBUFSIZE - 1)] = pData[ich];
+        ichTxWR++;
+    }
+    HAL_UartTxStart();
+    return 1;
+}
 
-    
-    U1MODEbits.BRGH   = 0; 
+/***	UART_FTxBusy
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 if characters are queued in the transmit ring, 0 otherwise
+**
+**	Description:
+**		This function checks whether the transmit ring holds characters not yet passed to the UART.
+**          
+*/
+uint8_t UART_FTxBusy()
+{
+    return ichTxWR != ichTxRD;
+}
 
-    U1BRG = (int)(((float)PB_FRQ/(16*baud) - 1) + 0.5); // add 0.5 just in order to implement the round using the floor approach
+/***	UART_TxFlush
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function waits until all the characters queued in the transmit ring were passed to the UART.
+**          
+*/
+void UART_TxFlush()
+{
+    while(UART_FTxBusy())
+    {
+        DelayAprox10Us(1);
+    }
+}
 
-    U1STAbits.UTXEN    = 1;
-    U1STAbits.URXEN    = 1;
-    U1MODEbits.ON      = 1; 
+/***	UART_GetTxDropped
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint32_t    - the number of characters dropped because the transmit ring was full
+**
+**	Description:
+**		This function returns the number of characters dropped by the UART_TX_DROP policy since UART_Init.
+**          
+*/
+uint32_t UART_GetTxDropped()
+{
+    return cntTxDropped;
+}
 
-    
-    IPC6bits.U1IP = 6;
-    IPC6bits.U1IS = 3;
+/***	UART_GetBaudDivisor
+**
+**	Parameters:
+**		uint32_t baud       - the requested baud rate
+**		uint8_t *pfBrgh     - pointer to the BRGH bit (1 for the high speed mode, PB_FRQ / 4 clock), can be NULL
+**		uint16_t *pBrg      - pointer to the U1BRG value, can be NULL
+**
+**	Return Value:
+**		uint32_t    - the actual baud rate, 0 if the requested one is out of range or its error exceeds UART_BAUD_MAXERR
+**
+**	Description:
+**		This function computes the UART1 baud rate generator settings closest to the requested baud rate: 
+**      the actual baud rate is PB_FRQ / (16 * (U1BRG + 1)), or PB_FRQ / (4 * (U1BRG + 1)) in the high speed mode.
+**      The standard mode (16 samples per bit) is preferred, the high speed mode is selected when it gives a smaller error, 
+**      so the maximum baud rate is PB_FRQ / 4.
+**      It is used by the HAL to configure the UART and by the user to check the baud rate error before calling UART_SetBaud.
+**          
+*/
+uint32_t UART_GetBaudDivisor(uint32_t baud, uint8_t *pfBrgh, uint16_t *pBrg)
+{
+    uint32_t rgDiv[2], rgBaud[2], rgErr[2];
+    uint8_t fBrgh;
+    if(baud == 0 || baud > PB_FRQ / 4)
+    {
+        return 0;
+    }
+    for(fBrgh = 0; fBrgh < 2; fBrgh++)
+    {
+        // rounded divider, limited to the U1BRG range
+        rgDiv[fBrgh] = (PB_FRQ + (fBrgh ? 2: 8) * baud) / ((fBrgh ? 4: 16) * baud);
+        rgDiv[fBrgh] = (rgDiv[fBrgh] < 1) ? 1: (rgDiv[fBrgh] > 0x10000) ? 0x10000: rgDiv[fBrgh];
+        rgBaud[fBrgh] = PB_FRQ / ((fBrgh ? 4: 16) * rgDiv[fBrgh]);
+        rgErr[fBrgh] = (rgBaud[fBrgh] > baud) ? rgBaud[fBrgh] - baud: baud - rgBaud[fBrgh];
+    }
+    fBrgh = (rgErr[1] < rgErr[0]);
+    if((uint64_t)rgErr[fBrgh] * 1000 > (uint64_t)baud * UART_BAUD_MAXERR)
+    {
+        return 0;
+    }
+    if(pfBrgh)
+    {
+        *pfBrgh = fBrgh;
+    }
+    if(pBrg)
+    {
+        *pBrg = (uint16_t)(rgDiv[fBrgh] - 1);
+    }
+    return rgBaud[fBrgh];
+}
 
-	IFS0bits.U1RXIF = 0;    //Clear the Uart1 interrupt flag.
-    IEC0bits.U1RXIE = 1;    // enable RX interrupt
+/***	UART_SetBaud
+**
+**	Parameters:
+**		uint32_t baud       - the new baud rate
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_UART_BAUD            0xE8    // baud rate out of range or not achievable
+**
+**	Description:
+**		This function changes the UART baud rate, keeping the received lines. 
+**      It first waits until the queued characters are transmitted (for example the acknowledgment of the baud rate command), 
+**      so that they are sent at the previous baud rate.
+**      The new baud rate must be confirmed by receiving a line within UART_BAUD_TIMEOUT_MS, see UART_CheckBaudTimeout.
+**          
+*/
+uint8_t UART_SetBaud(uint32_t baud)
+{
+    if(!UART_GetBaudDivisor(baud, NULL, NULL))
+    {
+        return ERRVAL_UART_BAUD;
+    }
+    UART_TxFlush();
+    HAL_UartInit(baud);
+    baudCur = baud;
+    tickBaudSet = HAL_GetTicks();
+    fBaudUnconfirmed = (baud != baudInit);
+    return ERRVAL_SUCCESS;
+}
 
-    macro_enable_interrupts();  // enable interrupts 
-    
-    // configure circular buffer
-    UART_InitCircBuffer();
+/***	UART_GetBaud
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint32_t    - the requested baud rate
+**
+**	Description:
+**		This function returns the current baud rate, as requested by UART_Init or UART_SetBaud. 
+**      The actual baud rate is returned by UART_GetBaudDivisor.
+**          
+*/
+uint32_t UART_GetBaud()
+{
+    return baudCur;
 }
 
+/***	UART_CheckBaudTimeout
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - 1 if the initial baud rate was restored, 0 otherwise
+**
+**	Description:
+**		This function restores the baud rate set by UART_Init when no line was received during UART_BAUD_TIMEOUT_MS
+**      after UART_SetBaud, for example because the other side could not follow the change. 
+**      It must be called periodically, for example before checking for a received command.
+**          
+*/
+uint8_t UART_CheckBaudTimeout()
+{
+    if(!fBaudUnconfirmed || HAL_GetTicks() - tickBaudSet < (uint32_t)UART_BAUD_TIMEOUT_MS * (HAL_TICKS_FRQ / 1000))
+    {
+        return 0;
+    }
+    UART_SetBaud(baudInit);
+    return 1;
+}
 
-/***	UART_PutChar
+/***	UART_SetFlowControl
 **
 **	Parameters:
-**          char ch -   the character to be transmitted over UART.
+**		uint8_t bMode   - the flow control mode:
+**          UART_FLOW_NONE      0   // no flow control
+**          UART_FLOW_RTSCTS    1   // hardware, U1RTS / U1CTS pins
+**          UART_FLOW_XONXOFF   2   // software, XON / XOFF characters
 **
 **	Return Value:
 **		
 **
 **	Description:
-**		This function transmits a character over UART1. 
-**      
+**		This function selects the flow control. When the receive ring has less than UART_RXSTOP_ROOM room, the sender is stopped:
+**      with RTS / CTS, the RX interrupt is held so that the UART receive buffer fills and the UART deasserts U1RTS, 
+**      with XON / XOFF, XOFF is sent. The sender is resumed when the processed lines are released (see UART_ReleaseLine).
+**      With RTS / CTS, the transmission waits for U1CTS; with XON / XOFF, it is paused by a received XOFF until XON is received.
+**      RTS / CTS requires the U1RTS and U1CTS pins to be wired to the other side.
+**      A stopped sender is resumed before changing the mode.
+**          
+*/
+void UART_SetFlowControl(uint8_t bMode)
+{
+    if(fRxStopped)
+    {
+        UART_ResumeRx();
+    }
+    fTxPaused = 0;
+    UART_TxFlush();
+    bFlow = bMode;
+    HAL_UartSetFlow(bMode);
+}
+
+/***	UART_GetFlowControl
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		uint8_t     - the flow control mode (UART_FLOW_...)
+**
+**	Description:
+**		This function returns the flow control mode selected by UART_SetFlowControl.
+**          
+*/
+uint8_t UART_GetFlowControl()
+{
+    return bFlow;
+}
+
+/***	UART_ProcessTxChar
+**
+**	Parameters:
+**		char *pch   - pointer to the character to be transmitted
+**
+**	Return Value:
+**		uint8_t     - 1 if a character was provided, 0 if the transmit ring is empty
+**
+**	Description:
+**		This function provides the next character of the transmit ring. It is called by the HAL 
+**      (from the UART1 TX interrupt handler on PIC32), so it is not intended to be called by user.
+**      A pending XON / XOFF character is provided first, and no character of the ring is provided while XOFF was received.
 **          
 */
-void UART_PutChar(char ch)
+uint8_t UART_ProcessTxChar(char *pch)
 {
-    while(U1STAbits.UTXBF == 1);
-    U1TXREG = ch;
+    if(chTxPriority)
+    {
+        *pch = chTxPriority;
+        chTxPriority = 0;
+        return 1;
+    }
+    if(fTxPaused || ichTxRD == ichTxWR)
+    {
+        return 0;
+    }
+    *pch = rgchTx[ichTxRD & (UART_TXBUFSIZE - 1)];
+    ichTxRD++;
+    return 1;
 }
 
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+
 /***	UART_InitCircBuffer
 **
 **	Parameters:
@@ -351,16 +722,91 @@ void UART_PutChar(char ch)
 **		
 **
 **	Description:
-**		This function initializes the variables used in the circular buffer approach, the lines and columns counters 
+**		This function initializes the variables used by the receive ring, the positions and the lines counters, 
+**      and clears the receive counters.
 **      It is called when the UART interface is first initialized.
-**     
 **          
 */
 void UART_InitCircBuffer()
 {
-    ichRxCol = 0;
-    cb.ichRxLineWR = 0;
-    cb.cntRxLines = 0;
+    ichRxWR = 0;
+    ichRxLineWR = 0;
+    ichRxRD = 0;
+    cntRxLinesIn = 0;
+    cntRxLinesOut = 0;
+    fRxLineHeld = 0;
+    fRxStopped = 0;
+    fTxPaused = 0;
+    chTxPriority = 0;
+    fRxDiscard = 0;
+    memset((void *)&rxStats, 0, sizeof(rxStats));
+}
+
+/***	UART_StoreRxChar
+**
+**	Parameters:
+**		char ch     - the character
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function stores a character in the receive ring, and in the mirror after the end of the ring 
+**      for the first cchRxMax positions. The room must have been checked. It is called by UART_ProcessRxChar.
+**      When a flow control is selected and the ring has less than UART_RXSTOP_ROOM room, the sender is stopped: 
+**      the RX interrupt is held (RTS / CTS) or XOFF is sent (XON / XOFF).
+**          
+*/
+void UART_StoreRxChar(char ch)
+{
+    uint16_t ich = ichRxWR & (UART_RXBUFSIZE - 1);
+    rgchRx[ich] = ch;
+    if(ich < cchRxMax)
+    {
+        rgchRx[ich + UART_RXBUFSIZE] = ch;
+    }
+    ichRxWR++;
+    if(bFlow != UART_FLOW_NONE && !fRxStopped && UART_RXBUFSIZE - (uint16_t)(ichRxWR - ichRxRD) < UART_RXSTOP_ROOM)
+    {
+        fRxStopped = 1;
+        rxStats.cntFlowStops++;
+        if(bFlow == UART_FLOW_XONXOFF)
+        {
+            chTxPriority = UART_XOFF;
+            HAL_UartTxStart();
+        }
+        else
+        {
+            HAL_UartRxEnable(0);
+        }
+    }
+}
+
+/***	UART_ResumeRx
+**
+**	Parameters:
+**		
+**
+**	Return Value:
+**		
+**
+**	Description:
+**		This function resumes the sender stopped by the flow control: it releases the RX interrupt (RTS / CTS) 
+**      or sends XON (XON / XOFF). It is called by UART_ReleaseLine and UART_SetFlowControl.
+**          
+*/
+void UART_ResumeRx()
+{
+    fRxStopped = 0;
+    if(bFlow == UART_FLOW_XONXOFF)
+    {
+        chTxPriority = UART_XON;
+        HAL_UartTxStart();
+    }
+    else
+    {
+        HAL_UartRxEnable(1);
+    }
 }
 
 
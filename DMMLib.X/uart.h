@@ -22,11 +22,78 @@
 #ifndef _UART_H    /* Guard against multiple inclusion */
 #define _UART_H
 
+#include "stdint.h"
+
 #define	cchRxMax 0x40	// maximum number of characters a CR+LF terminated string
 
+#ifndef UART_RXBUFSIZE
+#define UART_RXBUFSIZE  256     // receive ring size, a power of 2
+#endif
+
+#ifndef UART_TXBUFSIZE
+#define UART_TXBUFSIZE  256     // transmit ring size, a power of 2
+#endif
+
+#define UART_BAUD_DEFAULT       9600
+#define UART_BAUD_MAXERR        25      // maximum baud rate error accepted, per mille
+#ifndef UART_BAUD_TIMEOUT_MS
+#define UART_BAUD_TIMEOUT_MS    5000    // after UART_SetBaud, the initial baud rate is restored when no line is received for this time
+#endif
+
+// transmit policies, applied when the transmit ring has no room for a string
+#define UART_TX_BLOCK   0       // wait until the TX interrupt makes room
+#define UART_TX_DROP    1       // drop the string, its characters are counted (see UART_GetTxDropped)
+
+// flow control modes, see UART_SetFlowControl
+#define UART_FLOW_NONE          0
+#define UART_FLOW_RTSCTS        1       // hardware, U1RTS / U1CTS pins
+#define UART_FLOW_XONXOFF       2       // software, XON / XOFF characters in both directions
+#define UART_XON                0x11
+#define UART_XOFF               0x13
+#define UART_RXSTOP_ROOM        (UART_RXBUFSIZE / 4)    // the flow control stops the sender when the receive ring has less room
+#define UART_RXRESUME_ROOM      (UART_RXBUFSIZE / 2)    // and resumes it when the receive ring has at least this room
+
+// receive errors, see UART_ProcessRxError
+#define UART_RXERR_OVERRUN      1       // the UART receive buffer overflowed, characters were lost
+#define UART_RXERR_FRAMING      2
+#define UART_RXERR_PARITY       4
+
+// receive counters, see UART_GetRxStats
+typedef struct _UART_RXSTATS{
+    uint32_t cntLines;          // received lines
+    uint32_t cntOverruns;       // lines dropped because the receive ring was full
+    uint32_t cntLongLines;      // lines dropped because they exceed cchRxMax - 1 characters
+    uint16_t cchMaxUsed;        // maximum number of characters held by the receive ring
+    uint32_t cntFifoOverruns;   // UART receive buffer overruns
+    uint32_t cntFramingErrors;  // characters received with a framing error
+    uint32_t cntParityErrors;   // characters received with a parity error
+    uint32_t cntFlowStops;      // times the flow control stopped the sender
+} UART_RXSTATS;
+
 void UART_Init(unsigned int baud);
 void UART_PutString(char szData[]);
 uint8_t UART_GetString( char* pchBuff, int cchBuff );
+char *UART_GetLine();
+void UART_ReleaseLine();
+void UART_GetRxStats(UART_RXSTATS *pStats);
+void UART_SetTxPolicy(uint8_t bPolicy);
+uint8_t UART_TxQueue(char const *pData, int cchData, uint8_t bPolicy);
+uint8_t UART_FTxBusy();
+void UART_TxFlush();
+uint32_t UART_GetTxDropped();
+uint32_t UART_GetBaudDivisor(uint32_t baud, uint8_t *pfBrgh, uint16_t *pBrg);
+uint8_t UART_SetBaud(uint32_t baud);
+uint32_t UART_GetBaud();
+uint8_t UART_CheckBaudTimeout();
+void UART_SetFlowControl(uint8_t bMode);
+uint8_t UART_GetFlowControl();
+
+// called by the HAL for each received character
+void UART_ProcessRxChar(uint8_t bVal);
+// called by the HAL for each receive error, instead of UART_ProcessRxChar for the character received with an error
+void UART_ProcessRxError(uint8_t bErrors);
+// called by the HAL (TX interrupt) for each character to transmit
+uint8_t UART_ProcessTxChar(char *pch);
 
 
 
@@ -26,10 +26,9 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
-#include <xc.h>
-#include <sys/attribs.h>
 #include "stdint.h"
 #include "utils.h"
+#include "hal.h"
 /* ************************************************************************** */
 
 /* ------------------------------------------------------------ */
@@ -52,27 +51,12 @@
 **      of microseconds. This delay is not precise.
 **		
 **	Note:
-**		This routine is written with the assumption that the
-**		system clock is 40 MHz.
+**		The delay is implemented by the HAL: a busy loop on PIC32 (written with the assumption 
+**		that the system clock is 40 MHz), the simulated time is advanced on host.
 */
 void DelayAprox10Us( unsigned int  t10usDelay )
 {
-    int j;
-    while ( 0 < t10usDelay )
-    {
-        t10usDelay--;
-        j = 14;
-        while ( 0 < j )
-        {
-            j--;
-        }   // end while 
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-        asm volatile("nop"); // do nothing
-         
-    }   // end while
+    HAL_Delay10Us(t10usDelay);
 }
 /* ------------------------------------------------------------ */
 /***    GetBufferChecksum